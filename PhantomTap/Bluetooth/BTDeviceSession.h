@@ -0,0 +1,104 @@
+//
+//  BTDeviceSession.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/08.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreBluetooth/CoreBluetooth.h>
+
+@class AccessoryInfo;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 單一周邊的連線狀態
+typedef NS_ENUM(NSInteger, BTDeviceState)
+{
+    BTDeviceStateConnecting = 0,
+    BTDeviceStateDiscovering,       // 已連線，正在找 service / characteristic
+    BTDeviceStateReady,             // Write/Notify 特徵值已就緒
+    BTDeviceStateDisconnected,
+};
+
+typedef void(^BTWriteProgressHandler) (NSInteger aSent, NSInteger aTotal);
+typedef void(^BTWriteCompletionHandler) (NSError *_Nullable aError);
+
+/// 寫入失敗時的 error domain
+extern NSString * const BTDeviceSessionErrorDomain;
+
+typedef NS_ENUM(NSInteger, BTDeviceSessionError)
+{
+    BTDeviceSessionErrorNotReady = 1,           // 特徵值尚未找到
+    BTDeviceSessionErrorDisconnected = 2,       // 寫到一半斷線
+    BTDeviceSessionErrorCancelled = 3,
+};
+
+
+/// 一個已連線 (或連線中) 的周邊：自己的特徵值快取、寫入排程與狀態
+/// BTManager 為每個 peripheral 建一個，所有方法都在 central 的 queue (main) 上呼叫
+@interface BTDeviceSession : NSObject
+
+@property (nonatomic, strong, readonly) CBPeripheral *peripheral;
+
+/// 設為 Ready 時會開始推佇列；設為 Disconnected 時會清快取並取消所有未送出的批次
+@property (nonatomic) BTDeviceState state;
+
+/// 最近一次收到的周邊列表 (尚未收到時為空陣列)
+@property (nonatomic, copy) NSArray<AccessoryInfo *> *accessories;
+
+/// 韌體回覆支援變長封包 (DeviceCapabilityCompactFraming) 後由 BTManager 設為 YES；斷線時清回 NO
+/// 為 YES 時 enqueue 的寫入封包會轉成 header 0x85 的變長格式，沒回覆的舊韌體維持固定長度
+@property (nonatomic) BOOL compactFraming;
+
+/// Write Without Response 時，兩個封包間的最小間隔（秒），預設 0.02
+@property (nonatomic) NSTimeInterval frameInterval;
+
+/// Write With Response 失敗時的重送次數，預設 1
+@property (nonatomic) NSInteger maxRetransmits;
+
+- (instancetype)initWithPeripheral:(CBPeripheral *)aPeripheral NS_DESIGNATED_INITIALIZER;
+
+- (NSUUID *)identifier;
+- (NSString *)displayName;
+
+
+#pragma mark - Characteristic cache
+
+- (nullable CBCharacteristic *)characteristicForUUID:(CBUUID *)aUUID;
+- (void)cacheCharacteristic:(CBCharacteristic *)aCharacteristic;
+- (NSDictionary<CBUUID *, CBCharacteristic *> *)cachedCharacteristics;
+- (void)clearCache;
+
+
+#pragma mark - Write scheduler
+
+/// 把一批封包排進這個周邊的寫入佇列，依序送出
+/// 批次之間不會交錯；progress / completion 都在 main queue 回呼
+- (void)enqueueFrames:(NSArray<NSData *> *)aFrames characteristic:(CBUUID *)aCharacteristic withResponse:(BOOL)aWithRsp progress:(nullable BTWriteProgressHandler)aProgress completion:(nullable BTWriteCompletionHandler)aCompletion;
+
+/// 尚未送出的封包數 (所有批次加總)
+- (NSInteger)pendingFrameCount;
+
+/// 取消所有尚未送出的批次，completion 會收到 aError
+- (void)cancelPendingWritesWithError:(NSError *)aError;
+
+
+#pragma mark - Telemetry
+
+/// 收到這台周邊的 B201/B203/B204 資料：記錄收包數，並和同 ID 的 request 配對算 request→reply 延遲
+- (void)noteFrameReceived:(NSData *)aFrame;
+
+
+#pragma mark - CoreBluetooth events (由 BTManager 轉發)
+
+- (void)handleReadyToSendWriteWithoutResponse;
+- (void)handleDidWriteValueForCharacteristic:(CBCharacteristic *)aCharacteristic error:(nullable NSError *)aError;
+
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
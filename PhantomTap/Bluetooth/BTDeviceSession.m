@@ -0,0 +1,375 @@
+//
+//  BTDeviceSession.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/08.
+//
+
+#import "BTDeviceSession.h"
+#import "BTMetrics.h"
+#import "BluetoothPacketBuilder.h"
+
+NSString * const BTDeviceSessionErrorDomain = @"BTDeviceSessionErrorDomain";
+
+static const NSTimeInterval kBTDefaultFrameInterval = 0.02;
+static const NSInteger kBTDefaultMaxRetransmits = 1;
+
+/// request→reply 配對表：(ID, request CMD) 對應鍵盤回覆的 CMD
+/// 同一個 ID 底下的 request 各自配對，巨集寫入完成通知不會被讀取回覆誤配
+typedef struct
+{
+    uint8_t identifier;
+    uint8_t requestCommand;
+    uint8_t replyCommand;
+} BTRequestReplyPair;
+
+static const BTRequestReplyPair kBTRequestReplyPairs[] =
+{
+    { 0x01, 0x01, 0x02 },   // 周邊列表
+    { 0x02, 0x01, 0x02 },   // 讀取巨集內容
+    { 0x02, 0x06, 0x03 },   // 巨集寫入完成 → 結果回報
+    { 0x03, 0x02, 0x02 },   // 讀取按鍵內容
+    { 0x05, 0x02, 0x02 },   // 讀取螢幕設定
+    { 0x06, 0x01, 0x02 },   // 功能查詢
+};
+
+#define kBTPendingRequestSlots (sizeof(kBTRequestReplyPairs) / sizeof(kBTRequestReplyPairs[0]))
+
+
+/// 一次 enqueue 的封包
+@interface BTWriteBatch : NSObject
+
+@property (nonatomic, copy) NSArray<NSData *> *frames;
+@property (nonatomic, copy, nullable) NSArray<NSNumber *> *fixedLengths;   // 轉成變長封包時，原本固定格式的長度
+@property (nonatomic, strong) CBUUID *characteristicUUID;
+@property (nonatomic) BOOL withResponse;
+@property (nonatomic) NSInteger nextIndex;
+@property (nonatomic) NSInteger retransmits;    // 目前這包已重送幾次
+@property (nonatomic, copy, nullable) BTWriteProgressHandler progress;
+@property (nonatomic, copy, nullable) BTWriteCompletionHandler completion;
+
+@end
+
+@implementation BTWriteBatch
+@end
+
+
+@interface BTDeviceSession()
+{
+    NSMutableDictionary<CBUUID *, CBCharacteristic *> *_charCache;
+    NSMutableArray<BTWriteBatch *> *_batches;
+    
+    BOOL _frameInFlight;        // 已呼叫 writeValue，等待 ack 或 frameInterval
+    BOOL _waitingForCredit;     // canSendWriteWithoutResponse == NO，等 peripheralIsReady 回呼
+    NSUInteger _pumpGeneration; // 取消時遞增，讓舊的 dispatch_after 失效
+    
+    double _writeStartedMs;     // 目前這包 writeValue 的時間
+    double _pendingRequestMs[kBTPendingRequestSlots];
+}
+
+@end
+
+
+@implementation BTDeviceSession
+
+- (instancetype)initWithPeripheral:(CBPeripheral *)aPeripheral
+{
+    self = [super init];
+    if (self)
+    {
+        _peripheral = aPeripheral;
+        _state = BTDeviceStateConnecting;
+        _accessories = @[];
+        _frameInterval = kBTDefaultFrameInterval;
+        _maxRetransmits = kBTDefaultMaxRetransmits;
+        _charCache = [NSMutableDictionary dictionary];
+        _batches = [NSMutableArray array];
+    }
+    
+    return self;
+}
+
+- (NSUUID *)identifier
+{
+    return [_peripheral identifier];
+}
+
+- (NSString *)displayName
+{
+    return [_peripheral name] ?: [[_peripheral identifier] UUIDString];
+}
+
+- (void)setState:(BTDeviceState)aState
+{
+    _state = aState;
+    
+    if (aState == BTDeviceStateDisconnected)
+    {
+        // 重連後可能是另一版韌體，重新協商
+        _compactFraming = NO;
+        [self clearCache];
+        [self cancelPendingWritesWithError:[NSError errorWithDomain:BTDeviceSessionErrorDomain code:BTDeviceSessionErrorDisconnected userInfo:@{NSLocalizedDescriptionKey: @"周邊已斷線."}]];
+    }
+    else if (aState == BTDeviceStateReady)
+    {
+        [self p_pump];
+    }
+}
+
+
+#pragma mark - Characteristic cache
+
+- (nullable CBCharacteristic *)characteristicForUUID:(CBUUID *)aUUID
+{
+    return _charCache[aUUID];
+}
+
+- (void)cacheCharacteristic:(CBCharacteristic *)aCharacteristic
+{
+    _charCache[[aCharacteristic UUID]] = aCharacteristic;
+}
+
+- (NSDictionary<CBUUID *, CBCharacteristic *> *)cachedCharacteristics
+{
+    return [_charCache copy];
+}
+
+- (void)clearCache
+{
+    [_charCache removeAllObjects];
+}
+
+
+#pragma mark - Write scheduler
+
+- (void)enqueueFrames:(NSArray<NSData *> *)aFrames characteristic:(CBUUID *)aCharacteristic withResponse:(BOOL)aWithRsp progress:(BTWriteProgressHandler)aProgress completion:(BTWriteCompletionHandler)aCompletion
+{
+    BTWriteBatch *batch = [BTWriteBatch new];
+    batch.frames = aFrames ?: @[];
+    if (_compactFraming)
+    {
+        NSMutableArray<NSNumber *> *fixedLengths = [NSMutableArray arrayWithCapacity:[batch.frames count]];
+        for (NSData *frame in batch.frames)
+        {
+            [fixedLengths addObject:@([frame length])];
+        }
+        batch.fixedLengths = fixedLengths;
+        batch.frames = [BluetoothPacketBuilder compactFramesFromFrames:batch.frames];
+    }
+    batch.characteristicUUID = aCharacteristic;
+    batch.withResponse = aWithRsp;
+    batch.nextIndex = 0;
+    batch.progress = aProgress;
+    batch.completion = aCompletion;
+    
+    [_batches addObject:batch];
+    [self p_pump];
+}
+
+- (NSInteger)pendingFrameCount
+{
+    NSInteger total = 0;
+    for (BTWriteBatch *b in _batches)
+    {
+        total += (NSInteger)[[b frames] count] - [b nextIndex];
+    }
+    return total;
+}
+
+- (void)cancelPendingWritesWithError:(NSError *)aError
+{
+    NSArray<BTWriteBatch *> *pending = [_batches copy];
+    [_batches removeAllObjects];
+    
+    _frameInFlight = NO;
+    _waitingForCredit = NO;
+    _pumpGeneration++;
+    
+    for (BTWriteBatch *b in pending)
+    {
+        if (b.completion) b.completion(aError);
+    }
+}
+
+- (void)p_pump
+{
+    if (_frameInFlight || _waitingForCredit) return;
+    
+    BTWriteBatch *batch = [_batches firstObject];
+    if (!batch) return;
+    
+    if ([batch nextIndex] >= (NSInteger)[[batch frames] count])
+    {
+        [self p_finishBatch:batch error:nil];
+        return;
+    }
+    
+    // 還在連線/探索中 → 等 setState:Ready 再推
+    if (_state == BTDeviceStateConnecting || _state == BTDeviceStateDiscovering) return;
+    
+    CBCharacteristic *ch = _charCache[[batch characteristicUUID]];
+    if (_state != BTDeviceStateReady || !ch)
+    {
+        NSError *err = [NSError errorWithDomain:BTDeviceSessionErrorDomain code:BTDeviceSessionErrorNotReady userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"找不到特徵值 %@.", [[batch characteristicUUID] UUIDString]]}];
+        [self p_finishBatch:batch error:err];
+        return;
+    }
+    
+    if (![batch withResponse] && ![_peripheral canSendWriteWithoutResponse])
+    {
+        // 底層 buffer 滿了，等 peripheralIsReadyToSendWriteWithoutResponse:
+        _waitingForCredit = YES;
+        return;
+    }
+    
+    NSData *frame = [batch frames][[batch nextIndex]];
+    CBCharacteristicWriteType type = [batch withResponse] ? CBCharacteristicWriteWithResponse : CBCharacteristicWriteWithoutResponse;
+    
+    NSUInteger fixedLength = [batch fixedLengths] ? [[batch fixedLengths][[batch nextIndex]] unsignedIntegerValue] : [frame length];
+    
+    _frameInFlight = YES;
+    [_peripheral writeValue:frame forCharacteristic:ch type:type];
+    [self p_noteFrameSent:frame fixedLength:fixedLength];
+    
+    if ([batch withResponse])
+    {
+        // 等 didWriteValueForCharacteristic:
+        return;
+    }
+    
+    NSUInteger generation = _pumpGeneration;
+    __weak typeof(self) wself = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_frameInterval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        __strong typeof(wself) self = wself;
+        if (!self || self -> _pumpGeneration != generation) return;
+        
+        [self p_frameDoneWithError:nil];
+    });
+}
+
+- (void)p_frameDoneWithError:(NSError *)aError
+{
+    _frameInFlight = NO;
+    
+    BTWriteBatch *batch = [_batches firstObject];
+    if (!batch) return;
+    
+    if (aError && [batch withResponse] && [batch retransmits] < _maxRetransmits)
+    {
+        NSData *frame = [batch frames][[batch nextIndex]];
+        batch.retransmits += 1;
+        if ([frame length] >= 3)
+        {
+            const uint8_t *b = [frame bytes];
+            [[BTMetrics shared] recordRetransmitWithIdentifier:b[1] command:b[2]];
+        }
+        NSLog(@"[BLE] %@ write error (%@), retransmit %ld", [self displayName], aError.localizedDescription, (long)[batch retransmits]);
+        
+        [self p_pump];
+        return;
+    }
+    
+    if (aError)
+    {
+        [self p_finishBatch:batch error:aError];
+        return;
+    }
+    
+    batch.nextIndex += 1;
+    batch.retransmits = 0;
+    if (batch.progress) batch.progress([batch nextIndex], (NSInteger)[[batch frames] count]);
+    
+    [self p_pump];
+}
+
+- (void)p_finishBatch:(BTWriteBatch *)aBatch error:(NSError *)aError
+{
+    [_batches removeObject:aBatch];
+    
+    if (aBatch.completion) aBatch.completion(aError);
+    
+    [self p_pump];
+}
+
+
+#pragma mark - Telemetry
+
+- (void)p_noteFrameSent:(NSData *)aFrame fixedLength:(NSUInteger)aFixedLength
+{
+    _writeStartedMs = [BTMetrics nowMs];
+    [[BTMetrics shared] recordFrameSent:aFrame];
+    
+    if ([aFrame length] < 3) return;
+    const uint8_t *b = [aFrame bytes];
+    [[BTMetrics shared] recordFramingFixedBytes:aFixedLength wireBytes:[aFrame length] identifier:b[1] command:b[2]];
+    
+    for (NSUInteger i = 0; i < kBTPendingRequestSlots; i++)
+    {
+        if (kBTRequestReplyPairs[i].identifier == b[1] && kBTRequestReplyPairs[i].requestCommand == b[2])
+        {
+            _pendingRequestMs[i] = _writeStartedMs;
+            break;
+        }
+    }
+}
+
+- (void)noteFrameReceived:(NSData *)aFrame
+{
+    [[BTMetrics shared] recordFrameReceived:aFrame];
+    
+    if ([aFrame length] < 3) return;
+    const uint8_t *b = [aFrame bytes];
+    
+    // 只有 to app 的回覆 (0x06 / 0x00) 才配對
+    if (!(b[0] == 0x06 || b[0] == 0x00)) return;
+    for (NSUInteger i = 0; i < kBTPendingRequestSlots; i++)
+    {
+        const BTRequestReplyPair *pair = &kBTRequestReplyPairs[i];
+        if (pair->identifier != b[1] || pair->replyCommand != b[2] || _pendingRequestMs[i] <= 0) continue;
+        
+        double latency = [BTMetrics nowMs] - _pendingRequestMs[i];
+        [[BTMetrics shared] recordRequestToReplyMs:latency identifier:pair->identifier command:pair->requestCommand];
+        _pendingRequestMs[i] = 0;
+        return;
+    }
+}
+
+
+#pragma mark - CoreBluetooth events
+
+- (void)handleReadyToSendWriteWithoutResponse
+{
+    if (!_waitingForCredit) return;
+    
+    _waitingForCredit = NO;
+    [self p_pump];
+}
+
+- (void)handleDidWriteValueForCharacteristic:(CBCharacteristic *)aCharacteristic error:(NSError *)aError
+{
+    BTWriteBatch *batch = [_batches firstObject];
+    if (!_frameInFlight || !batch || ![batch withResponse]) return;
+    if (![[aCharacteristic UUID] isEqual:[batch characteristicUUID]]) return;
+    
+    NSData *frame = [batch frames][[batch nextIndex]];
+    if ([frame length] >= 3)
+    {
+        const uint8_t *b = [frame bytes];
+        [[BTMetrics shared] recordWriteToAckMs:([BTMetrics nowMs] - _writeStartedMs) identifier:b[1] command:b[2]];
+    }
+    
+    [self p_frameDoneWithError:aError];
+}
+
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<BTDeviceSession %@ state=%ld compact=%d chars=%lu pending=%ld>",
+            [self displayName],
+            (long)self.state,
+            self.compactFraming,
+            (unsigned long)_charCache.count,
+            (long)[self pendingFrameCount]];
+}
+
+@end
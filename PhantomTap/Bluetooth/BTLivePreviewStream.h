@@ -0,0 +1,39 @@
+//
+//  BTLivePreviewStream.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/18.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 拖曳時即時把單顆按鍵的 key mapping 封包送到鍵盤 (live preview)
+///
+/// - 每個 keyIndex 只保留最新的一包 (latest-wins)，被取代的位置在送上 link 前就丟掉
+/// - 以 maxFramesPerSecond 為上限，每個 tick 最多送一包；多顆按鍵同時變動時輪流送
+/// - 任一台周邊的寫入佇列還有東西 (例如正在整份寫入) 就先不送，避免把 BLE 塞爆
+///
+/// 所有 method 都在 main thread 呼叫
+@interface BTLivePreviewStream : NSObject
+
+/// 寫入頻率上限，預設 30 (約 33 ms 一包)
+@property (nonatomic) NSUInteger maxFramesPerSecond;
+
+/// 統計：實際送出 / 被新位置取代而丟掉的封包數
+@property (nonatomic, readonly) NSUInteger sentFrames;
+@property (nonatomic, readonly) NSUInteger droppedFrames;
+
+/// 送出一顆按鍵的最新封包 (會取代同一顆尚未送出的舊封包)
+- (void)submitFrame:(NSData *)aFrame forKeyIndex:(NSInteger)aKeyIndex;
+
+/// 還沒送出的按鍵數
+- (NSUInteger)pendingCount;
+
+/// 丟掉所有尚未送出的封包並停止排程
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
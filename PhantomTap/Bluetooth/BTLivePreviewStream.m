@@ -0,0 +1,137 @@
+//
+//  BTLivePreviewStream.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/18.
+//
+
+#import "BTLivePreviewStream.h"
+#import "BTManager.h"
+#import "BTMetrics.h"
+
+@interface BTLivePreviewStream ()
+{
+    NSMutableDictionary<NSNumber *, NSData *> *_pending;        // keyIndex → 最新封包
+    NSMutableArray<NSNumber *> *_order;                         // 送出順序 (先變動的先送)
+
+    BOOL _tickScheduled;
+    double _lastSendMs;
+}
+
+@property (nonatomic, readwrite) NSUInteger sentFrames;
+@property (nonatomic, readwrite) NSUInteger droppedFrames;
+
+@end
+
+@implementation BTLivePreviewStream
+
+- (instancetype)init
+{
+    self = [super init];
+    if (!self) return nil;
+
+    _maxFramesPerSecond = 30;
+    _pending = [NSMutableDictionary dictionary];
+    _order = [NSMutableArray array];
+    _lastSendMs = 0;
+
+    return self;
+}
+
+
+#pragma mark - Public
+
+- (void)submitFrame:(NSData *)aFrame forKeyIndex:(NSInteger)aKeyIndex
+{
+    NSNumber *key = @(aKeyIndex);
+
+    if (self -> _pending[key])
+    {
+        // 舊位置還沒送出就被取代 → 直接丟掉，維持原本的排隊位置
+        self.droppedFrames++;
+    }
+    else
+    {
+        [self -> _order addObject:key];
+    }
+    self -> _pending[key] = aFrame;
+
+    [self p_scheduleTick];
+}
+
+- (NSUInteger)pendingCount
+{
+    return [self -> _order count];
+}
+
+- (void)cancel
+{
+    self.droppedFrames += [self -> _order count];
+    [self -> _pending removeAllObjects];
+    [self -> _order removeAllObjects];
+}
+
+
+#pragma mark - Pump
+
+- (double)p_intervalMs
+{
+    return 1000.0 / (double)MAX(self -> _maxFramesPerSecond, (NSUInteger)1);
+}
+
+- (void)p_scheduleTick
+{
+    if (self -> _tickScheduled || [self -> _order count] == 0) return;
+    self -> _tickScheduled = YES;
+
+    double wait = MAX(0.0, self -> _lastSendMs + [self p_intervalMs] - [BTMetrics nowMs]);
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(wait * NSEC_PER_MSEC)), dispatch_get_main_queue(), ^{
+        __strong typeof(weakSelf) strongSelf = weakSelf;
+        if (!strongSelf) return;
+        strongSelf -> _tickScheduled = NO;
+        [strongSelf p_tick];
+    });
+}
+
+- (void)p_tick
+{
+    if ([self -> _order count] == 0) return;
+
+    NSArray<BTDeviceSession *> *targets = [[BTManager shared] readySessions];
+    if ([targets count] == 0)
+    {
+        // 沒有裝置就不用排著了
+        [self cancel];
+        return;
+    }
+
+    // link 還在消化其他寫入時，先等下一個 tick；期間的新位置會繼續覆蓋 pending
+    for (BTDeviceSession *s in targets)
+    {
+        if ([s pendingFrameCount] > 0)
+        {
+            self -> _lastSendMs = [BTMetrics nowMs];
+            [self p_scheduleTick];
+            return;
+        }
+    }
+
+    NSNumber *key = [self -> _order firstObject];
+    [self -> _order removeObjectAtIndex:0];
+    NSData *frame = self -> _pending[key];
+    [self -> _pending removeObjectForKey:key];
+
+    for (BTDeviceSession *s in targets)
+    {
+        [[BTManager shared] write:frame toPeripheral:[s peripheral] characteristic:[BTManager Write_Characteristic_UUID] withResponse:NO];
+    }
+
+    self.sentFrames++;
+    self -> _lastSendMs = [BTMetrics nowMs];
+
+    [self p_scheduleTick];
+}
+
+@end
@@ -8,6 +8,9 @@
 #import <Foundation/Foundation.h>
 #import <CoreBluetooth/CoreBluetooth.h>
 #import "GlobalConfig.h"
+#import "BTDeviceSession.h"
+
+@class AccessoryInfo;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -17,6 +20,28 @@ typedef void(^BTConnectHandler) (CBPeripheral *aPeripheral, NSError *_Nullable a
 typedef void(^BTReadyHandler) (void);
 typedef void(^BTDataHandler) (NSData *aData);
 
+typedef void(^BTDeviceReadyHandler) (BTDeviceSession *aSession);
+typedef void(^BTDeviceDataHandler) (BTDeviceSession *aSession, NSData *aData);
+typedef void(^BTDeviceDisconnectHandler) (BTDeviceSession *aSession, NSError *_Nullable aError);
+typedef void(^BTAccessoriesHandler) (BTDeviceSession *aSession, NSArray<AccessoryInfo *> *aAccessories);
+
+
+/// fan-out 寫入時，單一周邊的結果
+@interface BTFanOutResult : NSObject
+
+@property (nonatomic, strong, readonly) NSUUID *identifier;
+@property (nonatomic, copy, readonly) NSString *name;
+@property (nonatomic, readonly) NSInteger sentFrames;
+@property (nonatomic, readonly) NSInteger totalFrames;
+@property (nonatomic, strong, readonly, nullable) NSError *error;
+
+- (BOOL)isSuccess;
+
+@end
+
+typedef void(^BTFanOutProgressHandler) (BTDeviceSession *aSession, NSInteger aSent, NSInteger aTotal);
+typedef void(^BTFanOutCompletionHandler) (NSArray<BTFanOutResult *> *aResults);
+
 
 @interface BTManager : NSObject <CBCentralManagerDelegate, CBPeripheralDelegate>
 
@@ -26,6 +51,12 @@ typedef void(^BTDataHandler) (NSData *aData);
 @property (nonatomic, copy, nullable) BTReadyHandler onReady;
 @property (nonatomic, copy, nullable) BTDataHandler onData;
 
+// 多裝置用：帶出是哪一個周邊
+@property (nonatomic, copy, nullable) BTDeviceReadyHandler onDeviceReady;
+@property (nonatomic, copy, nullable) BTDeviceDataHandler onDeviceData;
+@property (nonatomic, copy, nullable) BTDeviceDisconnectHandler onDeviceDisconnect;
+@property (nonatomic, copy, nullable) BTAccessoriesHandler onAccessories;
+
 @property (nonatomic, strong, nullable) CBUUID *pendingReadUUID;
 
 + (CBUUID *)CCCD;
@@ -38,17 +69,51 @@ typedef void(^BTDataHandler) (NSData *aData);
 + (CBUUID *)Battery_Service_UUID;
 + (CBUUID *)Batter_Level_Characteristic_UUID;
 
++ (CBUUID *)Device_Info_Service_UUID;
++ (CBUUID *)Model_Number_Characteristic_UUID;
++ (CBUUID *)Firmware_Revision_Characteristic_UUID;
+
 + (instancetype)shared;
 
 - (CBCentralManager *)getCentral;
-- (CBPeripheral *)getConnected;
+
+/// 主要裝置：最後一次 connectTo: 的周邊 (若已斷線則改用任一個仍在線的)
+- (nullable CBPeripheral *)getConnected;
 
 - (void)startScanWithNameSubstring:(NSString *)aSubstring timeout:(NSTimeInterval)aTimeout;
 - (void)stopScan;
 - (void)connectTo:(CBPeripheral *)aPeripheral;
-- (void)disconnect;
+- (void)disconnect;   // 全部斷線
+- (void)disconnectPeripheral:(CBPeripheral *)aPeripheral;
+
+
+#pragma mark - Multi-device
+
+/// 所有連線中 / 已連線的周邊
+- (NSArray<BTDeviceSession *> *)sessions;
+/// 只含 Write 特徵值已就緒的周邊
+- (NSArray<BTDeviceSession *> *)readySessions;
+- (nullable BTDeviceSession *)sessionForPeripheral:(CBPeripheral *)aPeripheral;
+
+/// 寫到指定周邊 (走該周邊的寫入佇列)
+/// 只是排進佇列，實際寫出在前面的封包送完之後；不會立即呼叫 writeValue:
+- (void)write:(NSData *)aData toPeripheral:(CBPeripheral *)aPeripheral characteristic:(CBUUID *)aCharacteristic withResponse:(BOOL)aWithRsp;
+
+/// 要求指定周邊回傳周邊列表，結果經由 onAccessories 回呼
+- (void)requestAccessoriesForSession:(BTDeviceSession *)aSession;
+
+/// 查詢指定周邊的韌體功能；回覆支援變長封包時把該 session 的 compactFraming 打開
+/// 沒有回覆 (舊韌體) 時維持固定長度的封包
+- (void)requestCapabilitiesForSession:(BTDeviceSession *)aSession;
+
+/// 把同一組封包平行寫到所有已就緒的周邊 (B202, without response)
+/// 每個周邊各自排程；progress 每送出一包回呼一次，全部結束後 completion 一次
+- (void)fanOutFrames:(NSArray<NSData *> *)aFrames progress:(nullable BTFanOutProgressHandler)aProgress completion:(nullable BTFanOutCompletionHandler)aCompletion;
+
 
 - (void)enableNotifyForService:(CBUUID *)aService characteristic:(CBUUID *)aCharacteristic notify:(BOOL)aEnable;
+/// 舊的單裝置介面，寫到主要裝置
+/// 跟 -write:toPeripheral:... 一樣排進主要裝置的寫入佇列，不再直接寫出
 - (void)write:(NSData *)aData toService:(CBUUID *)aService characteristic:(CBUUID *)aCharacteristic withResponse:(BOOL)aWithRsp;
 
 - (void)readB201;
@@ -57,6 +122,10 @@ typedef void(^BTDataHandler) (NSData *aData);
 - (void)readBatteryLevelOnce;
 - (void)setBatteryNotification:(BOOL)aEnabled;
 
+/// 讀取所有已連線周邊的 RSSI，結果記錄到 BTMetrics
+/// 有周邊就緒時會每 5 秒自動呼叫一次，全部斷線後停止
+- (void)readRSSIForAllDevices;
+
 
 - (void)logCachedCharacteristics;
 
@@ -6,15 +6,55 @@
 //
 
 #import "BTManager.h"
+#import "BluetoothPacketBuilder.h"
+#import "BluetoothPacketParser.h"
+#import "AccessoryModels.h"
+#import "DeviceResponse.h"
+#import "BTMetrics.h"
+#import <sys/utsname.h>
+
+/// 已連線周邊的 RSSI 輪詢間隔 (秒)
+static const NSTimeInterval kBTRSSIPollInterval = 5.0;
+
+
+@interface BTFanOutResult()
+
+@property (nonatomic, strong, readwrite) NSUUID *identifier;
+@property (nonatomic, copy, readwrite) NSString *name;
+@property (nonatomic, readwrite) NSInteger sentFrames;
+@property (nonatomic, readwrite) NSInteger totalFrames;
+@property (nonatomic, strong, readwrite, nullable) NSError *error;
+
+@end
+
+@implementation BTFanOutResult
+
+- (BOOL)isSuccess
+{
+    return self.error == nil && self.sentFrames == self.totalFrames;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<FanOut %@ %ld/%ld error=%@>", self.name, (long)self.sentFrames, (long)self.totalFrames, self.error.localizedDescription ?: @"nil"];
+}
+
+@end
+
+
 
 @interface BTManager()
 {
     CBCentralManager *_central;
-    CBPeripheral *_connectedPeripheral;
     
-    // 原本的 NSMutableDictionary<NSString *, CBCharacteristic *> *_charCache;
-    NSMutableDictionary<CBUUID *, CBCharacteristic *> *_charCache;
+    // 每個周邊一個 session (key: peripheral.identifier)，各自有特徵值快取與寫入佇列
+    NSMutableDictionary<NSUUID *, BTDeviceSession *> *_sessions;
+    // 主要裝置：舊的單裝置 API (getConnected / write:toService:...) 都對它操作
+    NSUUID *_primaryIdentifier;
+    
     NSString *_targetNameSubstring;
+    
+    dispatch_source_t _rssiTimer;
 }
 
 @end
@@ -38,7 +78,9 @@
     if (self)
     {
         _central = [[CBCentralManager alloc] initWithDelegate:self queue:dispatch_get_main_queue()];
-        _charCache = [NSMutableDictionary dictionary];
+        _sessions = [NSMutableDictionary dictionary];
+        
+        [self p_recordHostContext];
     }
     
     return self;
@@ -80,6 +122,22 @@
     return [CBUUID UUIDWithString:@"00002A19-0000-1000-8000-00805F9B34FB"];
 }
 
+/// 180A
++ (CBUUID *)Device_Info_Service_UUID
+{
+    return [CBUUID UUIDWithString:@"0000180A-0000-1000-8000-00805F9B34FB"];
+}
+/// 2A24
++ (CBUUID *)Model_Number_Characteristic_UUID
+{
+    return [CBUUID UUIDWithString:@"00002A24-0000-1000-8000-00805F9B34FB"];
+}
+/// 2A26
++ (CBUUID *)Firmware_Revision_Characteristic_UUID
+{
+    return [CBUUID UUIDWithString:@"00002A26-0000-1000-8000-00805F9B34FB"];
+}
+
 
 
 #pragma mark - Public
@@ -91,7 +149,16 @@
 
 - (CBPeripheral *)getConnected
 {
-    return _connectedPeripheral;
+    return [[self p_primarySession] peripheral];
+}
+
+- (BTDeviceSession *)p_primarySession
+{
+    BTDeviceSession *primary = _primaryIdentifier ? _sessions[_primaryIdentifier] : nil;
+    if (primary) return primary;
+    
+    // 主要裝置已斷線 → 改用任一個已就緒的
+    return [[self readySessions] firstObject];
 }
 
 
@@ -117,16 +184,121 @@
 
 - (void)connectTo:(CBPeripheral *)aPeripheral
 {
-    _connectedPeripheral = aPeripheral;
+    BTDeviceSession *session = _sessions[[aPeripheral identifier]];
+    if (!session)
+    {
+        session = [[BTDeviceSession alloc] initWithPeripheral:aPeripheral];
+        _sessions[[aPeripheral identifier]] = session;
+    }
+    [session setState:BTDeviceStateConnecting];
+    _primaryIdentifier = [aPeripheral identifier];
+    
     [aPeripheral setDelegate:self];
     [_central connectPeripheral:aPeripheral options:nil];
 }
 
 - (void)disconnect
 {
-    if (_connectedPeripheral)
+    for (BTDeviceSession *s in [_sessions allValues])
+    {
+        [_central cancelPeripheralConnection:[s peripheral]];
+    }
+}
+
+- (void)disconnectPeripheral:(CBPeripheral *)aPeripheral
+{
+    if (_sessions[[aPeripheral identifier]])
+    {
+        [_central cancelPeripheralConnection:aPeripheral];
+    }
+}
+
+
+
+#pragma mark - Multi-device
+
+- (NSArray<BTDeviceSession *> *)sessions
+{
+    return [_sessions allValues];
+}
+
+- (NSArray<BTDeviceSession *> *)readySessions
+{
+    NSMutableArray<BTDeviceSession *> *ready = [NSMutableArray array];
+    for (BTDeviceSession *s in [_sessions allValues])
+    {
+        if ([s state] == BTDeviceStateReady) [ready addObject:s];
+    }
+    return ready;
+}
+
+- (nullable BTDeviceSession *)sessionForPeripheral:(CBPeripheral *)aPeripheral
+{
+    return _sessions[[aPeripheral identifier]];
+}
+
+- (void)write:(NSData *)aData toPeripheral:(CBPeripheral *)aPeripheral characteristic:(CBUUID *)aCharacteristic withResponse:(BOOL)aWithRsp
+{
+    BTDeviceSession *session = _sessions[[aPeripheral identifier]];
+    if (!session)
     {
-        [_central cancelPeripheralConnection:_connectedPeripheral];
+        NSLog(@"[BLE] write fail: %@ has no session", [aPeripheral name]);
+        return;
+    }
+    
+    [session enqueueFrames:@[aData] characteristic:aCharacteristic withResponse:aWithRsp progress:nil completion:^(NSError * _Nullable aError) {
+        if (aError) NSLog(@"[BLE] write to %@ fail: %@", [session displayName], aError.localizedDescription);
+    }];
+}
+
+- (void)requestAccessoriesForSession:(BTDeviceSession *)aSession
+{
+    NSData *pkt = [BluetoothPacketBuilder buildRequestAccessoriesList];
+    [self write:pkt toPeripheral:[aSession peripheral] characteristic:[BTManager Write_Characteristic_UUID] withResponse:NO];
+    NSLog(@"[BLE] request accessories -> %@", [aSession displayName]);
+}
+
+- (void)requestCapabilitiesForSession:(BTDeviceSession *)aSession
+{
+    NSData *pkt = [BluetoothPacketBuilder buildCapabilityQueryPacket];
+    [self write:pkt toPeripheral:[aSession peripheral] characteristic:[BTManager Write_Characteristic_UUID] withResponse:NO];
+    NSLog(@"[BLE] query capabilities -> %@", [aSession displayName]);
+}
+
+- (void)fanOutFrames:(NSArray<NSData *> *)aFrames progress:(BTFanOutProgressHandler)aProgress completion:(BTFanOutCompletionHandler)aCompletion
+{
+    NSArray<BTDeviceSession *> *targets = [self readySessions];
+    if ([targets count] == 0)
+    {
+        if (aCompletion) aCompletion(@[]);
+        return;
+    }
+    
+    NSMutableArray<BTFanOutResult *> *results = [NSMutableArray arrayWithCapacity:[targets count]];
+    __block NSInteger remaining = (NSInteger)[targets count];
+    
+    for (BTDeviceSession *session in targets)
+    {
+        BTFanOutResult *result = [BTFanOutResult new];
+        result.identifier = [session identifier];
+        result.name = [session displayName];
+        result.totalFrames = (NSInteger)[aFrames count];
+        [results addObject:result];
+        
+        // 各周邊的佇列各自推進，所以實際上是平行寫入
+        [session enqueueFrames:aFrames characteristic:[BTManager Write_Characteristic_UUID] withResponse:NO progress:^(NSInteger aSent, NSInteger aTotal) {
+            result.sentFrames = aSent;
+            if (aProgress) aProgress(session, aSent, aTotal);
+        } completion:^(NSError * _Nullable aError) {
+            result.error = aError;
+            NSLog(@"[BLE] fan-out done: %@", result);
+            
+            remaining -= 1;
+            if (remaining == 0 && aCompletion)
+            {
+                aCompletion([results copy]);
+            }
+        }];
     }
 }
 
@@ -134,25 +306,25 @@
 
 - (void)enableNotifyForService:(CBUUID *)aService characteristic:(CBUUID *)aCharacteristic notify:(BOOL)aEnable
 {
-    CBCharacteristic *ch = _charCache[aCharacteristic];
+    BTDeviceSession *session = [self p_primarySession];
+    CBCharacteristic *ch = [session characteristicForUUID:aCharacteristic];
     if (!ch)
     {
         return;
     }
     
-    [_connectedPeripheral setNotifyValue:aEnable forCharacteristic:ch];
+    [[session peripheral] setNotifyValue:aEnable forCharacteristic:ch];
 }
 
 - (void)write:(NSData *)aData toService:(CBUUID *)aService characteristic:(CBUUID *)aCharacteristic withResponse:(BOOL)aWithRsp
 {
-    CBCharacteristic *ch = _charCache[aCharacteristic];
-    if (!ch || !_connectedPeripheral)
+    BTDeviceSession *session = [self p_primarySession];
+    if (![session characteristicForUUID:aCharacteristic])
     {
         return;
     }
     
-    CBCharacteristicWriteType type = aWithRsp ? CBCharacteristicWriteWithResponse : CBCharacteristicWriteWithoutResponse;
-    [_connectedPeripheral writeValue:aData forCharacteristic:ch type:type];
+    [self write:aData toPeripheral:[session peripheral] characteristic:aCharacteristic withResponse:aWithRsp];
 }
 
 
@@ -162,9 +334,9 @@
 }
 
 
-- (CBService *)p_serviceForUUID:(CBUUID *)aUUID
+- (CBService *)p_serviceForUUID:(CBUUID *)aUUID inPeripheral:(CBPeripheral *)aPeripheral
 {
-    for (CBService *s in [_connectedPeripheral services] ?: @[])
+    for (CBService *s in [aPeripheral services] ?: @[])
     {
         if ([[s UUID] isEqual:aUUID]) return s;
     }
@@ -173,45 +345,48 @@
 
 - (void)readFromService:(CBUUID *)aService characteristic:(CBUUID *)aCharacteristic
 {
-    if (!_connectedPeripheral)
+    BTDeviceSession *session = [self p_primarySession];
+    CBPeripheral *peripheral = [session peripheral];
+    if (!peripheral)
     {
         NSLog(@"[BLE] read fail: no connected peripheral");
         return;
     }
     
-    CBCharacteristic *ch = _charCache[aCharacteristic];
+    CBCharacteristic *ch = [session characteristicForUUID:aCharacteristic];
     if (!ch)
     {
         // 還沒快取到 → 試著先確保 service/characteristic 存在
-        CBService *svc = [self p_serviceForUUID:aService];
+        CBService *svc = [self p_serviceForUUID:aService inPeripheral:peripheral];
         if (!svc)
         {
             // 還沒有 service，先 discover，再等回呼
             NSLog(@"[BLE] read defer: service %@ not discovered yet, discovering…", [aService UUIDString]);
             _pendingReadUUID = aCharacteristic;
-            [_connectedPeripheral discoverServices:@[aService]];
+            [peripheral discoverServices:@[aService]];
             return;
         }
         // 有 service，可能沒那顆 char，discover 一下該顆
         NSLog(@"[BLE] read defer: characteristic %@ not in cache, discovering…", [aCharacteristic UUIDString]);
         _pendingReadUUID = aCharacteristic;
-        [_connectedPeripheral discoverCharacteristics:@[aCharacteristic] forService:svc];
+        [peripheral discoverCharacteristics:@[aCharacteristic] forService:svc];
         return;
     }
     
-    [_connectedPeripheral readValueForCharacteristic:ch];
+    [peripheral readValueForCharacteristic:ch];
     NSLog(@"[BLE] read request -> %@", [aCharacteristic UUIDString]);
 }
 
 
 - (void)readBatteryLevelOnce
 {
-    CBCharacteristic *c = _charCache[[BTManager Batter_Level_Characteristic_UUID]];
+    BTDeviceSession *session = [self p_primarySession];
+    CBCharacteristic *c = [session characteristicForUUID:[BTManager Batter_Level_Characteristic_UUID]];
     
-    if (c && _connectedPeripheral)
+    if (c)
     {
         NSLog(@"[BTManager] ⚡️ readBatteryLevelOnce() -> readValue");
-        [_connectedPeripheral readValueForCharacteristic:c];
+        [[session peripheral] readValueForCharacteristic:c];
     }
     else
     {
@@ -221,12 +396,13 @@
 
 - (void)setBatteryNotification:(BOOL)aEnabled
 {
-    CBCharacteristic *c = _charCache[[BTManager Batter_Level_Characteristic_UUID]];
+    BTDeviceSession *session = [self p_primarySession];
+    CBCharacteristic *c = [session characteristicForUUID:[BTManager Batter_Level_Characteristic_UUID]];
     
-    if (c && _connectedPeripheral)
+    if (c)
     {
         NSLog(@"[BTManager] 🔔 enableBatteryLevelNotification(%@) -> setNotify", aEnabled ? @"true" : @"false");
-        [_connectedPeripheral setNotifyValue:aEnabled forCharacteristic:c];
+        [[session peripheral] setNotifyValue:aEnabled forCharacteristic:c];
     }
     else
     {
@@ -235,12 +411,49 @@
 }
 
 
+- (void)p_startRSSIPolling
+{
+    if (_rssiTimer) return;
+    
+    __weak typeof(self) wself = self;
+    _rssiTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    dispatch_source_set_timer(_rssiTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kBTRSSIPollInterval * NSEC_PER_SEC)), (uint64_t)(kBTRSSIPollInterval * NSEC_PER_SEC), (uint64_t)(NSEC_PER_SEC / 2));
+    dispatch_source_set_event_handler(_rssiTimer, ^{
+        [wself readRSSIForAllDevices];
+    });
+    dispatch_resume(_rssiTimer);
+}
+
+- (void)p_stopRSSIPollingIfIdle
+{
+    if (!_rssiTimer || [_sessions count] > 0) return;
+    
+    dispatch_source_cancel(_rssiTimer);
+    _rssiTimer = nil;
+}
+
+- (void)readRSSIForAllDevices
+{
+    for (BTDeviceSession *session in [_sessions allValues])
+    {
+        if ([[session peripheral] state] == CBPeripheralStateConnected)
+        {
+            [[session peripheral] readRSSI];
+        }
+    }
+}
+
+
 - (void)logCachedCharacteristics
 {
-    NSLog(@"[BLE] cached %lu chars:", (unsigned long)_charCache.count);
-    [_charCache enumerateKeysAndObjectsUsingBlock:^(CBUUID *key, CBCharacteristic *obj, BOOL *stop) {
-        NSLog(@"   • %@ props=0x%lx", key, (unsigned long)obj.properties);
-    }];
+    for (BTDeviceSession *session in [_sessions allValues])
+    {
+        NSDictionary<CBUUID *, CBCharacteristic *> *cache = [session cachedCharacteristics];
+        NSLog(@"[BLE] %@ cached %lu chars:", [session displayName], (unsigned long)cache.count);
+        [cache enumerateKeysAndObjectsUsingBlock:^(CBUUID *key, CBCharacteristic *obj, BOOL *stop) {
+            NSLog(@"   • %@ props=0x%lx", key, (unsigned long)obj.properties);
+        }];
+    }
 }
 
 
@@ -270,6 +483,43 @@
 
 
 
+#pragma mark - Metrics context
+
+/// 手機型號 / 系統版本 / App 版本，用來比對不同機型的量測
+- (void)p_recordHostContext
+{
+    struct utsname info;
+    uname(&info);
+    
+    BTMetrics *m = [BTMetrics shared];
+    [m setContextValue:[NSString stringWithUTF8String:info.machine] forKey:@"host.model"];
+    [m setContextValue:[[NSProcessInfo processInfo] operatingSystemVersionString] forKey:@"host.os"];
+    [m setContextValue:[[NSBundle mainBundle] objectForInfoDictionaryKey:@"CFBundleShortVersionString"] forKey:@"host.app_version"];
+}
+
+/// 每台周邊各自一組 key："<identifier>.<field>"，與 link 區塊的 key 相同
+- (NSString *)p_contextKey:(NSString *)aField forSession:(BTDeviceSession *)aSession
+{
+    return [NSString stringWithFormat:@"%@.%@", [[aSession identifier] UUIDString], aField];
+}
+
+- (void)p_recordAccessoriesContext:(NSArray<AccessoryInfo *> *)aAccessories forSession:(BTDeviceSession *)aSession
+{
+    BTMetrics *m = [BTMetrics shared];
+    [m setContextValue:[aSession displayName] forKey:[self p_contextKey:@"name" forSession:aSession]];
+    
+    // 例："mouse slot1 046D:C077"
+    NSMutableArray<NSString *> *list = [NSMutableArray arrayWithCapacity:[aAccessories count]];
+    for (AccessoryInfo *info in aAccessories)
+    {
+        NSString *type = ([info type] == AccessoryTypeMouse) ? @"mouse" : ([info type] == AccessoryTypeKeyboard) ? @"keyboard" : @"unknown";
+        [list addObject:[NSString stringWithFormat:@"%@ slot%ld %04lX:%04lX", type, (long)[info slot], (long)[info vendorId], (long)[info productId]]];
+    }
+    [m setContextValue:[list componentsJoinedByString:@", "] forKey:[self p_contextKey:@"accessories" forSession:aSession]];
+}
+
+
+
 #pragma mark - CBCentralManager Delegate
 
 - (void)centralManagerDidUpdateState:(CBCentralManager *)central
@@ -335,6 +585,12 @@
 {
     NSLog(@"peripheral: %@", peripheral);
     
+    // 只記自己的周邊，掃描到的其他裝置 (手機、手錶...) 不進 BTMetrics
+    if (_sessions[[peripheral identifier]])
+    {
+        [[BTMetrics shared] recordRSSI:[RSSI integerValue] forDevice:[[peripheral identifier] UUIDString]];
+    }
+    
     NSString *name = [peripheral name] ?: @"";
     if ([name length] && [name containsString:_targetNameSubstring])
     {
@@ -350,6 +606,16 @@
 {
     NSLog(@"[BLE-DEBUG] didConnect: %@", [peripheral name]);
     
+    BTDeviceSession *session = _sessions[[peripheral identifier]];
+    if (!session)
+    {
+        // 系統自行重連 / 別處呼叫 connectPeripheral 的情況
+        session = [[BTDeviceSession alloc] initWithPeripheral:peripheral];
+        _sessions[[peripheral identifier]] = session;
+        [peripheral setDelegate:self];
+    }
+    [session setState:BTDeviceStateDiscovering];
+    
     if (self.onConnect)
     {
         self.onConnect(peripheral, nil);
@@ -366,6 +632,12 @@
 - (void)centralManager:(CBCentralManager *)central didFailToConnectPeripheral:(CBPeripheral *)peripheral error:(NSError *)error
 {
     NSLog(@"[BLE-DEBUG] didFailToConnect: %@, error: %@", [peripheral name], error);
+    
+    BTDeviceSession *session = _sessions[[peripheral identifier]];
+    [_sessions removeObjectForKey:[peripheral identifier]];
+    [session setState:BTDeviceStateDisconnected];
+    [self p_stopRSSIPollingIfIdle];
+    
     if (self.onConnect)
     {
         self.onConnect(peripheral, error);
@@ -376,8 +648,18 @@
 - (void)centralManager:(CBCentralManager *)central didDisconnectPeripheral:(CBPeripheral *)peripheral error:(NSError *)error
 {
     NSLog(@"[BLE-DEBUG] didDisconnect: %@, error: %@", [peripheral name], error);
-    _connectedPeripheral = nil;
-    [_charCache removeAllObjects];
+    
+    BTDeviceSession *session = _sessions[[peripheral identifier]];
+    if (!session) return;
+    
+    [_sessions removeObjectForKey:[peripheral identifier]];
+    [session setState:BTDeviceStateDisconnected];
+    [self p_stopRSSIPollingIfIdle];
+    
+    if (self.onDeviceDisconnect)
+    {
+        self.onDeviceDisconnect(session, error);
+    }
 }
 
 
@@ -411,6 +693,10 @@
             NSLog(@"[BTManager] 🔎 發現電池服務 (180F)，掃描特徵值...");
             [peripheral discoverCharacteristics:@[[BTManager Batter_Level_Characteristic_UUID]] forService:svc];
         }
+        else if ([[svc UUID] isEqual:[BTManager Device_Info_Service_UUID]])
+        {
+            [peripheral discoverCharacteristics:@[[BTManager Model_Number_Characteristic_UUID], [BTManager Firmware_Revision_Characteristic_UUID]] forService:svc];
+        }
         else
         {
             NSLog(@"[BLE-DEBUG] Service Mismatch. Expected: %@", [BTManager Custom_Service_UUID]);
@@ -429,13 +715,39 @@
     
     NSLog(@"[BLE-DEBUG] Service %@ has %lu characteristics", [service UUID], (unsigned long)[[service characteristics] count]);
     
+    BTDeviceSession *session = _sessions[[peripheral identifier]];
+    if (!session)
+    {
+        NSLog(@"[BLE-DEBUG] characteristics from unknown peripheral %@, ignore", [peripheral name]);
+        return;
+    }
+    
     for (CBCharacteristic *ch in [service characteristics])
     {
-        _charCache[[ch UUID]] = ch;
+        [session cacheCharacteristic:ch];
         if ([[ch UUID] isEqual:[BTManager Notify_Characteristic_UUID]])
         {
             [peripheral setNotifyValue:YES forCharacteristic:ch];   // 啟用 Notify
         }
+        else if ([[ch UUID] isEqual:[BTManager Model_Number_Characteristic_UUID]] || [[ch UUID] isEqual:[BTManager Firmware_Revision_Characteristic_UUID]])
+        {
+            [peripheral readValueForCharacteristic:ch];             // 型號 / 韌體版本 → BTMetrics context
+        }
+    }
+    
+    // 第一次拿到 Write 特徵值 → 這台就緒
+    if ([session state] != BTDeviceStateReady && [session characteristicForUUID:[BTManager Write_Characteristic_UUID]])
+    {
+        [session setState:BTDeviceStateReady];
+        
+        if (self.onDeviceReady)
+        {
+            self.onDeviceReady(session);
+        }
+        
+        [self requestCapabilitiesForSession:session];
+        [self requestAccessoriesForSession:session];
+        [self p_startRSSIPolling];
     }
     
     if (self.onReady)
@@ -449,8 +761,40 @@
     }
 }
 
+- (void)p_handleResponse:(nullable DeviceResponse *)aResponse forSession:(BTDeviceSession *)aSession
+{
+    switch ([aResponse kind])
+    {
+        case DeviceResponseKindCapabilities:
+        {
+            DeviceCapability caps = [aResponse capabilities];
+            DeviceCapability agreed = caps & [BluetoothPacketBuilder supportedCapabilities];
+            NSLog(@"[BLE] %@ capabilities: 0x%02X (agreed 0x%02X)", [aSession displayName], caps, agreed);
+            [aSession setCompactFraming:(agreed & DeviceCapabilityCompactFraming) != 0];
+            [[BTMetrics shared] setContextValue:[NSString stringWithFormat:@"0x%02X", caps] forKey:[self p_contextKey:@"capabilities" forSession:aSession]];
+            break;
+        }
+        case DeviceResponseKindAccessories:
+        {
+            NSArray<AccessoryInfo *> *accessories = [aResponse accessories];
+            NSLog(@"[BLE] %@ accessories: %@", [aSession displayName], accessories);
+            [aSession setAccessories:accessories];
+            [self p_recordAccessoriesContext:accessories forSession:aSession];
+            if (self.onAccessories)
+            {
+                self.onAccessories(aSession, accessories);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
 - (void)peripheral:(CBPeripheral *)peripheral didUpdateValueForCharacteristic:(CBCharacteristic *)characteristic error:(NSError *)error
 {
+    BTDeviceSession *session = _sessions[[peripheral identifier]];
+    
     if ([[characteristic UUID] isEqual:[BTManager Batter_Level_Characteristic_UUID]])
     {
         if ([[characteristic value] length] > 0)
@@ -458,13 +802,67 @@
             const uint8_t *val = [[characteristic value] bytes];
             uint8_t level = val[0];
             NSLog(@"[BTManager] 🔋 收到電量: %d%%", level);
+            [[BTMetrics shared] recordBatteryLevel:level forDevice:[[peripheral identifier] UUIDString]];
+        }
+    }
+    
+    if (!session || ![characteristic value]) return;
+    
+    if ([[characteristic UUID] isEqual:[BTManager Model_Number_Characteristic_UUID]] || [[characteristic UUID] isEqual:[BTManager Firmware_Revision_Characteristic_UUID]])
+    {
+        NSString *value = [[NSString alloc] initWithData:[characteristic value] encoding:NSUTF8StringEncoding];
+        NSString *field = [[characteristic UUID] isEqual:[BTManager Model_Number_Characteristic_UUID]] ? @"model" : @"firmware";
+        [[BTMetrics shared] setContextValue:value forKey:[self p_contextKey:field forSession:session]];
+        NSLog(@"[BLE] %@ %@: %@", [session displayName], field, value);
+        return;
+    }
+    
+    if ([[[characteristic service] UUID] isEqual:[BTManager Custom_Service_UUID]])
+    {
+        [session noteFrameReceived:[characteristic value]];
+        
+        if (![BluetoothPacketParser isWellFormedFrame:[characteristic value]])
+        {
+            [[BTMetrics shared] recordParserError];
+        }
+        else
+        {
+            // 依 ID/CMD 分派，只有功能查詢 / 周邊列表的回覆才更新連線狀態
+            [self p_handleResponse:[BluetoothPacketParser parse:[characteristic value]] forSession:session];
         }
     }
     
-    if (self.onData)
+    if (self.onDeviceData)
+    {
+        self.onDeviceData(session, [characteristic value]);
+    }
+    
+    // 舊的單裝置回呼只收主要裝置的資料
+    if (self.onData && session == [self p_primarySession])
     {
         self.onData(characteristic.value);
     }
 }
 
+- (void)peripheral:(CBPeripheral *)peripheral didWriteValueForCharacteristic:(CBCharacteristic *)characteristic error:(NSError *)error
+{
+    [_sessions[[peripheral identifier]] handleDidWriteValueForCharacteristic:characteristic error:error];
+}
+
+- (void)peripheralIsReadyToSendWriteWithoutResponse:(CBPeripheral *)peripheral
+{
+    [_sessions[[peripheral identifier]] handleReadyToSendWriteWithoutResponse];
+}
+
+- (void)peripheral:(CBPeripheral *)peripheral didReadRSSI:(NSNumber *)RSSI error:(NSError *)error
+{
+    if (error)
+    {
+        NSLog(@"[BLE-DEBUG] didReadRSSI Error: %@", error);
+        return;
+    }
+    
+    [[BTMetrics shared] recordRSSI:[RSSI integerValue] forDevice:[[peripheral identifier] UUIDString]];
+}
+
 @end
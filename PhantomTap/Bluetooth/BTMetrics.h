@@ -0,0 +1,85 @@
+//
+//  BTMetrics.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/10.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 固定 bucket 的延遲直方圖 (ms)，計數器皆為 atomic，可在任何 thread 記錄
+/// bucket 上界：1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, +inf
+@interface BTLatencyHistogram : NSObject
+
+- (void)recordMilliseconds:(double)aMs;
+
+- (uint64_t)count;
+
+/// 依 bucket 的累計推估百分位 (回傳該 bucket 上界，+inf bucket 回傳最大值)
+- (double)percentile:(double)aP;
+
+/// @{ @"count", @"sum_ms", @"max_ms", @"p50_ms", @"p95_ms", @"buckets": @[ @{ @"le": ..., @"count": ... } ] }
+- (NSDictionary *)snapshot;
+
+- (void)reset;
+
++ (NSArray<NSNumber *> *)bucketUpperBoundsMs;
+
+@end
+
+
+/// App 內的 BLE 量測中心
+/// 記錄：RSSI、電量、每個 (ID, Command) 的收送封包/位元組、
+/// write→ack 與 request→reply 延遲直方圖、重送次數、解析錯誤次數
+@interface BTMetrics : NSObject
+
++ (instancetype)shared;
+
+
+#pragma mark - Link
+
+- (void)recordRSSI:(NSInteger)aRSSI forDevice:(NSString *)aDeviceKey;
+- (void)recordBatteryLevel:(NSInteger)aLevel forDevice:(NSString *)aDeviceKey;
+
+
+#pragma mark - Frames (ID / Command 取自封包 Byte 1 / Byte 2)
+
+- (void)recordFrameSent:(NSData *)aFrame;
+- (void)recordFrameReceived:(NSData *)aFrame;
+
+/// write (with response) 到 didWriteValue 的時間
+- (void)recordWriteToAckMs:(double)aMs identifier:(uint8_t)aId command:(uint8_t)aCmd;
+/// 送出 request 到收到同一個 ID 的回覆的時間
+- (void)recordRequestToReplyMs:(double)aMs identifier:(uint8_t)aId command:(uint8_t)aCmd;
+
+/// 只有 Write With Response 失敗才會重送 (Without Response 沒有 ack 可判斷)
+/// 設定檔的 fan-out 走 Without Response，所以這個計數只反映 with-response 的寫入
+- (void)recordRetransmitWithIdentifier:(uint8_t)aId command:(uint8_t)aCmd;
+
+/// 送出的封包若用固定長度格式要幾 bytes (aFixedBytes) / 實際送出幾 bytes (aWireBytes)
+/// 沒有協商到變長封包時兩者相同
+- (void)recordFramingFixedBytes:(NSUInteger)aFixedBytes wireBytes:(NSUInteger)aWireBytes identifier:(uint8_t)aId command:(uint8_t)aCmd;
+- (void)recordParserError;
+
+
+#pragma mark - Snapshot / export
+
+/// 附在 snapshot 裡的環境資訊，用來比對不同韌體 / 機型
+/// BTManager 會填：host.model / host.os / host.app_version，
+/// 以及每台周邊的 <identifier>.model / .firmware (Device Information 180A) / .capabilities / .accessories / .name
+- (void)setContextValue:(nullable NSString *)aValue forKey:(NSString *)aKey;
+
+- (NSDictionary *)snapshot;
+- (nullable NSData *)exportJSONPretty:(BOOL)aPretty error:(NSError **)aError;
+
+/// 計數、延遲分佈、連線品質與 context 一起清空
+- (void)reset;
+
+/// 目前單調時間 (ms)，給延遲量測用
++ (double)nowMs;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,424 @@
+//
+//  BTMetrics.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/10.
+//
+
+#import "BTMetrics.h"
+#import <stdatomic.h>
+#import <os/lock.h>
+#import <time.h>
+
+/// bucket 數 (最後一個是 +inf)
+#define kBTHistogramBuckets 12
+static const double kBTBucketUpperMs[kBTHistogramBuckets - 1] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000 };
+
+/// (ID, Command) 對應的固定 slot：ID 0~7 × CMD 0~15，其餘歸到最後一格
+#define kBTCommandSlots (8 * 16 + 1)
+
+static inline NSUInteger _slotFor(uint8_t aId, uint8_t aCmd)
+{
+    if (aId >= 8 || aCmd >= 16) return kBTCommandSlots - 1;
+    return (NSUInteger)aId * 16 + aCmd;
+}
+
+static inline NSString *_slotName(NSUInteger aSlot)
+{
+    if (aSlot == kBTCommandSlots - 1) return @"other";
+    return [NSString stringWithFormat:@"0x%02lX/0x%02lX", (unsigned long)(aSlot / 16), (unsigned long)(aSlot % 16)];
+}
+
+
+#pragma mark - BTLatencyHistogram
+
+@interface BTLatencyHistogram()
+{
+    _Atomic(uint64_t) _buckets[kBTHistogramBuckets];
+    _Atomic(uint64_t) _count;
+    _Atomic(uint64_t) _sumMicros;
+    _Atomic(uint64_t) _maxMicros;
+}
+
+@end
+
+@implementation BTLatencyHistogram
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        [self reset];
+    }
+    return self;
+}
+
++ (NSArray<NSNumber *> *)bucketUpperBoundsMs
+{
+    NSMutableArray<NSNumber *> *arr = [NSMutableArray arrayWithCapacity:kBTHistogramBuckets - 1];
+    for (int i = 0; i < kBTHistogramBuckets - 1; i++)
+    {
+        [arr addObject:@(kBTBucketUpperMs[i])];
+    }
+    return arr;
+}
+
+- (void)recordMilliseconds:(double)aMs
+{
+    if (aMs < 0) aMs = 0;
+    
+    int idx = kBTHistogramBuckets - 1;
+    for (int i = 0; i < kBTHistogramBuckets - 1; i++)
+    {
+        if (aMs <= kBTBucketUpperMs[i])
+        {
+            idx = i;
+            break;
+        }
+    }
+    
+    uint64_t us = (uint64_t)(aMs * 1000.0);
+    atomic_fetch_add_explicit(&_buckets[idx], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_sumMicros, us, memory_order_relaxed);
+    
+    // max：CAS 直到寫入成功或已有更大的值
+    uint64_t cur = atomic_load_explicit(&_maxMicros, memory_order_relaxed);
+    while (us > cur && !atomic_compare_exchange_weak_explicit(&_maxMicros, &cur, us, memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+- (uint64_t)count
+{
+    return atomic_load_explicit(&_count, memory_order_relaxed);
+}
+
+- (double)percentile:(double)aP
+{
+    uint64_t total = [self count];
+    if (total == 0) return 0;
+    
+    uint64_t rank = (uint64_t)ceil(MAX(0.0, MIN(aP, 1.0)) * (double)total);
+    if (rank == 0) rank = 1;
+    
+    uint64_t acc = 0;
+    for (int i = 0; i < kBTHistogramBuckets; i++)
+    {
+        acc += atomic_load_explicit(&_buckets[i], memory_order_relaxed);
+        if (acc >= rank)
+        {
+            if (i < kBTHistogramBuckets - 1) return kBTBucketUpperMs[i];
+            break;
+        }
+    }
+    return (double)atomic_load_explicit(&_maxMicros, memory_order_relaxed) / 1000.0;
+}
+
+- (NSDictionary *)snapshot
+{
+    NSMutableArray *buckets = [NSMutableArray arrayWithCapacity:kBTHistogramBuckets];
+    for (int i = 0; i < kBTHistogramBuckets; i++)
+    {
+        id le = (i < kBTHistogramBuckets - 1) ? (id)@(kBTBucketUpperMs[i]) : (id)@"+inf";
+        [buckets addObject:@{ @"le": le, @"count": @(atomic_load_explicit(&_buckets[i], memory_order_relaxed)) }];
+    }
+    
+    return @{
+        @"count": @([self count]),
+        @"sum_ms": @((double)atomic_load_explicit(&_sumMicros, memory_order_relaxed) / 1000.0),
+        @"max_ms": @((double)atomic_load_explicit(&_maxMicros, memory_order_relaxed) / 1000.0),
+        @"p50_ms": @([self percentile:0.50]),
+        @"p95_ms": @([self percentile:0.95]),
+        @"buckets": buckets,
+    };
+}
+
+- (void)reset
+{
+    for (int i = 0; i < kBTHistogramBuckets; i++)
+    {
+        atomic_store_explicit(&_buckets[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&_count, 0, memory_order_relaxed);
+    atomic_store_explicit(&_sumMicros, 0, memory_order_relaxed);
+    atomic_store_explicit(&_maxMicros, 0, memory_order_relaxed);
+}
+
+@end
+
+
+
+#pragma mark - BTMetrics
+
+@interface BTMetrics()
+{
+    _Atomic(uint64_t) _framesSent[kBTCommandSlots];
+    _Atomic(uint64_t) _bytesSent[kBTCommandSlots];
+    _Atomic(uint64_t) _framesReceived[kBTCommandSlots];
+    _Atomic(uint64_t) _bytesReceived[kBTCommandSlots];
+    _Atomic(uint64_t) _retransmits[kBTCommandSlots];
+    _Atomic(uint64_t) _framingFixedBytes[kBTCommandSlots];
+    _Atomic(uint64_t) _framingWireBytes[kBTCommandSlots];
+    _Atomic(uint64_t) _parserErrors;
+    
+    NSArray<BTLatencyHistogram *> *_writeToAck;      // 每個 slot 一個
+    NSArray<BTLatencyHistogram *> *_requestToReply;
+    
+    // RSSI / 電量 / context 頻率很低，用 lock 保護 dictionary 即可
+    os_unfair_lock _linkLock;
+    NSMutableDictionary<NSString *, NSMutableDictionary *> *_link;
+    NSMutableDictionary<NSString *, NSString *> *_context;
+    
+    NSDate *_since;
+}
+
+@end
+
+
+@implementation BTMetrics
+
++ (instancetype)shared
+{
+    static BTMetrics *instance;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        instance = [BTMetrics new];
+    });
+    return instance;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self)
+    {
+        NSMutableArray *ack = [NSMutableArray arrayWithCapacity:kBTCommandSlots];
+        NSMutableArray *reply = [NSMutableArray arrayWithCapacity:kBTCommandSlots];
+        for (NSUInteger i = 0; i < kBTCommandSlots; i++)
+        {
+            [ack addObject:[BTLatencyHistogram new]];
+            [reply addObject:[BTLatencyHistogram new]];
+        }
+        _writeToAck = ack;
+        _requestToReply = reply;
+        
+        _linkLock = OS_UNFAIR_LOCK_INIT;
+        _link = [NSMutableDictionary dictionary];
+        _context = [NSMutableDictionary dictionary];
+        
+        [self reset];
+    }
+    return self;
+}
+
++ (double)nowMs
+{
+    return (double)clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / 1e6;
+}
+
+
+#pragma mark - Link
+
+- (NSMutableDictionary *)p_linkEntryForDevice:(NSString *)aDeviceKey
+{
+    NSMutableDictionary *e = _link[aDeviceKey];
+    if (!e)
+    {
+        e = [NSMutableDictionary dictionary];
+        _link[aDeviceKey] = e;
+    }
+    return e;
+}
+
+- (void)recordRSSI:(NSInteger)aRSSI forDevice:(NSString *)aDeviceKey
+{
+    // 127 表示 CoreBluetooth 讀不到
+    if (aRSSI == 127 || [aDeviceKey length] == 0) return;
+    
+    os_unfair_lock_lock(&_linkLock);
+    NSMutableDictionary *e = [self p_linkEntryForDevice:aDeviceKey];
+    NSInteger samples = [e[@"rssi_samples"] integerValue];
+    e[@"rssi_last"] = @(aRSSI);
+    e[@"rssi_min"] = samples ? @(MIN([e[@"rssi_min"] integerValue], aRSSI)) : @(aRSSI);
+    e[@"rssi_max"] = samples ? @(MAX([e[@"rssi_max"] integerValue], aRSSI)) : @(aRSSI);
+    e[@"rssi_sum"] = @([e[@"rssi_sum"] integerValue] + aRSSI);
+    e[@"rssi_samples"] = @(samples + 1);
+    os_unfair_lock_unlock(&_linkLock);
+}
+
+- (void)recordBatteryLevel:(NSInteger)aLevel forDevice:(NSString *)aDeviceKey
+{
+    if ([aDeviceKey length] == 0) return;
+    
+    os_unfair_lock_lock(&_linkLock);
+    NSMutableDictionary *e = [self p_linkEntryForDevice:aDeviceKey];
+    e[@"battery"] = @(aLevel);
+    e[@"battery_at"] = @([[NSDate date] timeIntervalSince1970]);
+    os_unfair_lock_unlock(&_linkLock);
+}
+
+
+#pragma mark - Frames
+
+- (void)recordFrameSent:(NSData *)aFrame
+{
+    if ([aFrame length] < 3) return;
+    const uint8_t *b = [aFrame bytes];
+    NSUInteger slot = _slotFor(b[1], b[2]);
+    
+    atomic_fetch_add_explicit(&_framesSent[slot], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_bytesSent[slot], [aFrame length], memory_order_relaxed);
+}
+
+- (void)recordFrameReceived:(NSData *)aFrame
+{
+    if ([aFrame length] < 3) return;
+    const uint8_t *b = [aFrame bytes];
+    NSUInteger slot = _slotFor(b[1], b[2]);
+    
+    atomic_fetch_add_explicit(&_framesReceived[slot], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_bytesReceived[slot], [aFrame length], memory_order_relaxed);
+}
+
+- (void)recordWriteToAckMs:(double)aMs identifier:(uint8_t)aId command:(uint8_t)aCmd
+{
+    [_writeToAck[_slotFor(aId, aCmd)] recordMilliseconds:aMs];
+}
+
+- (void)recordRequestToReplyMs:(double)aMs identifier:(uint8_t)aId command:(uint8_t)aCmd
+{
+    [_requestToReply[_slotFor(aId, aCmd)] recordMilliseconds:aMs];
+}
+
+- (void)recordRetransmitWithIdentifier:(uint8_t)aId command:(uint8_t)aCmd
+{
+    atomic_fetch_add_explicit(&_retransmits[_slotFor(aId, aCmd)], 1, memory_order_relaxed);
+}
+
+- (void)recordFramingFixedBytes:(NSUInteger)aFixedBytes wireBytes:(NSUInteger)aWireBytes identifier:(uint8_t)aId command:(uint8_t)aCmd
+{
+    NSUInteger slot = _slotFor(aId, aCmd);
+    atomic_fetch_add_explicit(&_framingFixedBytes[slot], aFixedBytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_framingWireBytes[slot], aWireBytes, memory_order_relaxed);
+}
+
+- (void)recordParserError
+{
+    atomic_fetch_add_explicit(&_parserErrors, 1, memory_order_relaxed);
+}
+
+
+#pragma mark - Snapshot / export
+
+- (void)setContextValue:(NSString *)aValue forKey:(NSString *)aKey
+{
+    os_unfair_lock_lock(&_linkLock);
+    _context[aKey] = aValue;
+    os_unfair_lock_unlock(&_linkLock);
+}
+
+- (NSDictionary *)snapshot
+{
+    NSMutableDictionary *commands = [NSMutableDictionary dictionary];
+    NSMutableDictionary *framing = [NSMutableDictionary dictionary];
+    uint64_t totalSent = 0, totalReceived = 0, totalRetransmits = 0;
+    uint64_t totalFixed = 0, totalWire = 0;
+    
+    for (NSUInteger slot = 0; slot < kBTCommandSlots; slot++)
+    {
+        uint64_t fs = atomic_load_explicit(&_framesSent[slot], memory_order_relaxed);
+        uint64_t bs = atomic_load_explicit(&_bytesSent[slot], memory_order_relaxed);
+        uint64_t fr = atomic_load_explicit(&_framesReceived[slot], memory_order_relaxed);
+        uint64_t br = atomic_load_explicit(&_bytesReceived[slot], memory_order_relaxed);
+        uint64_t rt = atomic_load_explicit(&_retransmits[slot], memory_order_relaxed);
+        BTLatencyHistogram *ack = _writeToAck[slot];
+        BTLatencyHistogram *reply = _requestToReply[slot];
+        
+        uint64_t fixed = atomic_load_explicit(&_framingFixedBytes[slot], memory_order_relaxed);
+        uint64_t wire = atomic_load_explicit(&_framingWireBytes[slot], memory_order_relaxed);
+        if (fixed > 0)
+        {
+            totalFixed += fixed;
+            totalWire += wire;
+            framing[_slotName(slot)] = @{ @"fixed_bytes": @(fixed), @"wire_bytes": @(wire) };
+        }
+        
+        // 沒有任何資料的 slot 不輸出
+        if (fs == 0 && fr == 0 && rt == 0 && [ack count] == 0 && [reply count] == 0) continue;
+        
+        totalSent += bs;
+        totalReceived += br;
+        totalRetransmits += rt;
+        
+        commands[_slotName(slot)] = @{
+            @"frames_sent": @(fs),
+            @"bytes_sent": @(bs),
+            @"frames_received": @(fr),
+            @"bytes_received": @(br),
+            @"retransmits": @(rt),
+            @"write_to_ack": [ack snapshot],
+            @"request_to_reply": [reply snapshot],
+        };
+    }
+    
+    os_unfair_lock_lock(&_linkLock);
+    NSMutableDictionary *link = [NSMutableDictionary dictionaryWithCapacity:_link.count];
+    [_link enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSMutableDictionary *obj, BOOL *stop) {
+        link[key] = [obj copy];
+    }];
+    NSDictionary *context = [_context copy];
+    NSDate *since = _since;
+    os_unfair_lock_unlock(&_linkLock);
+    
+    NSTimeInterval elapsed = MAX(0.001, [[NSDate date] timeIntervalSinceDate:since]);
+    
+    return @{
+        @"since": @([since timeIntervalSince1970]),
+        @"elapsed_s": @(elapsed),
+        @"context": context,
+        @"link": link,
+        @"commands": commands,
+        @"bytes_sent": @(totalSent),
+        @"bytes_received": @(totalReceived),
+        @"throughput_sent_Bps": @((double)totalSent / elapsed),
+        @"retransmits": @(totalRetransmits),
+        @"framing": @{
+            @"fixed_bytes": @(totalFixed),
+            @"wire_bytes": @(totalWire),
+            @"saved_ratio": @(totalFixed > 0 ? 1.0 - (double)totalWire / (double)totalFixed : 0.0),
+            @"commands": framing,
+        },
+        @"parser_errors": @(atomic_load_explicit(&_parserErrors, memory_order_relaxed)),
+    };
+}
+
+- (nullable NSData *)exportJSONPretty:(BOOL)aPretty error:(NSError **)aError
+{
+    NSJSONWritingOptions opt = aPretty ? NSJSONWritingPrettyPrinted : 0;
+    return [NSJSONSerialization dataWithJSONObject:[self snapshot] options:opt error:aError];
+}
+
+- (void)reset
+{
+    for (NSUInteger i = 0; i < kBTCommandSlots; i++)
+    {
+        atomic_store_explicit(&_framesSent[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_bytesSent[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_framesReceived[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_bytesReceived[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_retransmits[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_framingFixedBytes[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&_framingWireBytes[i], 0, memory_order_relaxed);
+        [_writeToAck[i] reset];
+        [_requestToReply[i] reset];
+    }
+    atomic_store_explicit(&_parserErrors, 0, memory_order_relaxed);
+    
+    os_unfair_lock_lock(&_linkLock);
+    [_link removeAllObjects];
+    [_context removeAllObjects];
+    _since = [NSDate date];
+    os_unfair_lock_unlock(&_linkLock);
+}
+
+@end
@@ -7,9 +7,18 @@
 
 #import <Foundation/Foundation.h>
 #import "KeymapModels.h"
+#import "KeymapLayout.h"
+#import "DeviceResponse.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+extern NSString * const BluetoothPacketBuilderErrorDomain;
+
+typedef NS_ENUM(NSInteger, BluetoothPacketBuilderError)
+{
+    BluetoothPacketBuilderErrorMacroTooLong = 1,    // 巨集內容封包數超過封包索引上限 (65535)
+};
+
 @interface BluetoothPacketBuilder : NSObject
 
 #pragma mark - Macro Related (ID: 0x02)
@@ -26,6 +35,15 @@ NS_ASSUME_NONNULL_BEGIN
 /// @param aActions 動作列表 (TapAction)，最多 10 筆
 + (NSData *)buildWriteMacroContentPacketWithPacketIndex:(NSInteger)aPacketIndex actions:(NSArray<TapAction *> *)aActions;
 
+/// (5). 寫入巨集內容：以 MacroStep (點擊指定座標, type 0x04) 為單位
+/// @param aPacketIndex 封包索引 (1~65535)
+/// @param aSteps 步驟，最多 10 筆
++ (nullable NSData *)buildWriteMacroContentPacketWithPacketIndex:(NSInteger)aPacketIndex steps:(NSArray<MacroStep *> *)aSteps screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH;
+
+/// 一個完整的巨集：內容封包 (每包 10 步) → 設定觸發鍵 → 通知寫入完成
+/// 步驟多到封包索引超出範圍時回傳 nil (BluetoothPacketBuilderErrorMacroTooLong)
++ (nullable NSArray<NSData *> *)buildMacroFramesWithKeyIndex:(NSInteger)aKeyIndex steps:(NSArray<MacroStep *> *)aSteps isContinuous:(BOOL)aIsContinuous macroName:(NSString *)aMacroName screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError;
+
 /// (6).通知寫入巨集完成 (command :6, to 鍵盤)
 + (NSData *)buildNotifyMacroWriteCompletePacketWithKeyIndex:(NSInteger)aKeyIndex totalActions:(NSInteger)aTotalActions;
 
@@ -42,6 +60,18 @@ NS_ASSUME_NONNULL_BEGIN
 /// aX/aY   : 絕對座標（Short, 小端）
 + (NSData *)buildKeyMappingPacketWithKeyIndex:(NSInteger)aKeyIndex keyCode:(NSInteger)aKeyCode x:(NSInteger)aX y:(NSInteger)aY;
 
+/// 同上，但三個主機區段 (Data3-29) 依 aHostPayloads 填入
+/// aHostPayloads: Android / Windows / iOS 順序；不足 3 筆的部分補 0
+/// 一次寫入就涵蓋所有主機，鍵盤換主機時不需要重新寫入
++ (NSData *)buildKeyMappingPacketWithKeyIndex:(NSInteger)aKeyIndex keyCode:(NSInteger)aKeyCode x:(NSInteger)aX y:(NSInteger)aY hostPayloads:(nullable NSArray<HostPayload *> *)aHostPayloads;
+
+/// 整個 layout 依目前列順序打包成 key mapping 封包 (呼叫前先 validate / sortById)
+/// 座標由 aTransform 換算成螢幕像素；未指定的主機區段為 None (全 0)，沒有 "hosts" 的設定檔與原本的封包相同
++ (NSArray<NSData *> *)buildKeyMappingFramesForLayout:(KeymapLayout *)aLayout transform:(KeymapPixelTransform)aTransform;
+
+/// 單一主機區段 (9 bytes)：Type(1) + Content(8)
++ (NSData *)buildHostSection:(nullable HostPayload *)aPayload;
+
 /// VI. 按鍵設定相關(ID:0x03):
 /// 讀取指定按鍵之內容(command: 2, to 鍵盤)
 + (NSData *)readKeyMappingPacket:(NSInteger)aKeyIndex;
@@ -67,6 +97,32 @@ NS_ASSUME_NONNULL_BEGIN
 + (NSData *)buildRequestAccessoriesList;
 
 
+#pragma mark - Capabilities (ID: 0x06)
+
+/// App 這一端支援的功能 (連線時送給鍵盤)
++ (DeviceCapability)supportedCapabilities;
+
+/// 查詢韌體功能 (Command: 0x01)，Data0 為 App 支援的功能位元
+/// 舊韌體不認得 ID 0x06 不會回覆，App 就維持固定長度的封包
++ (NSData *)buildCapabilityQueryPacket;
+
+
+#pragma mark - Compact framing (header 0x85)
+
+/// 固定長度的寫入封包 → 變長封包 (韌體回報 DeviceCapabilityCompactFraming 後才能送)
+/// LEN 只算實際帶上的欄位：
+///   key mapping (ID 0x03 / CMD 0x01)：KeyIndex, HID, Mod, Flags, X(LE16), Y(LE16), 再接有帶的主機區段
+///     Flags bit0~2 = Android / Windows / iOS 有帶區段，bit3 = 三台共用一個區段，bit7 = 可觸發巨集
+///     沒帶的主機 = None (9 bytes 全 0)；區段 = Head(type | 長度 << 3) + 去掉尾端 0 的 content
+///   巨集內容 (ID 0x02 / CMD 0x05)：PacketIndex(LE16), Count, 只帶 Count 個 slot
+///     slot = Head(type | 長度 << 3 | bit7: delay 為 LE32，否則 LE16) + 去掉尾端 0 的 content + delay
+///   巨集觸發鍵 (ID 0x02 / CMD 0x04)：KeyIndex, Mode, 名稱 (不補 0)
+/// 其他封包 (或無法表示的內容) 原封不動回傳
++ (NSData *)compactFrameFromFrame:(NSData *)aFrame;
+
++ (NSArray<NSData *> *)compactFramesFromFrames:(NSArray<NSData *> *)aFrames;
+
+
 
 @end
 
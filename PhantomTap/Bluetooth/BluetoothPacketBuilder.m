@@ -7,6 +7,8 @@
 
 #import "BluetoothPacketBuilder.h"
 
+NSString * const BluetoothPacketBuilderErrorDomain = @"BluetoothPacketBuilderErrorDomain";
+
 @implementation BluetoothPacketBuilder
 
 #pragma mark - Constants
@@ -15,10 +17,6 @@
 static const uint8_t HEADER_READ_TO_DEVICE = 0x04;
 /** 寫入(to鍵盤) 0x05 */
 static const uint8_t HEADER_WRITE_TO_DEVICE = 0x05;
-/** 通知(to app) 0x06 */
-static const uint8_t HEADER_RESPONSE_FROM_DEVICE = 0x06;
-/** 指示(to app)  0x07*/
-static const uint8_t HEADER_INDICATE_TO_APP = 0x07;
 
 /** 滑鼠配對相關 0x01*/
 static const uint8_t ID_ACCESSORIES = 0x01;
@@ -28,6 +26,8 @@ static const uint8_t ID_MACRO = 0x02;
 static const uint8_t ID_KEY_SETTING = 0x03;
 /** 螢幕校正的 ID 0x05 */
 static const uint8_t ID_CALIBRATION = 0x05;
+/** 裝置資訊 / 功能查詢的 ID 0x06 */
+static const uint8_t ID_DEVICE_INFO = 0x06;
 
 
 /** 寫入按鍵映射的 Command 0x01 */
@@ -35,12 +35,8 @@ static const uint8_t CMD_WRITE_KEY_MAPPING = 0x01;
 /** 回傳周邊 to app 0x02 */
 static const uint8_t CMD_RETURN_TO_APP = 0x02;  // Calibration response / Accesssories req
 
-/** 0x02 */
-static const uint8_t CMD_READ_MACRO_RESPONSE = 0x02;
 /** 0x02 */
 static const uint8_t CMD_READ_KEY_MAPPING = 0x02;
-/** 0x03 */
-static const uint8_t CMD_MACRO_RESULT_RESPONSE = 0x03;
 /** 0x05 */
 static const uint8_t CMD_WRITE_MACRO_CONTENT = 0x05;
 /** 設定巨集觸發鍵的((4).    寫入指定巨集之按鍵 (command :4, to 鍵盤))  0x04  */
@@ -52,9 +48,22 @@ static const uint8_t CMD_WRITE_CALIBRATION = 0x01;
 /** (6).通知寫入巨集完成 (command :6, to 鍵盤)  0x06  */
 static const uint8_t CMD_NOTIFY_MACRO_WRITE_COMPLETE = 0x06;
 
+/** 查詢韌體功能 (to 鍵盤) 0x01 */
+static const uint8_t CMD_QUERY_CAPABILITY = 0x01;
+
 static const uint8_t CHECKSUM_1 = 0x01;
 static const uint8_t CHECKSUM_2 = 0x0F;
 
+/** 變長寫入(to鍵盤) 0x85 = 0x05 | 0x80 */
+static const uint8_t HEADER_WRITE_COMPACT = 0x85;
+/** 變長區段 / slot 的 Head：bit0~2 type，bit3~6 content 長度，bit7 (巨集 slot) delay 為 LE32 */
+static const uint8_t COMPACT_TYPE_MASK = 0x07;
+static const uint8_t COMPACT_LEN_SHIFT = 3;
+static const uint8_t COMPACT_WIDE_DELAY = 0x80;
+/** 變長 key mapping 的 Flags */
+static const uint8_t COMPACT_FLAG_SHARED_HOST = 0x08;
+static const uint8_t COMPACT_FLAG_MACRO = 0x80;
+
 
 #pragma mark - Helpers
 
@@ -84,6 +93,16 @@ static const uint8_t CHECKSUM_2 = 0x0F;
     [aData appendBytes:cs length:2];
 }
 
+/// 去掉尾端 0 之後的長度
++ (NSUInteger)p_trimmedLength:(const uint8_t *)aBytes length:(NSUInteger)aLength
+{
+    while (aLength > 0 && aBytes[aLength - 1] == 0)
+    {
+        aLength--;
+    }
+    return aLength;
+}
+
 + (NSData *)emptyMacroSlot13Bytes
 {
     // type(1) + content(8) + delay(4) = 13 bytes all zero
@@ -208,6 +227,42 @@ static const uint8_t CHECKSUM_2 = 0x0F;
 
 
 
+/**
+ * (5). 寫入巨集內容 helper: 轉換 MacroStep 為 13 bytes Slot
+ * 結構: Type(1)=0x04 + Content(8: click type + X + Y + reserved 3) + Delay(4)
+ */
++ (NSData *)p_convertStepTo13Bytes:(MacroStep *)aStep screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH
+{
+    if (![aStep isKindOfClass:[MacroStep class]])
+    {
+        return [self emptyMacroSlot13Bytes];
+    }
+    
+    NSMutableData *slot = [NSMutableData dataWithCapacity:13];
+    
+    uint8_t actionType = 0x04;   // 點擊指定座標
+    [slot appendBytes:&actionType length:1];
+    
+    uint8_t clickType = (uint8_t)MAX(0, MIN([aStep touch], 2));
+    [slot appendBytes:&clickType length:1];
+    
+    NSInteger screenW = aScreenW > 0 ? aScreenW : 1080;
+    NSInteger screenH = aScreenH > 0 ? aScreenH : 1920;
+    NSInteger absX = MAX(0, MIN([aStep x], screenW - 1));
+    NSInteger absY = MAX(0, MIN([aStep y], screenH - 1));
+    [self appendLittleEndianInt16:(uint16_t)absX into:slot];
+    [self appendLittleEndianInt16:(uint16_t)absY into:slot];
+    
+    uint8_t resv[3] = { 0, 0, 0 };
+    [slot appendBytes:resv length:3];
+    
+    [self appendLittleEndianInt32:(uint32_t)MAX(0, [aStep delayMs]) into:slot];
+    
+    return slot;
+}
+
+
+
 #pragma mark - Public builders
 
 /// (4). 寫入指定巨集之按鍵 (command :4, to 鍵盤)
@@ -311,6 +366,76 @@ static const uint8_t CHECKSUM_2 = 0x0F;
 }
 
 
+/// (5). 寫入巨集內容：以 MacroStep 為單位
++ (nullable NSData *)buildWriteMacroContentPacketWithPacketIndex:(NSInteger)aPacketIndex steps:(NSArray<MacroStep *> *)aSteps screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH
+{
+    if (aPacketIndex < 1 || aPacketIndex > 0xFFFF)
+    {
+        NSLog(@"Error: Packet index out of range.");
+        return nil;
+    }
+    
+    // 總長度 = 4 + 133 + 2 = 139
+    NSMutableData *m = [NSMutableData dataWithCapacity:139];
+    
+    uint8_t hdr = HEADER_WRITE_TO_DEVICE;
+    uint8_t ids = ID_MACRO;
+    uint8_t cmd = CMD_WRITE_MACRO_CONTENT;
+    uint8_t len = 0x85;
+    
+    [m appendBytes:&hdr length:1];
+    [m appendBytes:&ids length:1];
+    [m appendBytes:&cmd length:1];
+    [m appendBytes:&len length:1];
+    
+    [self appendLittleEndianInt16:(uint16_t)aPacketIndex into:m];
+    
+    NSInteger count = MIN([aSteps count], 10);
+    uint8_t countByte = (uint8_t)count;
+    [m appendBytes:&countByte length:1];
+    
+    for (int i = 0; i < 10; i++)
+    {
+        if (i < count)
+        {
+            [m appendData:[self p_convertStepTo13Bytes:aSteps[i] screenW:aScreenW screenH:aScreenH]];
+        }
+        else
+        {
+            [m appendData:[self emptyMacroSlot13Bytes]];
+        }
+    }
+    
+    [self appendChecksumInto:m];
+    return m;
+}
+
+/// 一個完整的巨集：內容封包 (每包 10 步) → 設定觸發鍵 → 通知寫入完成
++ (nullable NSArray<NSData *> *)buildMacroFramesWithKeyIndex:(NSInteger)aKeyIndex steps:(NSArray<MacroStep *> *)aSteps isContinuous:(BOOL)aIsContinuous macroName:(NSString *)aMacroName screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError
+{
+    NSMutableArray<NSData *> *frames = [NSMutableArray array];
+    if ([aSteps count] == 0) return frames;
+    
+    NSInteger packetIndex = 1;
+    for (NSUInteger start = 0; start < [aSteps count]; start += 10)
+    {
+        NSUInteger len = MIN((NSUInteger)10, [aSteps count] - start);
+        NSData *pkt = [self buildWriteMacroContentPacketWithPacketIndex:packetIndex++ steps:[aSteps subarrayWithRange:NSMakeRange(start, len)] screenW:aScreenW screenH:aScreenH];
+        if (!pkt)
+        {
+            if (aError) *aError = [NSError errorWithDomain:BluetoothPacketBuilderErrorDomain code:BluetoothPacketBuilderErrorMacroTooLong userInfo:@{ NSLocalizedDescriptionKey: [NSString stringWithFormat:@"巨集 %@ 有 %lu 個步驟，超過可寫入的上限。", aMacroName, (unsigned long)[aSteps count]] }];
+            return nil;
+        }
+        [frames addObject:pkt];
+    }
+    
+    [frames addObject:[self buildSetMacroTriggerKeyPacket:aKeyIndex isContinuous:aIsContinuous macroName:aMacroName]];
+    [frames addObject:[self buildNotifyMacroWriteCompletePacketWithKeyIndex:aKeyIndex totalActions:[aSteps count]]];
+    
+    return frames;
+}
+
+
 /// (6).通知寫入巨集完成 (command :6, to 鍵盤)
 + (NSData *)buildNotifyMacroWriteCompletePacketWithKeyIndex:(NSInteger)aKeyIndex totalActions:(NSInteger)aTotalActions
 {
@@ -369,6 +494,11 @@ static const uint8_t CHECKSUM_2 = 0x0F;
 /// aKeyCode : HID key code
 /// aX/aY   : 絕對座標（Short, 小端）
 + (NSData *)buildKeyMappingPacketWithKeyIndex:(NSInteger)aKeyIndex keyCode:(NSInteger)aKeyCode x:(NSInteger)aX y:(NSInteger)aY
+{
+    return [self buildKeyMappingPacketWithKeyIndex:aKeyIndex keyCode:aKeyCode x:aX y:aY hostPayloads:nil];
+}
+
++ (NSData *)buildKeyMappingPacketWithKeyIndex:(NSInteger)aKeyIndex keyCode:(NSInteger)aKeyCode x:(NSInteger)aX y:(NSInteger)aY hostPayloads:(nullable NSArray<HostPayload *> *)aHostPayloads
 {
     // 總長 41: H(1)+ID(1)+CMD(1)+LEN(1)+DATA(35)+CS(2)
     NSMutableData *m = [NSMutableData dataWithCapacity:41];
@@ -396,16 +526,12 @@ static const uint8_t CHECKSUM_2 = 0x0F;
     uint8_t isMode = 0x00;
     [m appendBytes:&isMode length:1];
     
-    // Data3-11: Android (reserved 9 bytes)
-    // NSData *mouse = [self p_buildMouseMoveCommandWithDeltaX:aX deltaY:aY leftClick:YES];
-    // [m appendData:mouse];
-    [m appendData:[NSMutableData dataWithLength:9]];
-    
-    // Data12-20: Windows (reserved 9 bytes)
-    [m appendData:[NSMutableData dataWithLength:9]];
-    
-    // Data21-29: iOS (reserved 9 bytes)
-    [m appendData:[NSMutableData dataWithLength:9]];
+    // Data3-11: Android, Data12-20: Windows, Data21-29: iOS (各 9 bytes)，nil = None (全 0)
+    for (NSUInteger os = 0; os < 3; os++)
+    {
+        HostPayload *hp = (os < [aHostPayloads count]) ? aHostPayloads[os] : nil;
+        [m appendData:[self buildHostSection:hp]];
+    }
     
     // Data30: 是否可觸發巨集 (0:不可)
     uint8_t macroFlag = 0x00;
@@ -423,6 +549,44 @@ static const uint8_t CHECKSUM_2 = 0x0F;
 
 
 
++ (NSArray<NSData *> *)buildKeyMappingFramesForLayout:(KeymapLayout *)aLayout transform:(KeymapPixelTransform)aTransform
+{
+    NSUInteger n = [aLayout count];
+    NSMutableArray<NSData *> *frames = [NSMutableArray arrayWithCapacity:n];
+    if (n == 0) return frames;
+    
+    int32_t *xs = malloc(n * sizeof(int32_t));
+    int32_t *ys = malloc(n * sizeof(int32_t));
+    [aLayout pixelCentersWithTransform:aTransform outX:xs outY:ys];
+    
+    const uint8_t *keyIndices = [aLayout keyIndices];
+    const uint8_t *hidCodes = [aLayout hidCodes];
+    const KeymapRowFlags *flags = [aLayout flags];
+    
+    for (NSUInteger row = 0; row < n; row++)
+    {
+        // 沒指定的主機不送動作 (全 0)，跟加 hosts 之前寫出去的封包一樣
+        NSArray<HostPayload *> *hosts = nil;
+        if (flags[row] & KeymapRowFlagHasHosts)
+        {
+            HostPayload *none = [HostPayload none];
+            hosts = @[
+                [aLayout hostPayload:HostOSAndroid atRow:row] ?: none,
+                [aLayout hostPayload:HostOSWindows atRow:row] ?: none,
+                [aLayout hostPayload:HostOSIOS atRow:row] ?: none,
+            ];
+        }
+        
+        uint8_t hid = (hidCodes[row] == KeymapNoCode) ? 0 : hidCodes[row];
+        [frames addObject:[self buildKeyMappingPacketWithKeyIndex:keyIndices[row] keyCode:hid x:xs[row] y:ys[row] hostPayloads:hosts]];
+    }
+    
+    free(xs);
+    free(ys);
+    return frames;
+}
+
+
 /// VI. 按鍵設定相關(ID:0x03):
 /// 讀取指定按鍵之內容(command: 2, to 鍵盤)
 + (NSData *)readKeyMappingPacket:(NSInteger)aKeyIndex
@@ -562,14 +726,213 @@ static const uint8_t CHECKSUM_2 = 0x0F;
 
 
 
+#pragma mark - Capabilities (ID: 0x06)
+
++ (DeviceCapability)supportedCapabilities
+{
+    return DeviceCapabilityCompactFraming;
+}
+
+/// 查詢韌體功能 (Command: 0x01)
++ (NSData *)buildCapabilityQueryPacket
+{
+    // H(1)+ID(1)+Cmd(1)+Len(1)+Data(1)+CS(2) = 7
+    NSMutableData *m = [NSMutableData dataWithCapacity:7];
+    
+    uint8_t hdr = HEADER_READ_TO_DEVICE;
+    uint8_t ids = ID_DEVICE_INFO;
+    uint8_t cmd = CMD_QUERY_CAPABILITY;
+    uint8_t len = 0x01;    // Length = 1 bytes
+    
+    [m appendBytes:&hdr length:1];
+    [m appendBytes:&ids length:1];
+    [m appendBytes:&cmd length:1];
+    [m appendBytes:&len length:1];
+    
+    // Data0: App 支援的功能位元
+    uint8_t caps = [self supportedCapabilities];
+    [m appendBytes:&caps length:1];
+    
+    [self appendChecksumInto:m];
+    
+    return m;
+}
+
+
+#pragma mark - Compact framing (header 0x85)
+
++ (NSData *)compactFrameFromFrame:(NSData *)aFrame
+{
+    const uint8_t *b = [aFrame bytes];
+    NSUInteger n = [aFrame length];
+    if (n < 6 || b[0] != HEADER_WRITE_TO_DEVICE) return aFrame;
+    if (n != 4 + (NSUInteger)b[3] + 2) return aFrame;
+    
+    NSData *data = nil;
+    if (b[1] == ID_KEY_SETTING && b[2] == CMD_WRITE_KEY_MAPPING && b[3] == 0x23)
+    {
+        data = [self p_compactKeyMappingData:b + 4];
+    }
+    else if (b[1] == ID_MACRO && b[2] == CMD_WRITE_MACRO_CONTENT && b[3] == 0x85)
+    {
+        data = [self p_compactMacroContentData:b + 4];
+    }
+    else if (b[1] == ID_MACRO && b[2] == CMD_SET_MACRO_TRIGGER_KEY && b[3] == 0x22)
+    {
+        data = [self p_compactMacroTriggerData:b + 4];
+    }
+    
+    // 沒有比較短就照舊送
+    if (!data || [data length] >= b[3]) return aFrame;
+    
+    NSMutableData *m = [NSMutableData dataWithCapacity:4 + [data length] + 2];
+    uint8_t head[4] = { HEADER_WRITE_COMPACT, b[1], b[2], (uint8_t)[data length] };
+    [m appendBytes:head length:4];
+    [m appendData:data];
+    [self appendChecksumInto:m];
+    
+    return m;
+}
+
++ (NSArray<NSData *> *)compactFramesFromFrames:(NSArray<NSData *> *)aFrames
+{
+    NSMutableArray<NSData *> *frames = [NSMutableArray arrayWithCapacity:[aFrames count]];
+    for (NSData *frame in aFrames)
+    {
+        [frames addObject:[self compactFrameFromFrame:frame]];
+    }
+    return frames;
+}
+
+/// Head(type | 長度 << 3) + 去掉尾端 0 的 content；type 超過 3 bits 時回傳 NO
++ (BOOL)p_appendCompactSection:(const uint8_t *)aSection contentLength:(NSUInteger)aContentLength head:(uint8_t)aExtraHead into:(NSMutableData *)aData
+{
+    if (aSection[0] > COMPACT_TYPE_MASK) return NO;
+    
+    NSUInteger len = [self p_trimmedLength:aSection + 1 length:aContentLength];
+    uint8_t head = (uint8_t)(aSection[0] | (len << COMPACT_LEN_SHIFT) | aExtraHead);
+    [aData appendBytes:&head length:1];
+    [aData appendBytes:aSection + 1 length:len];
+    return YES;
+}
+
+/// aData: 固定格式的 Data0-34
++ (nullable NSData *)p_compactKeyMappingData:(const uint8_t *)aData
+{
+    if (aData[30] > 1) return nil;
+    
+    const uint8_t *hosts[3] = { aData + 3, aData + 12, aData + 21 };
+    
+    // 沒帶區段的主機 = None (全 0，buildKeyMappingFramesForLayout: 未指定主機時的值)
+    static const uint8_t noneSection[9] = { 0 };
+    
+    uint8_t flags = aData[30] ? COMPACT_FLAG_MACRO : 0;
+    NSMutableData *sections = [NSMutableData dataWithCapacity:27];
+    
+    BOOL shared = (memcmp(hosts[0], hosts[1], 9) == 0 && memcmp(hosts[0], hosts[2], 9) == 0);
+    if (shared)
+    {
+        if (memcmp(hosts[0], noneSection, 9) != 0)
+        {
+            flags |= COMPACT_FLAG_SHARED_HOST;
+            if (![self p_appendCompactSection:hosts[0] contentLength:8 head:0 into:sections]) return nil;
+        }
+    }
+    else
+    {
+        for (NSUInteger os = 0; os < 3; os++)
+        {
+            if (memcmp(hosts[os], noneSection, 9) == 0) continue;
+            
+            flags |= (uint8_t)(1 << os);
+            if (![self p_appendCompactSection:hosts[os] contentLength:8 head:0 into:sections]) return nil;
+        }
+    }
+    
+    // KeyIndex, HID, Mod, Flags, X, Y, 區段
+    NSMutableData *m = [NSMutableData dataWithCapacity:8 + [sections length]];
+    [m appendBytes:aData length:3];
+    [m appendBytes:&flags length:1];
+    [m appendBytes:aData + 31 length:4];
+    [m appendData:sections];
+    
+    return m;
+}
+
+/// aData: 固定格式的 Data0-132
++ (nullable NSData *)p_compactMacroContentData:(const uint8_t *)aData
+{
+    NSUInteger count = aData[2];
+    if (count > 10) return nil;
+    
+    NSMutableData *m = [NSMutableData dataWithCapacity:3 + count * 13];
+    [m appendBytes:aData length:3];     // PacketIndex + Count
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        const uint8_t *slot = aData + 3 + i * 13;
+        const uint8_t *d = slot + 9;
+        uint32_t delay = (uint32_t)d[0] | ((uint32_t)d[1] << 8) | ((uint32_t)d[2] << 16) | ((uint32_t)d[3] << 24);
+        BOOL wide = (delay > 0xFFFF);
+        
+        if (![self p_appendCompactSection:slot contentLength:8 head:(wide ? COMPACT_WIDE_DELAY : 0) into:m]) return nil;
+        
+        if (wide)
+        {
+            [self appendLittleEndianInt32:delay into:m];
+        }
+        else
+        {
+            [self appendLittleEndianInt16:(uint16_t)delay into:m];
+        }
+    }
+    
+    return m;
+}
+
+/// aData: 固定格式的 Data0-33
++ (nullable NSData *)p_compactMacroTriggerData:(const uint8_t *)aData
+{
+    NSUInteger nameLen = strnlen((const char *)(aData + 2), 32);
+    
+    NSMutableData *m = [NSMutableData dataWithCapacity:2 + nameLen];
+    [m appendBytes:aData length:2 + nameLen];    // KeyIndex, Mode, 名稱
+    return m;
+}
+
+
+
 #pragma mark - Private payload builders
 
++ (NSData *)buildHostSection:(nullable HostPayload *)aPayload
+{
+    switch ([aPayload type])
+    {
+        case HostPayloadTypeMouse:
+            return [self p_buildMouseCommandWithButtons:[aPayload buttons] deltaX:[aPayload deltaX] deltaY:[aPayload deltaY] wheel:[aPayload wheel]];
+        case HostPayloadTypeKeyboard:
+            return [self p_buildKeyboardPayloadWithModifiers:[aPayload modifiers] hidCode:[aPayload hidCode]];
+        case HostPayloadTypeMultimedia:
+            return [self p_buildMultimediaPayloadWithUsage:[aPayload usage]];
+        case HostPayloadTypeCoordinateTap:
+            return [self p_buildKeyMappingTapPayloadWithX:[aPayload x] y:[aPayload y] touch:[aPayload touch]];
+        case HostPayloadTypeNone:
+            break;
+    }
+    return [NSMutableData dataWithLength:9];
+}
+
 /**
  * VI. 按鍵設定相關(ID:0x03):
  * 1. 寫入指定按鍵之內容(command :1, to 鍵盤)
  * i. 滑鼠指令
  */
 + (NSData *)p_buildMouseMoveCommandWithDeltaX:(NSInteger)aDX deltaY:(NSInteger)aDY leftClick:(BOOL)aIsLeftClick
+{
+    return [self p_buildMouseCommandWithButtons:(aIsLeftClick ? 0b00000001 : 0b00000000) deltaX:aDX deltaY:aDY wheel:0];
+}
+
++ (NSData *)p_buildMouseCommandWithButtons:(uint8_t)aButtons deltaX:(NSInteger)aDX deltaY:(NSInteger)aDY wheel:(NSInteger)aWheel
 {
     NSMutableData *m = [NSMutableData dataWithCapacity:9];
     
@@ -577,8 +940,8 @@ static const uint8_t CHECKSUM_2 = 0x0F;
     uint8_t type = 0x01;
     [m appendBytes:&type length:1];
     
-    // Byte 1: button state
-    uint8_t button = aIsLeftClick ? 0b00000001 : 0b00000000;
+    // Byte 1: button state (bit0 左, bit1 右, bit2 中)
+    uint8_t button = aButtons;
     [m appendBytes:&button length:1];
     
     // Byte 2: X 移動 (signed byte -127..127)
@@ -591,8 +954,8 @@ static const uint8_t CHECKSUM_2 = 0x0F;
     int8_t sy = (int8_t)clampedY;
     [m appendBytes:&sy length:1];
     
-    // Byte 4: 滾輪 (未用)
-    uint8_t wheel = 0x00;
+    // Byte 4: 滾輪 (signed byte)
+    int8_t wheel = (int8_t)MAX(-127, MIN(127, aWheel));
     [m appendBytes:&wheel length:1];
     
     // Byte 5-8: 保留
@@ -608,14 +971,19 @@ static const uint8_t CHECKSUM_2 = 0x0F;
  * iv. 點擊指定座標
  */
 + (NSData *)p_buildKeyMappingTapPayloadWithX:(NSInteger)aX y:(NSInteger)aY
+{
+    return [self p_buildKeyMappingTapPayloadWithX:aX y:aY touch:0x01];
+}
+
++ (NSData *)p_buildKeyMappingTapPayloadWithX:(NSInteger)aX y:(NSInteger)aY touch:(NSInteger)aTouch
 {
     NSMutableData *m = [NSMutableData dataWithCapacity:9];
     
     uint8_t type = 0x04;   // 點擊指定座標
     [m appendBytes:&type length:1];
     
-    uint8_t clickOnce = 0x01;   // 單次點擊
-    [m appendBytes:&clickOnce length:1];
+    uint8_t click = (uint8_t)aTouch;   // 0:不點擊, 1:單次, 2:長按
+    [m appendBytes:&click length:1];
     
     [self appendLittleEndianInt16:(uint16_t)aX into:m];   // X
     [self appendLittleEndianInt16:(uint16_t)aY into:m];   // Y
@@ -626,4 +994,42 @@ static const uint8_t CHECKSUM_2 = 0x0F;
     return m;
 }
 
+/**
+ * VI. 按鍵設定相關(ID:0x03):
+ * 1. 寫入指定按鍵之內容(command :1, to 鍵盤)
+ * ii. 鍵盤指令：content 同 HID boot keyboard report (modifier, reserved, key1 ~ key6)
+ */
++ (NSData *)p_buildKeyboardPayloadWithModifiers:(uint8_t)aModifiers hidCode:(uint8_t)aHidCode
+{
+    NSMutableData *m = [NSMutableData dataWithCapacity:9];
+    
+    uint8_t type = 0x02;   // 鍵盤
+    [m appendBytes:&type length:1];
+    
+    uint8_t report[8] = { aModifiers, 0x00, aHidCode, 0, 0, 0, 0, 0 };
+    [m appendBytes:report length:8];
+    
+    return m;
+}
+
+/**
+ * VI. 按鍵設定相關(ID:0x03):
+ * 1. 寫入指定按鍵之內容(command :1, to 鍵盤)
+ * iii. 多媒體指令：consumer usage (LE short) + 保留 6 bytes
+ */
++ (NSData *)p_buildMultimediaPayloadWithUsage:(uint16_t)aUsage
+{
+    NSMutableData *m = [NSMutableData dataWithCapacity:9];
+    
+    uint8_t type = 0x03;   // 多媒體
+    [m appendBytes:&type length:1];
+    
+    [self appendLittleEndianInt16:aUsage into:m];
+    
+    uint8_t resv[6] = {0, 0, 0, 0, 0, 0};
+    [m appendBytes:resv length:6];
+    
+    return m;
+}
+
 @end
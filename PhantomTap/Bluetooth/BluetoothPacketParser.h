@@ -8,6 +8,9 @@
 #import <Foundation/Foundation.h>
 
 @class DeviceResponse;
+@class AccessoryInfo;
+@class HostPayload;
+@class MacroStep;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -15,8 +18,49 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (nullable DeviceResponse *)parse:(NSData *)aPayload;
 
+/// 基本格式檢查：header 為 0x00/0x06，且長度足夠容納 H+ID+CMD+LEN+DATA(LEN)
++ (BOOL)isWellFormedFrame:(NSData *)aData;
+
+/// 讀回指定按鍵內容 (ID: 0x03, CMD: 0x02)
+/// @{ @"keyIndex", @"hidCode", @"isMod", @"x", @"y", @"macroFlag",
+///    @"android", @"windows", @"ios" (HostPayload) }
 + (nullable NSDictionary *)parseKeyMappingRead:(NSData *)aData;
 
+/// 解析單一主機區段 (9 bytes)；長度不足時回傳 nil，未知 type 視為 None
++ (nullable HostPayload *)parseHostSection:(const uint8_t *)aBytes length:(NSUInteger)aLength;
+
+/// 功能查詢回覆 (ID: 0x06, CMD: 0x02)，Data0 為韌體支援的功能位元 (DeviceCapability)
+/// 不是功能查詢回覆時回傳 nil
++ (nullable NSNumber *)parseCapabilities:(NSData *)aData;
+
+#pragma mark - App → 鍵盤的封包 (header 0x05 / 0x85)，給錄下來的封包流還原用
+
+/// 變長封包 (header 0x85) → 固定長度封包 (header 0x05)，格式見 +[BluetoothPacketBuilder compactFrameFromFrame:]
+/// 不是變長封包時原樣回傳；LEN 與實際長度不符、結尾不是 0x01 0x0F、或區段長度沒有剛好用完 Data 時回傳 nil
++ (nullable NSData *)expandCompactFrame:(NSData *)aFrame;
+
+/// 把連續的封包流依 LEN 切成一個個 frame (H+ID+CMD+LEN+DATA+CS)
+/// 結尾不完整或 checksum 不是 0x01 0x0F 時停在該處，aOutConsumed 回傳已切出的長度
++ (NSArray<NSData *> *)splitFrames:(NSData *)aStream consumed:(nullable NSUInteger *)aOutConsumed;
+
+// 以下三個也接受變長封包 (先還原成固定長度再解析)
+
+/// 寫入按鍵內容 (ID: 0x03, CMD: 0x01)，欄位同 -parseKeyMappingRead:
++ (nullable NSDictionary *)parseKeyMappingWrite:(NSData *)aData;
+
+/// 寫入巨集內容 (ID: 0x02, CMD: 0x05)
+/// @{ @"packetIndex", @"steps" (NSArray<MacroStep *>) }；只還原「點擊指定座標」(type 0x04) 的步驟
++ (nullable NSDictionary *)parseMacroContentWrite:(NSData *)aData;
+
+/// 設定巨集觸發鍵 (ID: 0x02, CMD: 0x04)
+/// @{ @"keyIndex", @"continuous", @"name" }
++ (nullable NSDictionary *)parseMacroTriggerWrite:(NSData *)aData;
+
+/// 周邊列表回覆 (ID: 0x01, CMD: 0x02)
+/// Data0: 筆數 N，之後 N 筆 × 8 bytes (見 AccessoryInfo，格式暫定)
+/// 不是周邊列表封包時回傳 nil；筆數超出實際長度時只回傳完整的筆數
++ (nullable NSArray<AccessoryInfo *> *)parseAccessoriesList:(NSData *)aData;
+
 
 @end
 
@@ -7,22 +7,63 @@
 
 #import "BluetoothPacketParser.h"
 #import "DeviceResponse.h"
+#import "AccessoryModels.h"
+#import "KeymapModels.h"
 // #import "GlobalConfig.h"
 
 // 常數與 Android 版本一致
+static const uint8_t HEADER_WRITE_TO_DEVICE = 0x05;
 static const uint8_t HEADER_RESPONSE_FROM_DEVICE_A = 0x06;
 static const uint8_t HEADER_RESPONSE_FROM_DEVICE_B = 0x00;
 static const uint8_t ID_KEY_SETTING = 0x03;
 static const uint8_t ID_MACRO = 0x02;
+static const uint8_t ID_ACCESSORIES = 0x01;
+static const uint8_t ID_DEVICE_INFO = 0x06;
 
 static const uint8_t CMD_READ_KEYMAPPING_RESPONSE = 0x02;      // 讀取按鍵內容的回覆
-static const uint8_t CMD_MACRO_RESULT_RESPONSE = 0x03;         // 結果回報
+static const uint8_t CMD_ACCESSORIES_RESPONSE = 0x02;          // 回傳周邊列表
+static const uint8_t CMD_CAPABILITY_RESPONSE = 0x02;           // 回傳韌體功能
+
+static const uint8_t CMD_WRITE_KEY_MAPPING = 0x01;
+static const uint8_t CMD_SET_MACRO_TRIGGER_KEY = 0x04;
+static const uint8_t CMD_WRITE_MACRO_CONTENT = 0x05;
+
+static const uint8_t CHECKSUM_1 = 0x01;
+static const uint8_t CHECKSUM_2 = 0x0F;
+
+// 變長封包，與 BluetoothPacketBuilder 一致
+static const uint8_t HEADER_WRITE_COMPACT = 0x85;
+static const uint8_t COMPACT_TYPE_MASK = 0x07;
+static const uint8_t COMPACT_LEN_SHIFT = 3;
+static const uint8_t COMPACT_WIDE_DELAY = 0x80;
+static const uint8_t COMPACT_FLAG_SHARED_HOST = 0x08;
+static const uint8_t COMPACT_FLAG_MACRO = 0x80;
 
 static inline uint16_t le16(const uint8_t *p)
 {
     return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
 }
 
+static inline uint32_t le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/// 讀一個變長區段 (Head + content) 還原成 9 bytes 的 Type + Content
+/// 回傳讀掉的長度，不完整時回傳 0
+static NSUInteger _readCompactSection(const uint8_t *aBytes, NSUInteger aLength, uint8_t *aOut9)
+{
+    if (aLength < 1) return 0;
+    
+    NSUInteger len = (aBytes[0] >> COMPACT_LEN_SHIFT) & 0x0F;
+    if (len > 8 || 1 + len > aLength) return 0;
+    
+    memset(aOut9, 0, 9);
+    aOut9[0] = aBytes[0] & COMPACT_TYPE_MASK;
+    memcpy(aOut9 + 1, aBytes + 1, len);
+    return 1 + len;
+}
+
 // 允許 0x00/0x06 兩種 header
 static inline BOOL _isValidHead(uint8_t aHeader)
 {
@@ -44,7 +85,6 @@ static inline BOOL _isValidHead(uint8_t aHeader)
     uint8_t dataHeader = b[0];
     uint8_t dataID = b[1];
     uint8_t dataCMD = b[2];
-    uint8_t dataLEN = b[3];
     
     // 接受 0x06 或 0x00
     if (!(dataHeader == HEADER_RESPONSE_FROM_DEVICE_A || dataHeader == HEADER_RESPONSE_FROM_DEVICE_B))
@@ -68,17 +108,48 @@ static inline BOOL _isValidHead(uint8_t aHeader)
     }
     
     // --- 解析「讀 KeyMapping」回覆 ---
-    if (dataID == 0x03 && dataCMD == 0x02)
+    if (dataID == ID_KEY_SETTING && dataCMD == CMD_READ_KEYMAPPING_RESPONSE)
     {
-        if (n < 41) return [DeviceResponse errorWithMessage:@"keymapping resp too short"];
+        NSDictionary *km = [self parseKeyMappingRead:aPayload];
+        if (!km) return [DeviceResponse errorWithMessage:@"keymapping resp too short"];
         
-        return [DeviceResponse macroResultWithKeyIndex:0 success:YES];
+        NSArray<HostPayload *> *hosts = @[ km[@"android"], km[@"windows"], km[@"ios"] ];
+        return [DeviceResponse keyMappingWithKeyIndex:[km[@"keyIndex"] integerValue] hid:[km[@"hidCode"] integerValue] x:[km[@"x"] integerValue] y:[km[@"y"] integerValue] hostPayloads:hosts];
+    }
+    
+    // --- 解析「周邊列表」回覆 ---
+    if (dataID == ID_ACCESSORIES && dataCMD == CMD_ACCESSORIES_RESPONSE)
+    {
+        NSArray<AccessoryInfo *> *list = [self parseAccessoriesList:aPayload];
+        if (!list) return [DeviceResponse errorWithMessage:@"accessories resp too short"];
+        
+        return [DeviceResponse accessoriesWithList:list];
+    }
+    
+    // --- 解析「功能查詢」回覆 ---
+    if (dataID == ID_DEVICE_INFO && dataCMD == CMD_CAPABILITY_RESPONSE)
+    {
+        NSNumber *caps = [self parseCapabilities:aPayload];
+        if (!caps) return [DeviceResponse errorWithMessage:@"capability resp too short"];
+        
+        return [DeviceResponse capabilitiesWith:(DeviceCapability)[caps unsignedCharValue]];
     }
     
     return [DeviceResponse errorWithMessage:@"unknown packet"];
 }
 
 
++ (BOOL)isWellFormedFrame:(NSData *)aData
+{
+    const uint8_t *b = [aData bytes];
+    NSUInteger n = [aData length];
+    if (n < 4) return NO;
+    if (!_isValidHead(b[0])) return NO;
+    
+    return n >= 4 + (NSUInteger)b[3];
+}
+
+
 + (nullable NSDictionary *)parseKeyMappingRead:(NSData *)aData
 {
     const uint8_t *b = [aData bytes];
@@ -88,17 +159,28 @@ static inline BOOL _isValidHead(uint8_t aHeader)
     uint8_t dataHeader = b[0];
     uint8_t dataID = b[1];
     uint8_t dataCMD = b[2];
-    uint8_t dataLEN = b[3];
     
     if (!_isValidHead(dataHeader)) return nil;
-    if (dataID != 0x03) return nil;
-    if (dataCMD != 0x02) return nil;
-    // if (dataLEN != 0x23) return nil;
+    if (dataID != ID_KEY_SETTING) return nil;
+    if (dataCMD != CMD_READ_KEYMAPPING_RESPONSE) return nil;
     
+    return [self p_keyMappingFields:b];
+}
+
+/// Data0-34 的欄位 (讀回 / 寫入兩種方向的 layout 相同)
++ (NSDictionary *)p_keyMappingFields:(const uint8_t *)b
+{
     uint8_t keyIndex = b[4];
     uint8_t hidCode = b[5];
     uint8_t isMod = b[6];
     
+    // Data3-11 / Data12-20 / Data21-29: Android / Windows / iOS
+    HostPayload *android = [self parseHostSection:b + 7 length:9];
+    HostPayload *windows = [self parseHostSection:b + 16 length:9];
+    HostPayload *ios = [self parseHostSection:b + 25 length:9];
+    
+    uint8_t macroFlag = b[34];
+    
     // little-endian shorts
     uint16_t x = (uint16_t)b[35] | ((uint16_t)b[36] << 8);
     uint16_t y = (uint16_t)b[37] | ((uint16_t)b[38] << 8);
@@ -109,8 +191,280 @@ static inline BOOL _isValidHead(uint8_t aHeader)
         @"isMod": @(isMod),
         @"x": @(x),
         @"y": @(y),
+        @"macroFlag": @(macroFlag),
+        @"android": android,
+        @"windows": windows,
+        @"ios": ios,
     };
 }
 
 
++ (NSArray<NSData *> *)splitFrames:(NSData *)aStream consumed:(nullable NSUInteger *)aOutConsumed
+{
+    const uint8_t *b = [aStream bytes];
+    NSUInteger n = [aStream length];
+    NSUInteger offset = 0;
+    
+    NSMutableArray<NSData *> *frames = [NSMutableArray array];
+    while (offset + 4 <= n)
+    {
+        NSUInteger frameLen = 4 + (NSUInteger)b[offset + 3] + 2;
+        if (offset + frameLen > n) break;
+        if (b[offset + frameLen - 2] != CHECKSUM_1 || b[offset + frameLen - 1] != CHECKSUM_2) break;
+        
+        [frames addObject:[aStream subdataWithRange:NSMakeRange(offset, frameLen)]];
+        offset += frameLen;
+    }
+    
+    if (aOutConsumed) *aOutConsumed = offset;
+    return frames;
+}
+
++ (nullable NSNumber *)parseCapabilities:(NSData *)aData
+{
+    const uint8_t *b = [aData bytes];
+    NSUInteger n = [aData length];
+    if (n < 5) return nil;
+    
+    if (!_isValidHead(b[0])) return nil;
+    if (b[1] != ID_DEVICE_INFO || b[2] != CMD_CAPABILITY_RESPONSE) return nil;
+    if (b[3] < 1) return nil;
+    
+    return @(b[4]);
+}
+
+
++ (nullable NSData *)expandCompactFrame:(NSData *)aFrame
+{
+    const uint8_t *b = [aFrame bytes];
+    NSUInteger n = [aFrame length];
+    if (n < 4 || b[0] != HEADER_WRITE_COMPACT) return aFrame;
+    
+    // LEN 要剛好等於實際長度、結尾要是 01 0F，跟韌體 (PTFirmwareEmulator) 一樣嚴格
+    NSUInteger dataLen = b[3];
+    if (n != 4 + dataLen + 2) return nil;
+    if (b[n - 2] != CHECKSUM_1 || b[n - 1] != CHECKSUM_2) return nil;
+    const uint8_t *d = b + 4;
+    
+    // 最大的固定封包：巨集內容 4 + 133 + 2
+    uint8_t out[4 + 0x85 + 2] = { 0 };
+    uint8_t *o = out + 4;
+    uint8_t fixedLen = 0;
+    BOOL ok = NO;
+    
+    if (b[1] == ID_KEY_SETTING && b[2] == CMD_WRITE_KEY_MAPPING)
+    {
+        fixedLen = 0x23;
+        ok = [self p_expandKeyMapping:d length:dataLen into:o];
+    }
+    else if (b[1] == ID_MACRO && b[2] == CMD_WRITE_MACRO_CONTENT)
+    {
+        fixedLen = 0x85;
+        ok = [self p_expandMacroContent:d length:dataLen into:o];
+    }
+    else if (b[1] == ID_MACRO && b[2] == CMD_SET_MACRO_TRIGGER_KEY)
+    {
+        // KeyIndex, Mode, 名稱 (最多 32)
+        fixedLen = 0x22;
+        ok = (dataLen >= 2 && dataLen <= 2 + 32);
+        if (ok) memcpy(o, d, dataLen);
+    }
+    if (!ok) return nil;
+    
+    out[0] = HEADER_WRITE_TO_DEVICE;
+    out[1] = b[1];
+    out[2] = b[2];
+    out[3] = fixedLen;
+    out[4 + fixedLen] = CHECKSUM_1;
+    out[4 + fixedLen + 1] = CHECKSUM_2;
+    
+    return [NSData dataWithBytes:out length:4 + fixedLen + 2];
+}
+
+/// KeyIndex, HID, Mod, Flags, X, Y, 區段 → Data0-34 (aOut 要先清成 0)
++ (BOOL)p_expandKeyMapping:(const uint8_t *)aData length:(NSUInteger)aLength into:(uint8_t *)aOut
+{
+    if (aLength < 8) return NO;
+    
+    uint8_t flags = aData[3];
+    memcpy(aOut, aData, 3);
+    aOut[30] = (flags & COMPACT_FLAG_MACRO) ? 0x01 : 0x00;
+    memcpy(aOut + 31, aData + 4, 4);
+    
+    NSUInteger cursor = 8;
+    if (flags & COMPACT_FLAG_SHARED_HOST)
+    {
+        NSUInteger used = _readCompactSection(aData + cursor, aLength - cursor, aOut + 3);
+        if (used == 0) return NO;
+        cursor += used;
+        
+        memcpy(aOut + 12, aOut + 3, 9);
+        memcpy(aOut + 21, aOut + 3, 9);
+    }
+    else
+    {
+        for (NSUInteger os = 0; os < 3; os++)
+        {
+            // 沒帶區段的主機 = None，aOut 已經是 0
+            uint8_t *section = aOut + 3 + os * 9;
+            if (!(flags & (1 << os))) continue;
+            
+            NSUInteger used = _readCompactSection(aData + cursor, aLength - cursor, section);
+            if (used == 0) return NO;
+            cursor += used;
+        }
+    }
+    
+    return cursor == aLength;
+}
+
+/// PacketIndex, Count, slot × Count → Data0-132 (其餘 slot 補 0)
++ (BOOL)p_expandMacroContent:(const uint8_t *)aData length:(NSUInteger)aLength into:(uint8_t *)aOut
+{
+    if (aLength < 3 || aData[2] > 10) return NO;
+    
+    memcpy(aOut, aData, 3);
+    
+    NSUInteger cursor = 3;
+    for (NSUInteger i = 0; i < aData[2]; i++)
+    {
+        uint8_t *slot = aOut + 3 + i * 13;
+        BOOL wide = (cursor < aLength) && (aData[cursor] & COMPACT_WIDE_DELAY);
+        
+        NSUInteger used = _readCompactSection(aData + cursor, aLength - cursor, slot);
+        if (used == 0) return NO;
+        cursor += used;
+        
+        NSUInteger delayLen = wide ? 4 : 2;
+        if (cursor + delayLen > aLength) return NO;
+        memcpy(slot + 9, aData + cursor, delayLen);
+        cursor += delayLen;
+    }
+    
+    return cursor == aLength;
+}
+
+
++ (nullable NSDictionary *)parseKeyMappingWrite:(NSData *)aData
+{
+    aData = [self expandCompactFrame:aData];
+    if (!aData) return nil;
+    
+    const uint8_t *b = [aData bytes];
+    if ([aData length] < 41) return nil;
+    if (b[0] != HEADER_WRITE_TO_DEVICE || b[1] != ID_KEY_SETTING || b[2] != CMD_WRITE_KEY_MAPPING) return nil;
+    
+    return [self p_keyMappingFields:b];
+}
+
++ (nullable NSDictionary *)parseMacroContentWrite:(NSData *)aData
+{
+    aData = [self expandCompactFrame:aData];
+    if (!aData) return nil;
+    
+    const uint8_t *b = [aData bytes];
+    NSUInteger n = [aData length];
+    if (n < 7) return nil;
+    if (b[0] != HEADER_WRITE_TO_DEVICE || b[1] != ID_MACRO || b[2] != CMD_WRITE_MACRO_CONTENT) return nil;
+    
+    // 以 LEN 為準，但不可超過實際收到的長度
+    NSUInteger dataLen = MIN((NSUInteger)b[3], n - 4);
+    const uint8_t *data = b + 4;
+    
+    uint16_t packetIndex = le16(data);
+    NSUInteger count = data[2];
+    
+    // slot: Type(1) + Content(8) + Delay(4)
+    NSMutableArray<MacroStep *> *steps = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        NSUInteger offset = 3 + i * 13;
+        if (offset + 13 > dataLen) break;
+        
+        const uint8_t *slot = data + offset;
+        if (slot[0] != HostPayloadTypeCoordinateTap) continue;
+        
+        [steps addObject:[MacroStep stepWithTouch:(MacroTouch)slot[1] x:le16(slot + 2) y:le16(slot + 4) delayMs:le32(slot + 9)]];
+    }
+    
+    return @{
+        @"packetIndex": @(packetIndex),
+        @"steps": steps,
+    };
+}
+
++ (nullable NSDictionary *)parseMacroTriggerWrite:(NSData *)aData
+{
+    aData = [self expandCompactFrame:aData];
+    if (!aData) return nil;
+    
+    const uint8_t *b = [aData bytes];
+    NSUInteger n = [aData length];
+    if (n < 4 + 34) return nil;
+    if (b[0] != HEADER_WRITE_TO_DEVICE || b[1] != ID_MACRO || b[2] != CMD_SET_MACRO_TRIGGER_KEY) return nil;
+    
+    // Data2-33: 名稱 (ASCII，0 結尾)
+    const char *raw = (const char *)(b + 6);
+    NSString *name = [[NSString alloc] initWithBytes:raw length:strnlen(raw, 32) encoding:NSASCIIStringEncoding] ?: @"";
+    
+    return @{
+        @"keyIndex": @(b[4]),
+        @"continuous": @(b[5] != 0),
+        @"name": name,
+    };
+}
+
+
++ (nullable HostPayload *)parseHostSection:(const uint8_t *)aBytes length:(NSUInteger)aLength
+{
+    if (!aBytes || aLength < 9) return nil;
+    
+    const uint8_t *c = aBytes + 1;      // content 8 bytes
+    switch (aBytes[0])
+    {
+        case HostPayloadTypeMouse:
+            return [HostPayload mouseWithButtons:c[0] deltaX:(int8_t)c[1] deltaY:(int8_t)c[2] wheel:(int8_t)c[3]];
+        case HostPayloadTypeKeyboard:
+            return [HostPayload keyboardWithModifiers:c[0] hidCode:c[2]];
+        case HostPayloadTypeMultimedia:
+            return [HostPayload multimediaWithUsage:le16(c)];
+        case HostPayloadTypeCoordinateTap:
+            return [HostPayload coordinateTapWithX:le16(c + 1) y:le16(c + 3) touch:c[0]];
+        default:
+            return [HostPayload none];
+    }
+}
+
+
++ (nullable NSArray<AccessoryInfo *> *)parseAccessoriesList:(NSData *)aData
+{
+    const uint8_t *b = [aData bytes];
+    NSUInteger n = [aData length];
+    if (n < 5) return nil;
+    
+    if (!_isValidHead(b[0])) return nil;
+    if (b[1] != ID_ACCESSORIES) return nil;
+    if (b[2] != CMD_ACCESSORIES_RESPONSE) return nil;
+    
+    // 以 LEN 為準，但不可超過實際收到的長度
+    NSUInteger dataLen = MIN((NSUInteger)b[3], n - 4);
+    if (dataLen < 1) return nil;
+    
+    const uint8_t *data = b + 4;
+    NSUInteger count = data[0];
+    NSUInteger entryLen = [AccessoryInfo entryLength];
+    
+    NSMutableArray<AccessoryInfo *> *list = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        NSUInteger offset = 1 + i * entryLen;
+        if (offset + entryLen > dataLen) break;
+        
+        AccessoryInfo *info = [AccessoryInfo accessoryFromEntryBytes:data + offset length:entryLen];
+        if (info) [list addObject:info];
+    }
+    
+    return list;
+}
+
 @end
@@ -0,0 +1,46 @@
+//
+//  AccessoryModels.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/08.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 周邊類型 (對應 周邊列表回覆 每筆的 Byte 0)
+typedef NS_ENUM(NSInteger, AccessoryType)
+{
+    AccessoryTypeUnknown = 0,
+    AccessoryTypeMouse = 1,
+    AccessoryTypeKeyboard = 2,
+};
+
+
+/// 周邊列表 (ID: 0x01, CMD: 0x02, to app) 中的一筆
+/// 每筆 8 bytes: type(1) + slot(1) + connected(1) + battery(1) + VID(2, LE) + PID(2, LE)
+/// 暫定格式：協定文件還沒有這個回覆的定義，欄位順序是跟韌體端口頭約定的，定案後要再對一次
+@interface AccessoryInfo : NSObject
+
+@property (nonatomic, readonly) AccessoryType type;
+@property (nonatomic, readonly) NSInteger slot;             // 鍵盤上的配對槽位
+@property (nonatomic, readonly, getter=isConnected) BOOL connected;
+@property (nonatomic, readonly) NSInteger batteryLevel;     // 0~100，0xFF 表示未知 → -1
+@property (nonatomic, readonly) NSInteger vendorId;
+@property (nonatomic, readonly) NSInteger productId;
+
+- (instancetype)initWithType:(AccessoryType)aType slot:(NSInteger)aSlot connected:(BOOL)aConnected batteryLevel:(NSInteger)aBattery vendorId:(NSInteger)aVID productId:(NSInteger)aPID NS_DESIGNATED_INITIALIZER;
+
+/// 從 8 bytes 的 entry 解析，長度不足回傳 nil
++ (nullable instancetype)accessoryFromEntryBytes:(const uint8_t *)aBytes length:(NSUInteger)aLength;
+
+/// 每筆 entry 的長度
++ (NSUInteger)entryLength;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,62 @@
+//
+//  AccessoryModels.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/08.
+//
+
+#import "AccessoryModels.h"
+
+static const NSUInteger kAccessoryEntryLength = 8;
+
+@implementation AccessoryInfo
+
+- (instancetype)initWithType:(AccessoryType)aType slot:(NSInteger)aSlot connected:(BOOL)aConnected batteryLevel:(NSInteger)aBattery vendorId:(NSInteger)aVID productId:(NSInteger)aPID
+{
+    self = [super init];
+    if (self)
+    {
+        _type = aType;
+        _slot = aSlot;
+        _connected = aConnected;
+        _batteryLevel = aBattery;
+        _vendorId = aVID;
+        _productId = aPID;
+    }
+    
+    return self;
+}
+
++ (nullable instancetype)accessoryFromEntryBytes:(const uint8_t *)aBytes length:(NSUInteger)aLength
+{
+    if (aBytes == NULL || aLength < kAccessoryEntryLength) return nil;
+    
+    AccessoryType type = AccessoryTypeUnknown;
+    if (aBytes[0] == 0x01) type = AccessoryTypeMouse;
+    else if (aBytes[0] == 0x02) type = AccessoryTypeKeyboard;
+    
+    NSInteger battery = (aBytes[3] == 0xFF) ? -1 : MIN((NSInteger)aBytes[3], 100);
+    NSInteger vid = (NSInteger)((uint16_t)aBytes[4] | ((uint16_t)aBytes[5] << 8));
+    NSInteger pid = (NSInteger)((uint16_t)aBytes[6] | ((uint16_t)aBytes[7] << 8));
+    
+    return [[self alloc] initWithType:type slot:aBytes[1] connected:(aBytes[2] != 0x00) batteryLevel:battery vendorId:vid productId:pid];
+}
+
++ (NSUInteger)entryLength
+{
+    return kAccessoryEntryLength;
+}
+
+
+- (NSString *)description
+{
+    NSString *typeStr = (self.type == AccessoryTypeMouse) ? @"MOUSE" : (self.type == AccessoryTypeKeyboard) ? @"KEYBOARD" : @"UNKNOWN";
+    return [NSString stringWithFormat:@"<Accessory %@ slot=%ld connected=%@ battery=%ld vid=0x%04lX pid=0x%04lX>",
+            typeStr,
+            (long)self.slot,
+            self.isConnected ? @"YES" : @"NO",
+            (long)self.batteryLevel,
+            (long)self.vendorId, (long)self.productId];
+}
+
+@end
@@ -8,10 +8,20 @@
 #import <Foundation/Foundation.h>
 
 @class TapAction;
+@class AccessoryInfo;
+@class HostPayload;
 
 NS_ASSUME_NONNULL_BEGIN
 
 
+/// 連線時交換的功能位元 (ID=0x06)
+typedef NS_OPTIONS(uint8_t, DeviceCapability)
+{
+    DeviceCapabilityNone = 0,
+    DeviceCapabilityCompactFraming = 1 << 0,    // 看得懂 header 0x85 的變長封包 (不補空 slot / 保留欄位)
+};
+
+
 /// 對應 Kotlin: sealed interface DeviceResponse { MacroContent, MacroResult, Error }
 typedef NS_ENUM(NSInteger, DeviceResponseKind)
 {
@@ -19,6 +29,8 @@ typedef NS_ENUM(NSInteger, DeviceResponseKind)
     DeviceResponseKindMacroContent,         // 之後用
     DeviceResponseKindMacroResult,      // (ID=0x02, CMD=0x03)
     DeviceResponseKindError,
+    DeviceResponseKindAccessories,      // 周邊列表 (ID=0x01, CMD=0x02)
+    DeviceResponseKindCapabilities,     // 功能查詢回覆 (ID=0x06, CMD=0x02)
 };
 
 
@@ -34,6 +46,8 @@ typedef NS_ENUM(NSInteger, DeviceResponseKind)
 @property (nonatomic, readonly) NSInteger hidCode;   // HID key code
 @property (nonatomic, readonly) NSInteger x;
 @property (nonatomic, readonly) NSInteger y;
+/// Android / Windows / iOS 三個主機區段
+@property (nonatomic, copy, readonly, nullable) NSArray<HostPayload *> *hostPayloads;
 
 /// MacroContent 專用：動作清單
 @property (nonatomic, copy, readonly, nullable) NSArray<TapAction *> *actions;
@@ -41,16 +55,28 @@ typedef NS_ENUM(NSInteger, DeviceResponseKind)
 /// MacroResult 專用：是否成功
 @property (nonatomic, readonly) BOOL success;
 
+/// Accessories 專用：周邊列表
+@property (nonatomic, copy, readonly, nullable) NSArray<AccessoryInfo *> *accessories;
+
+/// Capabilities 專用：韌體支援的功能
+@property (nonatomic, readonly) DeviceCapability capabilities;
+
 /// Error 專用：錯誤訊息
 @property (nonatomic, copy, readonly, nullable) NSString *message;
 
 
 + (instancetype)keyMappingWithKeyIndex:(NSInteger)aKeyIndex hid:(NSInteger)aHID x:(NSInteger)aX y:(NSInteger)aY;
 
++ (instancetype)keyMappingWithKeyIndex:(NSInteger)aKeyIndex hid:(NSInteger)aHID x:(NSInteger)aX y:(NSInteger)aY hostPayloads:(NSArray<HostPayload *> *)aHostPayloads;
+
 + (instancetype)macroResultWithKeyIndex:(NSInteger)aKeyIndex success:(BOOL)aOK;
 
 + (instancetype)macroContentWithKeyIndex:(NSInteger)aKeyIndex actions:(NSArray<TapAction *> *)aActions;
 
++ (instancetype)accessoriesWithList:(NSArray<AccessoryInfo *> *)aAccessories;
+
++ (instancetype)capabilitiesWith:(DeviceCapability)aCapabilities;
+
 + (instancetype)errorWithMessage:(NSString *)aMessage;
 
 @end
@@ -6,6 +6,7 @@
 //
 
 #import "DeviceResponse.h"
+#import "AccessoryModels.h"
 
 @interface DeviceResponse()
 
@@ -15,9 +16,12 @@
 @property (nonatomic, readwrite) NSInteger hidCode;
 @property (nonatomic, readwrite) NSInteger x;
 @property (nonatomic, readwrite) NSInteger y;
+@property (nonatomic, copy, readwrite, nullable) NSArray<HostPayload *> *hostPayloads;
 @property (nonatomic, readwrite) BOOL success;
 
 @property (nonatomic, copy, readwrite, nullable) NSArray<TapAction *> *actions;
+@property (nonatomic, copy, readwrite, nullable) NSArray<AccessoryInfo *> *accessories;
+@property (nonatomic, readwrite) DeviceCapability capabilities;
 @property (nonatomic, copy, readwrite, nullable) NSString *message;
 
 @end
@@ -36,6 +40,13 @@
     return r;
 }
 
++ (instancetype)keyMappingWithKeyIndex:(NSInteger)aKeyIndex hid:(NSInteger)aHID x:(NSInteger)aX y:(NSInteger)aY hostPayloads:(NSArray<HostPayload *> *)aHostPayloads
+{
+    DeviceResponse *r = [self keyMappingWithKeyIndex:aKeyIndex hid:aHID x:aX y:aY];
+    r.hostPayloads = aHostPayloads;
+    return r;
+}
+
 + (instancetype)macroResultWithKeyIndex:(NSInteger)aKeyIndex success:(BOOL)aOK
 {
     DeviceResponse *r = [DeviceResponse new];
@@ -54,6 +65,24 @@
     return r;
 }
 
++ (instancetype)accessoriesWithList:(NSArray<AccessoryInfo *> *)aAccessories
+{
+    DeviceResponse *r = [DeviceResponse new];
+    r.kind = DeviceResponseKindAccessories;
+    r.success = YES;
+    r.accessories = [aAccessories copy];
+    return r;
+}
+
++ (instancetype)capabilitiesWith:(DeviceCapability)aCapabilities
+{
+    DeviceResponse *r = [DeviceResponse new];
+    r.kind = DeviceResponseKindCapabilities;
+    r.success = YES;
+    r.capabilities = aCapabilities;
+    return r;
+}
+
 + (instancetype)errorWithMessage:(NSString *)aMessage
 {
     DeviceResponse *r = [DeviceResponse new];
@@ -75,6 +104,12 @@
         case DeviceResponseKindMacroContent:
             return [NSString stringWithFormat:@"<MacroContent idx=%ld actions=%lu>", (long)self.keyIndex, (unsigned long)self.actions.count];
             
+        case DeviceResponseKindAccessories:
+            return [NSString stringWithFormat:@"<Accessories count=%lu>", (unsigned long)self.accessories.count];
+            
+        case DeviceResponseKindCapabilities:
+            return [NSString stringWithFormat:@"<Capabilities 0x%02X>", (unsigned)self.capabilities];
+            
         case DeviceResponseKindError:            
         default:
             return [NSString stringWithFormat:@"<Error message=%@>", self.message ?: @""];
@@ -0,0 +1,142 @@
+//
+//  EditorJournal.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/16.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "KeymapModels.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/// 編輯器上一個項目的狀態 (immutable)
+/// 點擊鍵：origin 為 PhantomTapView 在 contentView 裡的左上角 (points)，與 TapAction.posX / posY 相同
+/// 滑動 / 搖桿：整個 action 存在 gesture，origin 不使用
+@interface EditorEntry : NSObject
+
+@property (nonatomic, readonly) NSInteger actionId;
+@property (nonatomic, readonly) KeymapType type;
+@property (nonatomic, readonly) CGPoint origin;
+@property (nonatomic, copy, readonly) NSString *keyCode;        // 搖桿固定為 @"null" (方向鍵在 gesture 裡)
+
+// 點擊鍵
+@property (nonatomic, copy, readonly) NSString *orientation;    // 預設 "PORTRAIT"
+@property (nonatomic, readonly, getter=isPressEvent) BOOL pressEvent;   // 預設 YES
+@property (nonatomic, strong, readonly, nullable) HostPayload *androidPayload;  // nil = 未指定
+@property (nonatomic, strong, readonly, nullable) HostPayload *windowsPayload;
+@property (nonatomic, strong, readonly, nullable) HostPayload *iosPayload;
+
+/// 滑動 / 搖桿：SwipeAction / JoystickAction 的複本；要放到畫面上編輯時請再 copy 一份
+@property (nonatomic, strong, readonly, nullable) id<KeymapAction> gesture;
+
+/// 只有位置與按鍵的點擊鍵，其他欄位為預設值
++ (instancetype)entryWithId:(NSInteger)aActionId origin:(CGPoint)aOrigin keyCode:(NSString *)aKeyCode;
+/// 點擊鍵：連同方向、按下 / 放開、各主機動作一起記
++ (instancetype)entryWithTapAction:(TapAction *)aAction origin:(CGPoint)aOrigin;
+/// 滑動 / 搖桿：存一份複本
++ (instancetype)entryWithGesture:(id<KeymapAction>)aGesture;
+
+- (nullable HostPayload *)payloadForHost:(HostOS)aHost;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+typedef NS_ENUM(uint8_t, EditorOpKind)
+{
+    EditorOpKindAdd     = 0x02,
+    EditorOpKindDelete  = 0x03,
+    EditorOpKindMove    = 0x04,
+    EditorOpKindSetKey  = 0x05,
+    EditorOpKindReplace = 0x06,     // 清除 / 載入檔案：整批換掉；滑動 / 搖桿的移動與改鍵
+};
+
+
+/// 一筆編輯操作 (immutable)，自帶反向操作需要的資訊
+@interface EditorOp : NSObject
+
+@property (nonatomic, readonly) EditorOpKind kind;
+@property (nonatomic, readonly) NSInteger actionId;             // Add / Delete / Move / SetKey
+
+@property (nonatomic, strong, readonly, nullable) EditorEntry *entry;   // Add / Delete
+@property (nonatomic, readonly) CGPoint fromOrigin;             // Move
+@property (nonatomic, readonly) CGPoint toOrigin;
+@property (nonatomic, copy, readonly, nullable) NSString *fromKey;      // SetKey
+@property (nonatomic, copy, readonly, nullable) NSString *toKey;
+@property (nonatomic, copy, readonly, nullable) NSArray<EditorEntry *> *beforeEntries;  // Replace
+@property (nonatomic, copy, readonly, nullable) NSArray<EditorEntry *> *afterEntries;
+
++ (instancetype)addOpWithEntry:(EditorEntry *)aEntry;
++ (instancetype)deleteOpWithEntry:(EditorEntry *)aEntry;
++ (instancetype)moveOpWithId:(NSInteger)aActionId from:(CGPoint)aFrom to:(CGPoint)aTo;
++ (instancetype)setKeyOpWithId:(NSInteger)aActionId from:(NSString *)aFromKey to:(NSString *)aToKey;
++ (instancetype)replaceOpWithBefore:(NSArray<EditorEntry *> *)aBefore after:(NSArray<EditorEntry *> *)aAfter;
+
+/// 反向操作 (undo 時套用)
+- (EditorOp *)inverse;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+/// 編輯器的 append-only journal
+///
+/// - 每次新增 / 移動 / 刪除 / 指定按鍵都記成一筆小 record，背景 append 到檔案尾端，不重寫整個檔案
+///   (滑動 / 搖桿的編輯以 Replace 記錄整個 action 的前後狀態)
+/// - undo / redo 只移動 cursor (O(1))，檔案裡只多寫一個 1 byte 的 marker
+/// - record 超過門檻時在背景 compact：把超出 undo 深度的操作摺進 base snapshot，寫到暫存檔再 rename
+/// - 開啟時 replay 檔案；尾端寫到一半的 record (crash) 會被截掉，checksum 對但解不開的 record 略過
+///
+/// 所有 public method 都要在 main thread 呼叫
+@interface EditorJournal : NSObject
+
+/// 保留可 undo 的步數，預設 200
+@property (nonatomic) NSUInteger maxUndoDepth;
+/// 檔案裡的 record 數超過這個值就排程 compaction，預設 512
+@property (nonatomic) NSUInteger compactionThreshold;
+
+@property (nonatomic, copy, readonly) NSString *path;
+
+/// 預設位置：Application Support/EditorJournal/current.journal
++ (NSString *)defaultPath;
+
+/// 開啟 (或建立) journal 並 replay 既有內容
+- (instancetype)initWithPath:(NSString *)aPath NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+
+/// 目前狀態 (依 actionId 排序)
+- (NSArray<EditorEntry *> *)currentEntries;
+- (nullable EditorEntry *)entryForId:(NSInteger)aActionId;
+
+
+/// 記錄一筆已經套用到畫面上的操作；會清掉 redo 的部分
+- (void)recordOp:(EditorOp *)aOp;
+
+- (BOOL)canUndo;
+- (BOOL)canRedo;
+
+/// 回傳需要套用到畫面上的操作 (已經是反向後的)，沒有可 undo 時回傳 nil
+- (nullable EditorOp *)undo;
+/// 回傳需要套用到畫面上的操作，沒有可 redo 時回傳 nil
+- (nullable EditorOp *)redo;
+
+
+/// 立即在背景 compact
+- (void)compact;
+
+/// 等背景寫入全部完成 (App 進背景時呼叫)
+- (void)flush;
+
+@end
+
+NS_ASSUME_NONNULL_END
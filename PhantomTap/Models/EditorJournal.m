@@ -0,0 +1,1037 @@
+//
+//  EditorJournal.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/16.
+//
+
+#import "EditorJournal.h"
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ 檔案格式
+ ---------
+ "PTJ2" 之後接連續的 record：
+    [Tag 1B][Len 4B LE][Payload Len B][Check 1B]
+ Check = Tag 與 Payload 全部 XOR，用來判斷尾端是否寫到一半
+
+ Tag:
+    0x01 BASE     u32 count + entries        (只出現在 compact 後的檔頭)
+    0x02 ADD      entry
+    0x03 DELETE   entry
+    0x04 MOVE     i32 id, f32 fromX, fromY, toX, toY
+    0x05 SETKEY   i32 id, str from, str to
+    0x06 REPLACE  u32 count + entries (before), u32 count + entries (after)
+    0x10 UNDO
+    0x11 REDO
+
+ entry = i32 id, f32 x, f32 y, str key, u8 type，之後依 type：
+    0 TAP       u8 flags (bit0 pressEvent), str orientation, host × 3 (Android / Windows / iOS)
+    1 SWIPE     i32 screenW, i32 screenH, u32 count + (f32 x, f32 y, i32 t) × count
+    2 JOYSTICK  i32 screenW, i32 screenH, f32 cx, f32 cy, f32 radius, i32 rampMs, str up, down, left, right
+ host  = u8 type (0xFF = 未指定)，之後依 type：
+    MOUSE       u8 buttons, i8 dx, i8 dy, i8 wheel
+    KEYBOARD    u8 modifiers, u8 hid
+    MULTIMEDIA  u16 usage
+    TAP         i32 x, i32 y, u8 touch
+ str   = u8 length + UTF-8 (最多 255 bytes)
+*/
+
+static const char kJournalMagic[4] = { 'P', 'T', 'J', '2' };
+
+static const uint8_t kHostUnset = 0xFF;
+
+static const uint8_t kTagBase = 0x01;
+static const uint8_t kTagUndo = 0x10;
+static const uint8_t kTagRedo = 0x11;
+
+
+#pragma mark - EditorEntry
+
+@interface EditorEntry ()
+
+- (EditorEntry *)p_entryWithOrigin:(CGPoint)aOrigin;
+- (EditorEntry *)p_entryWithKeyCode:(NSString *)aKeyCode;
+
+@end
+
+@implementation EditorEntry
+
++ (instancetype)p_entryWithId:(NSInteger)aActionId type:(KeymapType)aType
+{
+    EditorEntry *e = [super new];
+    e -> _actionId = aActionId;
+    e -> _type = aType;
+    e -> _keyCode = @"null";
+    e -> _orientation = @"PORTRAIT";
+    e -> _pressEvent = YES;
+    return e;
+}
+
++ (instancetype)entryWithId:(NSInteger)aActionId origin:(CGPoint)aOrigin keyCode:(NSString *)aKeyCode
+{
+    EditorEntry *e = [self p_entryWithId:aActionId type:KeymapTypePhantomTap];
+    e -> _origin = aOrigin;
+    e -> _keyCode = [([aKeyCode length] ? aKeyCode : @"null") copy];
+    return e;
+}
+
++ (instancetype)entryWithTapAction:(TapAction *)aAction origin:(CGPoint)aOrigin
+{
+    EditorEntry *e = [self entryWithId:[aAction actionId] origin:aOrigin keyCode:[aAction keyCode]];
+    e -> _orientation = [([[aAction orientation] length] ? [aAction orientation] : @"PORTRAIT") copy];
+    e -> _pressEvent = [aAction isPressEvent];
+    e -> _androidPayload = [aAction androidPayload];
+    e -> _windowsPayload = [aAction windowsPayload];
+    e -> _iosPayload = [aAction iosPayload];
+    return e;
+}
+
++ (instancetype)entryWithGesture:(id<KeymapAction>)aGesture
+{
+    EditorEntry *e = [self p_entryWithId:[aGesture actionId] type:[aGesture keymapType]];
+    e -> _gesture = [(id<NSCopying>)aGesture copyWithZone:nil];
+    if ([aGesture keymapType] == KeymapTypeSwipe)
+    {
+        NSString *key = [(SwipeAction *)aGesture keyCode];
+        e -> _keyCode = [([key length] ? key : @"null") copy];
+    }
+    return e;
+}
+
+- (nullable HostPayload *)payloadForHost:(HostOS)aHost
+{
+    switch (aHost)
+    {
+        case HostOSAndroid: return self -> _androidPayload;
+        case HostOSWindows: return self -> _windowsPayload;
+        case HostOSIOS:     return self -> _iosPayload;
+    }
+    return nil;
+}
+
+- (EditorEntry *)p_copy
+{
+    EditorEntry *e = [EditorEntry p_entryWithId:self -> _actionId type:self -> _type];
+    e -> _origin = self -> _origin;
+    e -> _keyCode = self -> _keyCode;
+    e -> _orientation = self -> _orientation;
+    e -> _pressEvent = self -> _pressEvent;
+    e -> _androidPayload = self -> _androidPayload;
+    e -> _windowsPayload = self -> _windowsPayload;
+    e -> _iosPayload = self -> _iosPayload;
+    e -> _gesture = self -> _gesture;
+    return e;
+}
+
+- (EditorEntry *)p_entryWithOrigin:(CGPoint)aOrigin
+{
+    EditorEntry *e = [self p_copy];
+    e -> _origin = aOrigin;
+    return e;
+}
+
+- (EditorEntry *)p_entryWithKeyCode:(NSString *)aKeyCode
+{
+    EditorEntry *e = [self p_copy];
+    e -> _keyCode = [([aKeyCode length] ? aKeyCode : @"null") copy];
+    return e;
+}
+
+- (NSString *)description
+{
+    if (self -> _gesture)
+    {
+        return [NSString stringWithFormat:@"<EditorEntry id=%ld %@>", (long)self -> _actionId, self -> _gesture];
+    }
+    return [NSString stringWithFormat:@"<EditorEntry id=%ld (%.1f, %.1f) key=%@>", (long)self -> _actionId, self -> _origin.x, self -> _origin.y, self -> _keyCode];
+}
+
+@end
+
+
+#pragma mark - EditorOp
+
+@interface EditorOp ()
+
+@property (nonatomic, readwrite) EditorOpKind kind;
+@property (nonatomic, readwrite) NSInteger actionId;
+@property (nonatomic, strong, readwrite, nullable) EditorEntry *entry;
+@property (nonatomic, readwrite) CGPoint fromOrigin;
+@property (nonatomic, readwrite) CGPoint toOrigin;
+@property (nonatomic, copy, readwrite, nullable) NSString *fromKey;
+@property (nonatomic, copy, readwrite, nullable) NSString *toKey;
+@property (nonatomic, copy, readwrite, nullable) NSArray<EditorEntry *> *beforeEntries;
+@property (nonatomic, copy, readwrite, nullable) NSArray<EditorEntry *> *afterEntries;
+
+@end
+
+@implementation EditorOp
+
++ (instancetype)p_opWithKind:(EditorOpKind)aKind actionId:(NSInteger)aActionId
+{
+    EditorOp *op = [super new];
+    op.kind = aKind;
+    op.actionId = aActionId;
+    return op;
+}
+
++ (instancetype)addOpWithEntry:(EditorEntry *)aEntry
+{
+    EditorOp *op = [self p_opWithKind:EditorOpKindAdd actionId:[aEntry actionId]];
+    op.entry = aEntry;
+    return op;
+}
+
++ (instancetype)deleteOpWithEntry:(EditorEntry *)aEntry
+{
+    EditorOp *op = [self p_opWithKind:EditorOpKindDelete actionId:[aEntry actionId]];
+    op.entry = aEntry;
+    return op;
+}
+
++ (instancetype)moveOpWithId:(NSInteger)aActionId from:(CGPoint)aFrom to:(CGPoint)aTo
+{
+    EditorOp *op = [self p_opWithKind:EditorOpKindMove actionId:aActionId];
+    op.fromOrigin = aFrom;
+    op.toOrigin = aTo;
+    return op;
+}
+
++ (instancetype)setKeyOpWithId:(NSInteger)aActionId from:(NSString *)aFromKey to:(NSString *)aToKey
+{
+    EditorOp *op = [self p_opWithKind:EditorOpKindSetKey actionId:aActionId];
+    op.fromKey = [aFromKey length] ? aFromKey : @"null";
+    op.toKey = [aToKey length] ? aToKey : @"null";
+    return op;
+}
+
++ (instancetype)replaceOpWithBefore:(NSArray<EditorEntry *> *)aBefore after:(NSArray<EditorEntry *> *)aAfter
+{
+    EditorOp *op = [self p_opWithKind:EditorOpKindReplace actionId:-1];
+    op.beforeEntries = aBefore ?: @[];
+    op.afterEntries = aAfter ?: @[];
+    return op;
+}
+
+- (EditorOp *)inverse
+{
+    switch (self.kind)
+    {
+        case EditorOpKindAdd:     return [EditorOp deleteOpWithEntry:self.entry];
+        case EditorOpKindDelete:  return [EditorOp addOpWithEntry:self.entry];
+        case EditorOpKindMove:    return [EditorOp moveOpWithId:self.actionId from:self.toOrigin to:self.fromOrigin];
+        case EditorOpKindSetKey:  return [EditorOp setKeyOpWithId:self.actionId from:self.toKey to:self.fromKey];
+        case EditorOpKindReplace: return [EditorOp replaceOpWithBefore:self.afterEntries after:self.beforeEntries];
+    }
+    return self;
+}
+
+@end
+
+
+#pragma mark - 編碼 / 解碼
+
+static void JournalAppendI32(NSMutableData *aData, int32_t aValue)
+{
+    uint8_t b[4] = { (uint8_t)(aValue & 0xFF), (uint8_t)((aValue >> 8) & 0xFF), (uint8_t)((aValue >> 16) & 0xFF), (uint8_t)((aValue >> 24) & 0xFF) };
+    [aData appendBytes:b length:4];
+}
+
+static void JournalAppendF32(NSMutableData *aData, CGFloat aValue)
+{
+    float f = (float)aValue;
+    int32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    JournalAppendI32(aData, bits);
+}
+
+static void JournalAppendString(NSMutableData *aData, NSString *aString)
+{
+    NSData *utf8 = [aString ?: @"null" dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t len = (uint8_t)MIN([utf8 length], (NSUInteger)255);
+    [aData appendBytes:&len length:1];
+    [aData appendBytes:[utf8 bytes] length:len];
+}
+
+static void JournalAppendU8(NSMutableData *aData, uint8_t aValue)
+{
+    [aData appendBytes:&aValue length:1];
+}
+
+static void JournalAppendHost(NSMutableData *aData, HostPayload *_Nullable aPayload)
+{
+    if (!aPayload)
+    {
+        JournalAppendU8(aData, kHostUnset);
+        return;
+    }
+
+    JournalAppendU8(aData, [aPayload type]);
+    switch ([aPayload type])
+    {
+        case HostPayloadTypeNone:
+            break;
+        case HostPayloadTypeMouse:
+            JournalAppendU8(aData, [aPayload buttons]);
+            JournalAppendU8(aData, (uint8_t)(int8_t)[aPayload deltaX]);
+            JournalAppendU8(aData, (uint8_t)(int8_t)[aPayload deltaY]);
+            JournalAppendU8(aData, (uint8_t)(int8_t)[aPayload wheel]);
+            break;
+        case HostPayloadTypeKeyboard:
+            JournalAppendU8(aData, [aPayload modifiers]);
+            JournalAppendU8(aData, [aPayload hidCode]);
+            break;
+        case HostPayloadTypeMultimedia:
+            JournalAppendU8(aData, (uint8_t)([aPayload usage] & 0xFF));
+            JournalAppendU8(aData, (uint8_t)([aPayload usage] >> 8));
+            break;
+        case HostPayloadTypeCoordinateTap:
+            JournalAppendI32(aData, (int32_t)[aPayload x]);
+            JournalAppendI32(aData, (int32_t)[aPayload y]);
+            JournalAppendU8(aData, (uint8_t)[aPayload touch]);
+            break;
+    }
+}
+
+static void JournalAppendEntry(NSMutableData *aData, EditorEntry *aEntry)
+{
+    JournalAppendI32(aData, (int32_t)[aEntry actionId]);
+    JournalAppendF32(aData, [aEntry origin].x);
+    JournalAppendF32(aData, [aEntry origin].y);
+    JournalAppendString(aData, [aEntry keyCode]);
+    JournalAppendU8(aData, (uint8_t)[aEntry type]);
+
+    switch ([aEntry type])
+    {
+        case KeymapTypePhantomTap:
+            JournalAppendU8(aData, [aEntry isPressEvent] ? 0x01 : 0x00);
+            JournalAppendString(aData, [aEntry orientation]);
+            JournalAppendHost(aData, [aEntry androidPayload]);
+            JournalAppendHost(aData, [aEntry windowsPayload]);
+            JournalAppendHost(aData, [aEntry iosPayload]);
+            break;
+        case KeymapTypeSwipe:
+        {
+            SwipeAction *sa = (SwipeAction *)[aEntry gesture];
+            JournalAppendI32(aData, (int32_t)[sa screenW]);
+            JournalAppendI32(aData, (int32_t)[sa screenH]);
+            JournalAppendI32(aData, (int32_t)[[sa points] count]);
+            for (GesturePoint *p in [sa points])
+            {
+                JournalAppendF32(aData, p.x);
+                JournalAppendF32(aData, p.y);
+                JournalAppendI32(aData, (int32_t)p.timeMs);
+            }
+            break;
+        }
+        case KeymapTypeJoystick:
+        {
+            JoystickAction *ja = (JoystickAction *)[aEntry gesture];
+            JournalAppendI32(aData, (int32_t)[ja screenW]);
+            JournalAppendI32(aData, (int32_t)[ja screenH]);
+            JournalAppendF32(aData, [ja centerX]);
+            JournalAppendF32(aData, [ja centerY]);
+            JournalAppendF32(aData, [ja radius]);
+            JournalAppendI32(aData, (int32_t)[ja rampMs]);
+            JournalAppendString(aData, [ja upKey]);
+            JournalAppendString(aData, [ja downKey]);
+            JournalAppendString(aData, [ja leftKey]);
+            JournalAppendString(aData, [ja rightKey]);
+            break;
+        }
+    }
+}
+
+static void JournalAppendEntries(NSMutableData *aData, NSArray<EditorEntry *> *aEntries)
+{
+    JournalAppendI32(aData, (int32_t)[aEntries count]);
+    for (EditorEntry *e in aEntries)
+    {
+        JournalAppendEntry(aData, e);
+    }
+}
+
+static void JournalAppendRecord(NSMutableData *aOut, uint8_t aTag, NSData *_Nullable aPayload)
+{
+    uint32_t len = (uint32_t)[aPayload length];
+    uint8_t header[5] = { aTag, (uint8_t)(len & 0xFF), (uint8_t)((len >> 8) & 0xFF), (uint8_t)((len >> 16) & 0xFF), (uint8_t)((len >> 24) & 0xFF) };
+
+    uint8_t check = aTag;
+    const uint8_t *p = [aPayload bytes];
+    for (uint32_t i = 0; i < len; i++) check ^= p[i];
+
+    [aOut appendBytes:header length:sizeof(header)];
+    if (len) [aOut appendData:aPayload];
+    [aOut appendBytes:&check length:1];
+}
+
+static void JournalAppendOpRecord(NSMutableData *aOut, EditorOp *aOp)
+{
+    NSMutableData *payload = [NSMutableData data];
+    switch ([aOp kind])
+    {
+        case EditorOpKindAdd:
+        case EditorOpKindDelete:
+            JournalAppendEntry(payload, [aOp entry]);
+            break;
+        case EditorOpKindMove:
+            JournalAppendI32(payload, (int32_t)[aOp actionId]);
+            JournalAppendF32(payload, [aOp fromOrigin].x);
+            JournalAppendF32(payload, [aOp fromOrigin].y);
+            JournalAppendF32(payload, [aOp toOrigin].x);
+            JournalAppendF32(payload, [aOp toOrigin].y);
+            break;
+        case EditorOpKindSetKey:
+            JournalAppendI32(payload, (int32_t)[aOp actionId]);
+            JournalAppendString(payload, [aOp fromKey]);
+            JournalAppendString(payload, [aOp toKey]);
+            break;
+        case EditorOpKindReplace:
+            JournalAppendEntries(payload, [aOp beforeEntries]);
+            JournalAppendEntries(payload, [aOp afterEntries]);
+            break;
+    }
+    JournalAppendRecord(aOut, (uint8_t)[aOp kind], payload);
+}
+
+
+typedef struct
+{
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger offset;
+    BOOL failed;
+} JournalReader;
+
+static uint8_t JournalReadU8(JournalReader *r)
+{
+    if (r -> failed || r -> offset + 1 > r -> length) { r -> failed = YES; return 0; }
+    return r -> bytes[r -> offset++];
+}
+
+static int32_t JournalReadI32(JournalReader *r)
+{
+    if (r -> failed || r -> offset + 4 > r -> length) { r -> failed = YES; return 0; }
+    const uint8_t *p = r -> bytes + r -> offset;
+    r -> offset += 4;
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static CGFloat JournalReadF32(JournalReader *r)
+{
+    int32_t bits = JournalReadI32(r);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return (CGFloat)f;
+}
+
+static NSString *JournalReadString(JournalReader *r)
+{
+    if (r -> failed || r -> offset + 1 > r -> length) { r -> failed = YES; return @"null"; }
+    uint8_t len = r -> bytes[r -> offset++];
+    if (r -> offset + len > r -> length) { r -> failed = YES; return @"null"; }
+    NSString *s = [[NSString alloc] initWithBytes:r -> bytes + r -> offset length:len encoding:NSUTF8StringEncoding];
+    r -> offset += len;
+    return s ?: @"null";
+}
+
+static HostPayload *_Nullable JournalReadHost(JournalReader *r)
+{
+    uint8_t type = JournalReadU8(r);
+    switch (type)
+    {
+        case kHostUnset:
+            return nil;
+        case HostPayloadTypeNone:
+            return [HostPayload none];
+        case HostPayloadTypeMouse:
+        {
+            uint8_t buttons = JournalReadU8(r);
+            int8_t dx = (int8_t)JournalReadU8(r);
+            int8_t dy = (int8_t)JournalReadU8(r);
+            int8_t wheel = (int8_t)JournalReadU8(r);
+            return [HostPayload mouseWithButtons:buttons deltaX:dx deltaY:dy wheel:wheel];
+        }
+        case HostPayloadTypeKeyboard:
+        {
+            uint8_t modifiers = JournalReadU8(r);
+            uint8_t hid = JournalReadU8(r);
+            return [HostPayload keyboardWithModifiers:modifiers hidCode:hid];
+        }
+        case HostPayloadTypeMultimedia:
+        {
+            uint16_t lo = JournalReadU8(r);
+            uint16_t hi = JournalReadU8(r);
+            return [HostPayload multimediaWithUsage:(uint16_t)(lo | (hi << 8))];
+        }
+        case HostPayloadTypeCoordinateTap:
+        {
+            NSInteger x = JournalReadI32(r);
+            NSInteger y = JournalReadI32(r);
+            NSInteger touch = JournalReadU8(r);
+            return [HostPayload coordinateTapWithX:x y:y touch:touch];
+        }
+    }
+    r -> failed = YES;
+    return nil;
+}
+
+static EditorEntry *JournalReadEntry(JournalReader *r)
+{
+    NSInteger actionId = JournalReadI32(r);
+    CGFloat x = JournalReadF32(r);
+    CGFloat y = JournalReadF32(r);
+    NSString *key = JournalReadString(r);
+
+    uint8_t type = JournalReadU8(r);
+    switch (type)
+    {
+        case KeymapTypePhantomTap:
+        {
+            uint8_t flags = JournalReadU8(r);
+            NSString *orientation = JournalReadString(r);
+            TapAction *ta = [[TapAction alloc] initWithId:actionId orientation:orientation screenW:0 screenH:0 posX:x posY:y keyCode:key pressEvent:(flags & 0x01) != 0];
+            ta.androidPayload = JournalReadHost(r);
+            ta.windowsPayload = JournalReadHost(r);
+            ta.iosPayload = JournalReadHost(r);
+            return [EditorEntry entryWithTapAction:ta origin:CGPointMake(x, y)];
+        }
+        case KeymapTypeSwipe:
+        {
+            NSInteger screenW = JournalReadI32(r);
+            NSInteger screenH = JournalReadI32(r);
+            int32_t count = JournalReadI32(r);
+            if (count < 0) { r -> failed = YES; break; }
+
+            NSMutableArray<GesturePoint *> *points = [NSMutableArray arrayWithCapacity:(NSUInteger)MIN(count, 4096)];
+            for (int32_t i = 0; i < count && !r -> failed; i++)
+            {
+                CGFloat px = JournalReadF32(r);
+                CGFloat py = JournalReadF32(r);
+                NSInteger t = JournalReadI32(r);
+                [points addObject:[GesturePoint pointWithX:px y:py timeMs:t]];
+            }
+            return [EditorEntry entryWithGesture:[[SwipeAction alloc] initWithId:actionId screenW:screenW screenH:screenH keyCode:key points:points]];
+        }
+        case KeymapTypeJoystick:
+        {
+            NSInteger screenW = JournalReadI32(r);
+            NSInteger screenH = JournalReadI32(r);
+            CGFloat cx = JournalReadF32(r);
+            CGFloat cy = JournalReadF32(r);
+            CGFloat radius = JournalReadF32(r);
+
+            JoystickAction *ja = [[JoystickAction alloc] initWithId:actionId screenW:screenW screenH:screenH centerX:cx centerY:cy radius:radius];
+            ja.rampMs = JournalReadI32(r);
+            ja.upKey = JournalReadString(r);
+            ja.downKey = JournalReadString(r);
+            ja.leftKey = JournalReadString(r);
+            ja.rightKey = JournalReadString(r);
+            return [EditorEntry entryWithGesture:ja];
+        }
+        default:
+            r -> failed = YES;
+            break;
+    }
+    return [EditorEntry entryWithId:actionId origin:CGPointMake(x, y) keyCode:key];
+}
+
+static NSArray<EditorEntry *> *JournalReadEntries(JournalReader *r)
+{
+    int32_t count = JournalReadI32(r);
+    if (count < 0) { r -> failed = YES; return @[]; }
+
+    NSMutableArray<EditorEntry *> *arr = [NSMutableArray arrayWithCapacity:(NSUInteger)MIN(count, 1024)];
+    for (int32_t i = 0; i < count && !r -> failed; i++)
+    {
+        [arr addObject:JournalReadEntry(r)];
+    }
+    return arr;
+}
+
+static EditorOp *_Nullable JournalDecodeOp(uint8_t aTag, const uint8_t *aBytes, NSUInteger aLength)
+{
+    JournalReader r = { aBytes, aLength, 0, NO };
+    EditorOp *op = nil;
+
+    switch (aTag)
+    {
+        case EditorOpKindAdd:
+            op = [EditorOp addOpWithEntry:JournalReadEntry(&r)];
+            break;
+        case EditorOpKindDelete:
+            op = [EditorOp deleteOpWithEntry:JournalReadEntry(&r)];
+            break;
+        case EditorOpKindMove:
+        {
+            NSInteger actionId = JournalReadI32(&r);
+            CGFloat fx = JournalReadF32(&r), fy = JournalReadF32(&r);
+            CGFloat tx = JournalReadF32(&r), ty = JournalReadF32(&r);
+            op = [EditorOp moveOpWithId:actionId from:CGPointMake(fx, fy) to:CGPointMake(tx, ty)];
+            break;
+        }
+        case EditorOpKindSetKey:
+        {
+            NSInteger actionId = JournalReadI32(&r);
+            NSString *from = JournalReadString(&r);
+            NSString *to = JournalReadString(&r);
+            op = [EditorOp setKeyOpWithId:actionId from:from to:to];
+            break;
+        }
+        case EditorOpKindReplace:
+        {
+            NSArray *before = JournalReadEntries(&r);
+            NSArray *after = JournalReadEntries(&r);
+            op = [EditorOp replaceOpWithBefore:before after:after];
+            break;
+        }
+        default:
+            return nil;
+    }
+
+    return r.failed ? nil : op;
+}
+
+
+/// 把操作套用到 id → entry 的狀態上
+static void JournalApplyOp(NSMutableDictionary<NSNumber *, EditorEntry *> *aState, EditorOp *aOp)
+{
+    NSNumber *key = @([aOp actionId]);
+    switch ([aOp kind])
+    {
+        case EditorOpKindAdd:
+            aState[key] = [aOp entry];
+            break;
+        case EditorOpKindDelete:
+            [aState removeObjectForKey:key];
+            break;
+        case EditorOpKindMove:
+        {
+            EditorEntry *e = aState[key];
+            if (e) aState[key] = [e p_entryWithOrigin:[aOp toOrigin]];
+            break;
+        }
+        case EditorOpKindSetKey:
+        {
+            EditorEntry *e = aState[key];
+            if (e) aState[key] = [e p_entryWithKeyCode:[aOp toKey]];
+            break;
+        }
+        case EditorOpKindReplace:
+            for (EditorEntry *e in [aOp beforeEntries]) [aState removeObjectForKey:@([e actionId])];
+            for (EditorEntry *e in [aOp afterEntries]) aState[@([e actionId])] = e;
+            break;
+    }
+}
+
+
+#pragma mark - EditorJournal
+
+/// 寫暫存檔 → fsync → rename → fsync 目錄
+/// rename 之前資料已落地，rename 之後目錄項目也落地，斷電時只會看到舊檔或完整的新檔
+static BOOL JournalReplaceFileDurably(NSData *aData, NSString *aTmpPath, NSString *aPath)
+{
+    int fd = open([aTmpPath fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NO;
+
+    const uint8_t *p = [aData bytes];
+    NSUInteger left = [aData length];
+    while (left > 0)
+    {
+        ssize_t n = write(fd, p, left);
+        if (n < 0)
+        {
+            close(fd);
+            unlink([aTmpPath fileSystemRepresentation]);
+            return NO;
+        }
+        p += n;
+        left -= (NSUInteger)n;
+    }
+
+    if (fsync(fd) != 0)
+    {
+        close(fd);
+        unlink([aTmpPath fileSystemRepresentation]);
+        return NO;
+    }
+    close(fd);
+
+    if (rename([aTmpPath fileSystemRepresentation], [aPath fileSystemRepresentation]) != 0)
+    {
+        unlink([aTmpPath fileSystemRepresentation]);
+        return NO;
+    }
+
+    int dirFd = open([[aPath stringByDeletingLastPathComponent] fileSystemRepresentation], O_RDONLY);
+    if (dirFd >= 0)
+    {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return YES;
+}
+
+/// 用來判斷目前是否已在 _ioQueue 上
+static char kJournalIOQueueKey;
+
+
+@interface EditorJournal ()
+{
+    NSMutableDictionary<NSNumber *, EditorEntry *> *_base;     // ops[0] 之前的狀態
+    NSMutableDictionary<NSNumber *, EditorEntry *> *_live;     // ops[0 ..< cursor] 套用後的狀態
+    NSMutableArray<EditorOp *> *_ops;
+    NSUInteger _cursor;
+
+    NSUInteger _recordCount;        // 檔案裡 (含排隊中) 的 record 數
+    BOOL _compactionPending;
+
+    dispatch_queue_t _ioQueue;      // 所有檔案 I/O 都在這條 serial queue 上
+    NSFileHandle *_fileHandle;      // 只在 _ioQueue 上使用
+}
+@end
+
+@implementation EditorJournal
+
++ (NSString *)defaultPath
+{
+    NSString *dir = [NSSearchPathForDirectoriesInDomains(NSApplicationSupportDirectory, NSUserDomainMask, YES) firstObject];
+    dir = [dir stringByAppendingPathComponent:@"EditorJournal"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:dir withIntermediateDirectories:YES attributes:nil error:nil];
+    return [dir stringByAppendingPathComponent:@"current.journal"];
+}
+
+- (instancetype)initWithPath:(NSString *)aPath
+{
+    self = [super init];
+    if (!self) return nil;
+
+    _path = [aPath copy];
+    _maxUndoDepth = 200;
+    _compactionThreshold = 512;
+
+    _base = [NSMutableDictionary dictionary];
+    _live = [NSMutableDictionary dictionary];
+    _ops = [NSMutableArray array];
+    _cursor = 0;
+    _ioQueue = dispatch_queue_create("com.phantomtap.editor-journal", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(_ioQueue, &kJournalIOQueueKey, &kJournalIOQueueKey, NULL);
+
+    [self p_recover];
+
+    return self;
+}
+
+- (void)dealloc
+{
+    // _fileHandle 只在 _ioQueue 上碰；最後一個 reference 可能就在 _ioQueue 上放掉 (compact 的 block)，那時直接關
+    __unsafe_unretained EditorJournal *unsafeSelf = self;
+    dispatch_block_t closeBlock = ^{
+        [unsafeSelf -> _fileHandle closeFile];
+        unsafeSelf -> _fileHandle = nil;
+    };
+
+    if (dispatch_get_specific(&kJournalIOQueueKey))
+    {
+        closeBlock();
+    }
+    else
+    {
+        dispatch_sync(_ioQueue, closeBlock);
+    }
+}
+
+
+#pragma mark - State
+
+- (NSArray<EditorEntry *> *)currentEntries
+{
+    return [[self -> _live allValues] sortedArrayUsingComparator:^NSComparisonResult(EditorEntry *a, EditorEntry *b) {
+        return ([a actionId] < [b actionId]) ? NSOrderedAscending :
+               ([a actionId] > [b actionId]) ? NSOrderedDescending : NSOrderedSame;
+    }];
+}
+
+- (nullable EditorEntry *)entryForId:(NSInteger)aActionId
+{
+    return self -> _live[@(aActionId)];
+}
+
+
+#pragma mark - Record / Undo / Redo
+
+- (void)recordOp:(EditorOp *)aOp
+{
+    if (!aOp) return;
+
+    // 新操作會讓 redo 失效
+    if (self -> _cursor < [self -> _ops count])
+    {
+        [self -> _ops removeObjectsInRange:NSMakeRange(self -> _cursor, [self -> _ops count] - self -> _cursor)];
+    }
+
+    [self -> _ops addObject:aOp];
+    self -> _cursor++;
+    JournalApplyOp(self -> _live, aOp);
+
+    [self p_trimUndoHistory];
+
+    NSMutableData *rec = [NSMutableData data];
+    JournalAppendOpRecord(rec, aOp);
+    [self p_appendRecordData:rec];
+}
+
+- (BOOL)canUndo
+{
+    return self -> _cursor > 0;
+}
+
+- (BOOL)canRedo
+{
+    return self -> _cursor < [self -> _ops count];
+}
+
+- (nullable EditorOp *)undo
+{
+    if (![self canUndo]) return nil;
+
+    self -> _cursor--;
+    EditorOp *inv = [self -> _ops[self -> _cursor] inverse];
+    JournalApplyOp(self -> _live, inv);
+
+    NSMutableData *rec = [NSMutableData data];
+    JournalAppendRecord(rec, kTagUndo, nil);
+    [self p_appendRecordData:rec];
+
+    return inv;
+}
+
+- (nullable EditorOp *)redo
+{
+    if (![self canRedo]) return nil;
+
+    EditorOp *op = self -> _ops[self -> _cursor];
+    self -> _cursor++;
+    JournalApplyOp(self -> _live, op);
+
+    NSMutableData *rec = [NSMutableData data];
+    JournalAppendRecord(rec, kTagRedo, nil);
+    [self p_appendRecordData:rec];
+
+    return op;
+}
+
+/// 超過 undo 深度的最舊操作摺進 base (每次最多摺一筆，O(1))
+- (void)p_trimUndoHistory
+{
+    while ([self -> _ops count] > self -> _maxUndoDepth && self -> _cursor > 0)
+    {
+        JournalApplyOp(self -> _base, self -> _ops[0]);
+        [self -> _ops removeObjectAtIndex:0];
+        self -> _cursor--;
+    }
+}
+
+
+#pragma mark - Disk
+
+- (void)p_appendRecordData:(NSData *)aData
+{
+    dispatch_async(self -> _ioQueue, ^{
+        @try
+        {
+            [self -> _fileHandle writeData:aData];
+        }
+        @catch (NSException *e)
+        {
+            NSLog(@"[Journal] append failed: %@", e);
+        }
+    });
+
+    self -> _recordCount++;
+    if (self -> _recordCount >= self -> _compactionThreshold && !self -> _compactionPending)
+    {
+        [self compact];
+    }
+}
+
+- (void)compact
+{
+    // 在 main thread 拍下 snapshot (都是 immutable 物件)，序列化和寫檔丟到背景
+    NSArray<EditorEntry *> *base = [[self -> _base allValues] copy];
+    NSArray<EditorOp *> *ops = [self -> _ops copy];
+    NSUInteger undone = [ops count] - self -> _cursor;
+
+    self -> _recordCount = 1 + [ops count] + undone;
+    self -> _compactionPending = YES;
+
+    NSString *path = self -> _path;
+    NSString *tmpPath = [path stringByAppendingString:@".tmp"];
+
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(self -> _ioQueue, ^{
+        NSMutableData *out = [NSMutableData dataWithBytes:kJournalMagic length:sizeof(kJournalMagic)];
+
+        NSMutableData *basePayload = [NSMutableData data];
+        JournalAppendEntries(basePayload, base);
+        JournalAppendRecord(out, kTagBase, basePayload);
+
+        for (EditorOp *op in ops)
+        {
+            JournalAppendOpRecord(out, op);
+        }
+        for (NSUInteger i = 0; i < undone; i++)
+        {
+            JournalAppendRecord(out, kTagUndo, nil);
+        }
+
+        BOOL ok = JournalReplaceFileDurably(out, tmpPath, path);
+
+        __strong typeof(weakSelf) strongSelf = weakSelf;
+        if (ok && strongSelf)
+        {
+            [strongSelf -> _fileHandle closeFile];
+            strongSelf -> _fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+            [strongSelf -> _fileHandle seekToEndOfFile];
+        }
+        NSLog(@"[Journal] compacted ok=%d base=%lu ops=%lu bytes=%lu", ok, (unsigned long)[base count], (unsigned long)[ops count], (unsigned long)[out length]);
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            __strong typeof(weakSelf) s = weakSelf;
+            if (s) s -> _compactionPending = NO;
+        });
+    });
+}
+
+- (void)flush
+{
+    dispatch_sync(self -> _ioQueue, ^{
+        [self -> _fileHandle synchronizeFile];
+    });
+}
+
+/// 讀檔 replay；尾端不完整的 record 會被截掉
+/// checksum 正確但內容解不開的 record 視為損毀：記 log、略過，後面的 record 照樣 replay
+- (void)p_recover
+{
+    NSData *data = [NSData dataWithContentsOfFile:self -> _path];
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+
+    NSUInteger validLength = 0;
+    NSUInteger skipped = 0;
+
+    if (length >= sizeof(kJournalMagic) && memcmp(bytes, kJournalMagic, sizeof(kJournalMagic)) == 0)
+    {
+        NSUInteger offset = sizeof(kJournalMagic);
+        validLength = offset;
+
+        while (offset + 6 <= length)
+        {
+            uint8_t tag = bytes[offset];
+            uint32_t len = (uint32_t)bytes[offset + 1] | ((uint32_t)bytes[offset + 2] << 8) | ((uint32_t)bytes[offset + 3] << 16) | ((uint32_t)bytes[offset + 4] << 24);
+            if ((NSUInteger)len > length - offset - 6) break;
+
+            const uint8_t *payload = bytes + offset + 5;
+            uint8_t check = tag;
+            for (uint32_t i = 0; i < len; i++) check ^= payload[i];
+            if (check != payload[len]) break;
+
+            if (![self p_replayTag:tag payload:payload length:len])
+            {
+                NSLog(@"[Journal] skipped undecodable record tag=0x%02X len=%u at %lu", tag, len, (unsigned long)offset);
+                skipped++;
+            }
+
+            offset += 6 + len;
+            validLength = offset;
+            self -> _recordCount++;
+        }
+
+        if (validLength < length)
+        {
+            NSLog(@"[Journal] dropped %lu bytes of torn tail", (unsigned long)(length - validLength));
+        }
+        if (skipped > 0)
+        {
+            NSLog(@"[Journal] skipped %lu corrupt records", (unsigned long)skipped);
+        }
+    }
+    else
+    {
+        if (length > 0) NSLog(@"[Journal] unrecognized journal, starting fresh");
+        [[NSData dataWithBytes:kJournalMagic length:sizeof(kJournalMagic)] writeToFile:self -> _path atomically:YES];
+        validLength = sizeof(kJournalMagic);
+    }
+
+    NSString *path = self -> _path;
+    dispatch_sync(self -> _ioQueue, ^{
+        NSFileHandle *fh = [NSFileHandle fileHandleForWritingAtPath:path];
+        [fh truncateFileAtOffset:validLength];
+        [fh seekToEndOfFile];
+        self -> _fileHandle = fh;
+    });
+
+    [self p_trimUndoHistory];
+
+    NSLog(@"[Journal] recovered entries=%lu ops=%lu cursor=%lu records=%lu", (unsigned long)[self -> _live count], (unsigned long)[self -> _ops count], (unsigned long)self -> _cursor, (unsigned long)self -> _recordCount);
+
+    // 有損毀的 record 時也 compact，把它們從檔案裡清掉
+    if (skipped > 0 || self -> _recordCount >= self -> _compactionThreshold)
+    {
+        [self compact];
+    }
+}
+
+- (BOOL)p_replayTag:(uint8_t)aTag payload:(const uint8_t *)aPayload length:(uint32_t)aLength
+{
+    switch (aTag)
+    {
+        case kTagBase:
+        {
+            JournalReader r = { aPayload, aLength, 0, NO };
+            NSArray<EditorEntry *> *entries = JournalReadEntries(&r);
+            if (r.failed) return NO;
+
+            [self -> _base removeAllObjects];
+            for (EditorEntry *e in entries) self -> _base[@([e actionId])] = e;
+            self -> _live = [self -> _base mutableCopy];
+            [self -> _ops removeAllObjects];
+            self -> _cursor = 0;
+            return YES;
+        }
+        case kTagUndo:
+            if (self -> _cursor > 0)
+            {
+                self -> _cursor--;
+                JournalApplyOp(self -> _live, [self -> _ops[self -> _cursor] inverse]);
+            }
+            return YES;
+        case kTagRedo:
+            if (self -> _cursor < [self -> _ops count])
+            {
+                JournalApplyOp(self -> _live, self -> _ops[self -> _cursor]);
+                self -> _cursor++;
+            }
+            return YES;
+        default:
+        {
+            EditorOp *op = JournalDecodeOp(aTag, aPayload, aLength);
+            if (!op) return NO;
+
+            if (self -> _cursor < [self -> _ops count])
+            {
+                [self -> _ops removeObjectsInRange:NSMakeRange(self -> _cursor, [self -> _ops count] - self -> _cursor)];
+            }
+            [self -> _ops addObject:op];
+            self -> _cursor++;
+            JournalApplyOp(self -> _live, op);
+            return YES;
+        }
+    }
+}
+
+@end
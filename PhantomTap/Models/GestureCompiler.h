@@ -0,0 +1,65 @@
+//
+//  GestureCompiler.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/12.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "KeymapModels.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface GestureCompilerOptions : NSObject
+
+/// 允許的最大位置誤差 (像素)，預設 4
+/// 以「同一時間點」的位置比較 (synchronized distance)，所以速度變化也會被保留
+/// 對每個原始觸控點都成立 (不只是重新取樣後的點)；maxSteps 放寬時改以放寬後的誤差為準
+@property (nonatomic) CGFloat maxPositionError;
+
+/// 先把原始觸控點依固定時間間隔重新取樣 (ms)，預設 8
+@property (nonatomic) NSInteger resampleIntervalMs;
+
+/// 兩步之間的最小延遲 (ms)，預設 8；韌體無法更快地處理座標
+@property (nonatomic) NSInteger minStepDelayMs;
+
+/// 步驟數上限，0 = 不限制；超過時會逐步放寬 maxPositionError
+@property (nonatomic) NSInteger maxSteps;
+
+/// 輸出座標的螢幕像素尺寸；CGSizeZero = 不縮放、不夾邊
+@property (nonatomic) CGSize targetScreenSize;
+
++ (instancetype)defaultOptions;
+
+@end
+
+
+/// 把手勢路徑編譯成「點擊指定座標」巨集步驟
+///
+/// 1. 依時間重新取樣，補上不規則觸控取樣間隔之間的點
+/// 2. 取樣點 + 原始點一起用 synchronized-distance 的 Douglas–Peucker 簡化，只留下誤差超過門檻的轉折點
+/// 3. 每個保留點輸出一步 (第一步按下、中間按住移動、最後一步放開)，延遲 = 到下一點的時間差
+///
+/// 假設韌體在兩個按住的步驟之間會以 delay 線性移動觸控點
+@interface GestureCompiler : NSObject
+
++ (NSArray<MacroStep *> *)compilePath:(NSArray<GesturePoint *> *)aPoints screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH options:(GestureCompilerOptions *)aOptions;
+
++ (NSArray<MacroStep *> *)compileSwipe:(SwipeAction *)aSwipe options:(GestureCompilerOptions *)aOptions;
+
+/// 回傳 方向鍵 label → 步驟；未指定的方向不輸出
+/// 每個方向兩步：中心按住 (delay = rampMs) → 邊緣按住 (delay 0)，沒有放開步驟
+/// 巨集須以非連續模式送出，方向鍵放開時由韌體釋放觸控
++ (NSDictionary<NSString *, NSArray<MacroStep *> *> *)compileJoystick:(JoystickAction *)aJoystick options:(GestureCompilerOptions *)aOptions;
+
+
+#pragma mark - Building blocks
+
++ (NSArray<GesturePoint *> *)resamplePath:(NSArray<GesturePoint *> *)aPoints intervalMs:(NSInteger)aIntervalMs;
+
++ (NSArray<GesturePoint *> *)simplifyPath:(NSArray<GesturePoint *> *)aPoints tolerance:(CGFloat)aTolerance;
+
+@end
+
+NS_ASSUME_NONNULL_END
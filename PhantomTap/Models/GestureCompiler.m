@@ -0,0 +1,276 @@
+//
+//  GestureCompiler.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/12.
+//
+
+#import "GestureCompiler.h"
+
+/// 放寬誤差的倍率與次數 (maxSteps 用)
+static const CGFloat kGCToleranceGrowth = 1.5;
+static const NSInteger kGCMaxRelaxRounds = 24;
+
+
+@implementation GestureCompilerOptions
+
++ (instancetype)defaultOptions
+{
+    GestureCompilerOptions *o = [GestureCompilerOptions new];
+    o.maxPositionError = 4.0;
+    o.resampleIntervalMs = 8;
+    o.minStepDelayMs = 8;
+    o.maxSteps = 0;
+    o.targetScreenSize = CGSizeZero;
+    return o;
+}
+
+@end
+
+
+@implementation GestureCompiler
+
+#pragma mark - Building blocks
+
++ (NSArray<GesturePoint *> *)resamplePath:(NSArray<GesturePoint *> *)aPoints intervalMs:(NSInteger)aIntervalMs
+{
+    NSUInteger n = [aPoints count];
+    if (n < 2 || aIntervalMs <= 0) return [aPoints copy];
+    
+    NSInteger t0 = [aPoints[0] timeMs];
+    NSInteger tEnd = [[aPoints lastObject] timeMs];
+    if (tEnd <= t0) return @[aPoints[0], [aPoints lastObject]];
+    
+    NSMutableArray<GesturePoint *> *out = [NSMutableArray arrayWithCapacity:(NSUInteger)((tEnd - t0) / aIntervalMs) + 2];
+    NSUInteger seg = 0;
+    
+    for (NSInteger t = t0; ; t += aIntervalMs)
+    {
+        if (t > tEnd) t = tEnd;
+        
+        // 找到包住 t 的原始線段 (時間非遞減)
+        while (seg + 1 < n - 1 && [aPoints[seg + 1] timeMs] < t) seg++;
+        
+        GesturePoint *a = aPoints[seg];
+        GesturePoint *b = aPoints[seg + 1];
+        NSInteger span = [b timeMs] - [a timeMs];
+        CGFloat f = (span > 0) ? (CGFloat)(t - [a timeMs]) / (CGFloat)span : 1.0;
+        f = MAX(0.0, MIN(f, 1.0));
+        
+        [out addObject:[GesturePoint pointWithX:a.x + (b.x - a.x) * f y:a.y + (b.y - a.y) * f timeMs:t]];
+        
+        if (t == tEnd) break;
+    }
+    
+    return out;
+}
+
++ (NSArray<GesturePoint *> *)simplifyPath:(NSArray<GesturePoint *> *)aPoints tolerance:(CGFloat)aTolerance
+{
+    NSUInteger n = [aPoints count];
+    if (n < 3) return [aPoints copy];
+    
+    // 拷到 C 陣列，避免在迴圈裡反覆 message send
+    double *xs = malloc(sizeof(double) * n);
+    double *ys = malloc(sizeof(double) * n);
+    double *ts = malloc(sizeof(double) * n);
+    BOOL *keep = calloc(n, sizeof(BOOL));
+    NSUInteger *stack = malloc(sizeof(NSUInteger) * 2 * n);
+    
+    for (NSUInteger i = 0; i < n; i++)
+    {
+        xs[i] = aPoints[i].x;
+        ys[i] = aPoints[i].y;
+        ts[i] = (double)aPoints[i].timeMs;
+    }
+    keep[0] = YES;
+    keep[n - 1] = YES;
+    
+    double tol2 = (double)aTolerance * (double)aTolerance;
+    NSUInteger top = 0;
+    stack[top++] = 0;
+    stack[top++] = n - 1;
+    
+    while (top > 0)
+    {
+        NSUInteger b = stack[--top];
+        NSUInteger a = stack[--top];
+        if (b <= a + 1) continue;
+        
+        double span = ts[b] - ts[a];
+        double maxD2 = -1;
+        NSUInteger maxI = a;
+        
+        for (NSUInteger i = a + 1; i < b; i++)
+        {
+            // 同一時間點在 a→b 直線上的位置
+            double f = (span > 0) ? (ts[i] - ts[a]) / span : 0.5;
+            double px = xs[a] + (xs[b] - xs[a]) * f;
+            double py = ys[a] + (ys[b] - ys[a]) * f;
+            double dx = xs[i] - px;
+            double dy = ys[i] - py;
+            double d2 = dx * dx + dy * dy;
+            if (d2 > maxD2)
+            {
+                maxD2 = d2;
+                maxI = i;
+            }
+        }
+        
+        if (maxD2 > tol2)
+        {
+            keep[maxI] = YES;
+            stack[top++] = a;
+            stack[top++] = maxI;
+            stack[top++] = maxI;
+            stack[top++] = b;
+        }
+    }
+    
+    NSMutableArray<GesturePoint *> *out = [NSMutableArray array];
+    for (NSUInteger i = 0; i < n; i++)
+    {
+        if (keep[i]) [out addObject:aPoints[i]];
+    }
+    
+    free(xs);
+    free(ys);
+    free(ts);
+    free(keep);
+    free(stack);
+    
+    return out;
+}
+
+
+#pragma mark - Private
+
+/// 依時間合併原始點與重新取樣點；同一時間點只留原始點
++ (NSArray<GesturePoint *> *)p_mergePath:(NSArray<GesturePoint *> *)aSorted withSamples:(NSArray<GesturePoint *> *)aSamples
+{
+    NSMutableArray<GesturePoint *> *out = [NSMutableArray arrayWithCapacity:[aSorted count] + [aSamples count]];
+    NSUInteger i = 0, j = 0;
+    
+    while (i < [aSorted count] || j < [aSamples count])
+    {
+        if (j >= [aSamples count] || (i < [aSorted count] && aSorted[i].timeMs <= aSamples[j].timeMs))
+        {
+            GesturePoint *p = aSorted[i++];
+            [out addObject:p];
+            while (j < [aSamples count] && aSamples[j].timeMs == p.timeMs) j++;
+        }
+        else
+        {
+            [out addObject:aSamples[j++]];
+        }
+    }
+    return out;
+}
+
+/// 換算到目標螢幕座標 (有 targetScreenSize 時縮放並夾在螢幕內)
++ (MacroStep *)p_stepWithTouch:(MacroTouch)aTouch x:(CGFloat)aX y:(CGFloat)aY delayMs:(NSInteger)aDelayMs screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH options:(GestureCompilerOptions *)aOptions
+{
+    CGFloat x = aX, y = aY;
+    BOOL clamp = (aOptions.targetScreenSize.width > 0 && aOptions.targetScreenSize.height > 0);
+    if (clamp)
+    {
+        if (aScreenW > 0 && aScreenH > 0)
+        {
+            x = x * aOptions.targetScreenSize.width / (CGFloat)aScreenW;
+            y = y * aOptions.targetScreenSize.height / (CGFloat)aScreenH;
+        }
+        x = MAX(0, MIN(x, aOptions.targetScreenSize.width - 1));
+        y = MAX(0, MIN(y, aOptions.targetScreenSize.height - 1));
+    }
+    return [MacroStep stepWithTouch:aTouch x:(NSInteger)lround(x) y:(NSInteger)lround(y) delayMs:aDelayMs];
+}
+
+
+#pragma mark - Compile
+
++ (NSArray<MacroStep *> *)compilePath:(NSArray<GesturePoint *> *)aPoints screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH options:(GestureCompilerOptions *)aOptions
+{
+    if ([aPoints count] == 0) return @[];
+    
+    GestureCompilerOptions *opt = aOptions ?: [GestureCompilerOptions defaultOptions];
+    
+    // 依時間排序；時間一律從 0 開始
+    NSArray<GesturePoint *> *sorted = [aPoints sortedArrayUsingComparator:^NSComparisonResult(GesturePoint *a, GesturePoint *b) {
+        return (a.timeMs < b.timeMs) ? NSOrderedAscending : (a.timeMs > b.timeMs) ? NSOrderedDescending : NSOrderedSame;
+    }];
+    
+    // 重新取樣點 + 原始點一起簡化：DP 保證每個輸入點都在誤差內，原始點才不會只被取樣點代表
+    NSArray<GesturePoint *> *merged = [self p_mergePath:sorted withSamples:[self resamplePath:sorted intervalMs:opt.resampleIntervalMs]];
+    
+    CGFloat tolerance = MAX(opt.maxPositionError, 0.0);
+    NSArray<GesturePoint *> *kept = [self simplifyPath:merged tolerance:tolerance];
+    
+    for (NSInteger round = 0; opt.maxSteps > 0 && (NSInteger)[kept count] > opt.maxSteps && round < kGCMaxRelaxRounds; round++)
+    {
+        tolerance = MAX(tolerance, 1.0) * kGCToleranceGrowth;
+        kept = [self simplifyPath:merged tolerance:tolerance];
+    }
+    
+    NSMutableArray<MacroStep *> *steps = [NSMutableArray arrayWithCapacity:[kept count]];
+    NSUInteger count = [kept count];
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        GesturePoint *p = kept[i];
+        BOOL isLast = (i == count - 1);
+        NSInteger delay = isLast ? 0 : MAX(opt.minStepDelayMs, [kept[i + 1] timeMs] - p.timeMs);
+        MacroTouch touch = (isLast && count > 1) ? MacroTouchRelease : MacroTouchHold;
+        
+        [steps addObject:[self p_stepWithTouch:touch x:p.x y:p.y delayMs:delay screenW:aScreenW screenH:aScreenH options:opt]];
+    }
+    
+    // 只有一個點 → 當成單次點擊
+    if (count == 1)
+    {
+        [[steps firstObject] setTouch:MacroTouchTap];
+    }
+    
+    return steps;
+}
+
++ (NSArray<MacroStep *> *)compileSwipe:(SwipeAction *)aSwipe options:(GestureCompilerOptions *)aOptions
+{
+    return [self compilePath:[aSwipe points] screenW:[aSwipe screenW] screenH:[aSwipe screenH] options:aOptions];
+}
+
++ (NSDictionary<NSString *, NSArray<MacroStep *> *> *)compileJoystick:(JoystickAction *)aJoystick options:(GestureCompilerOptions *)aOptions
+{
+    GestureCompilerOptions *opt = aOptions ?: [GestureCompilerOptions defaultOptions];
+    NSMutableDictionary<NSString *, NSArray<MacroStep *> *> *out = [NSMutableDictionary dictionary];
+    
+    CGFloat cx = [aJoystick centerX];
+    CGFloat cy = [aJoystick centerY];
+    CGFloat r = [aJoystick radius];
+    NSInteger ramp = MAX(opt.minStepDelayMs, [aJoystick rampMs]);
+    
+    NSArray *dirs = @[
+        @[ [aJoystick upKey] ?: @"null",    @(0),  @(-1) ],
+        @[ [aJoystick downKey] ?: @"null",  @(0),  @(1)  ],
+        @[ [aJoystick leftKey] ?: @"null",  @(-1), @(0)  ],
+        @[ [aJoystick rightKey] ?: @"null", @(1),  @(0)  ],
+    ];
+    
+    for (NSArray *d in dirs)
+    {
+        NSString *key = d[0];
+        if ([key length] == 0 || [key isEqualToString:@"null"]) continue;
+        
+        CGFloat ex = cx + r * [d[1] doubleValue];
+        CGFloat ey = cy + r * [d[2] doubleValue];
+        
+        // 中心按下 → ramp 內推到邊緣 → 停在邊緣按住；不放開，由韌體在方向鍵放開時釋放觸控
+        out[key] = @[
+            [self p_stepWithTouch:MacroTouchHold x:cx y:cy delayMs:ramp screenW:[aJoystick screenW] screenH:[aJoystick screenH] options:opt],
+            [self p_stepWithTouch:MacroTouchHold x:ex y:ey delayMs:0 screenW:[aJoystick screenW] screenH:[aJoystick screenH] options:opt],
+        ];
+    }
+    
+    return out;
+}
+
+@end
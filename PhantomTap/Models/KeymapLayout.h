@@ -0,0 +1,144 @@
+//
+//  KeymapLayout.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/22.
+//
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "KeymapModels.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 每一列的旗標 (取代 orientation 字串 / pressEvent BOOL)
+typedef NS_OPTIONS(uint8_t, KeymapRowFlags)
+{
+    KeymapRowFlagLandscape  = 1 << 0,   // 0: PORTRAIT, 1: LANDSCAPE
+    KeymapRowFlagPressEvent = 1 << 1,
+    KeymapRowFlagHasHosts   = 1 << 2,   // 有指定主機區段 (存在 side table)
+};
+
+/// keyId：標籤表裡的編號 (取代 keyCode 字串)
+static const uint8_t KeymapKeyIdNone = 0;           // @"null"
+static const uint8_t KeymapKeyIdUnknown = 0xFF;     // 不在標籤表裡的字串，原字串存在 side table
+
+/// keyIndex / HID 查不到時的值
+static const uint8_t KeymapNoCode = 0xFF;
+
+
+typedef NS_ENUM(NSInteger, KeymapValidationStatus)
+{
+    KeymapValidationOK = 0,
+    KeymapValidationEmptyKey,           // 有點沒指定按鍵
+    KeymapValidationDuplicateKey,       // 兩個點 (或點與保留鍵) 同一個標籤
+    KeymapValidationUnmappedKey,        // 標籤查不到 keyIndex
+};
+
+typedef struct
+{
+    KeymapValidationStatus status;
+    NSInteger actionId;                 // 出問題的那一列
+    uint8_t keyId;
+} KeymapValidationResult;
+
+
+/// 容器座標 (左上角, points) → 螢幕像素中心點
+/// pixel = (pos + halfSize + offset) × scale，再夾在 [0, max]
+typedef struct
+{
+    CGFloat scale;
+    CGFloat offsetX;
+    CGFloat offsetY;
+    CGFloat halfSize;
+    CGFloat maxX;
+    CGFloat maxY;
+} KeymapPixelTransform;
+
+
+/// 與 UI 無關的佈局核心 (struct-of-arrays)
+///
+/// 每個欄位一條連續陣列：id / keyId / keyIndex / HID / posX / posY / flags，
+/// 驗證、排序、座標換算、打包都只掃這些陣列，不碰 NSString。
+/// TapAction 可以 attach 上來當成某一列的 view (見 -[TapAction attachToLayout:])。
+///
+/// 非 thread-safe；欄位指標在下一次新增 / 刪除 / 排序前有效
+@interface KeymapLayout : NSObject
+
+@property (nonatomic) NSInteger screenW;
+@property (nonatomic) NSInteger screenH;
+
+- (instancetype)initWithCapacity:(NSUInteger)aCapacity NS_DESIGNATED_INITIALIZER;
+
+/// 由 TapAction 建立 (不會 attach)
++ (instancetype)layoutWithActions:(NSArray<TapAction *> *)aActions;
+
+- (NSUInteger)count;
+
+
+#pragma mark - 標籤表
+
++ (uint8_t)keyIdForLabel:(nullable NSString *)aLabel;
+/// KeymapKeyIdUnknown 沒辦法還原字串，請用 -keyLabelAtRow:
++ (NSString *)labelForKeyId:(uint8_t)aKeyId;
++ (uint8_t)keyIndexForKeyId:(uint8_t)aKeyId;
++ (uint8_t)hidCodeForKeyId:(uint8_t)aKeyId;
+
+
+#pragma mark - Rows
+
+/// 新增一列，回傳 row；id 已存在時更新該列，id 超出 int32 範圍或配置失敗時回傳 NSNotFound
+- (NSUInteger)addRowWithId:(NSInteger)aActionId posX:(CGFloat)aPosX posY:(CGFloat)aPosY keyLabel:(nullable NSString *)aLabel flags:(KeymapRowFlags)aFlags;
+/// 刪除一列 (最後一列搬到空位，O(1))
+- (void)removeRowWithId:(NSInteger)aActionId;
+- (void)removeAllRows;
+
+/// 沒有時回傳 NSNotFound
+- (NSUInteger)rowForId:(NSInteger)aActionId;
+
+- (const int32_t *)ids;
+- (const uint8_t *)keyIds;
+- (const uint8_t *)keyIndices;
+- (const uint8_t *)hidCodes;
+- (const float *)posXs;
+- (const float *)posYs;
+- (const KeymapRowFlags *)flags;
+
+- (NSString *)keyLabelAtRow:(NSUInteger)aRow;
+- (void)setKeyLabel:(nullable NSString *)aLabel atRow:(NSUInteger)aRow;
+- (void)setPosX:(CGFloat)aPosX posY:(CGFloat)aPosY atRow:(NSUInteger)aRow;
+- (void)setFlags:(KeymapRowFlags)aFlags atRow:(NSUInteger)aRow;
+
+/// 主機區段 (Android / Windows / iOS)，沒指定的為 nil
+- (nullable HostPayload *)hostPayload:(HostOS)aHost atRow:(NSUInteger)aRow;
+- (void)setHostPayload:(nullable HostPayload *)aPayload host:(HostOS)aHost atRow:(NSUInteger)aRow;
+
+
+#pragma mark - Bulk
+
+/// 與舊版 -onWriteToKeyboard 相同的規則與順序：空鍵 / 重複標籤 (依列順序，再加上 aReservedLabels) → 查不到 keyIndex (id 最小的)
+- (KeymapValidationResult)validateReservingLabels:(nullable NSArray<NSString *> *)aReservedLabels;
+
+/// 依 id 由小到大重排所有欄位
+- (void)sortById;
+
+/// 把每一列換成螢幕像素中心點 (aOutX / aOutY 至少 count 個)
+- (void)pixelCentersWithTransform:(KeymapPixelTransform)aTransform outX:(int32_t *)aOutX outY:(int32_t *)aOutY;
+
+/// 轉回獨立的 TapAction (未 attach)
+- (NSArray<TapAction *> *)tapActions;
+
+
+#pragma mark - Memory
+
+/// 每列的欄位大小 (bytes)，不含 side table
++ (size_t)bytesPerRow;
+/// 目前配置的總大小 (含預留容量與 id → row 索引)
+- (size_t)allocatedBytes;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
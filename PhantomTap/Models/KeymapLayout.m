@@ -0,0 +1,637 @@
+//
+//  KeymapLayout.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/22.
+//
+
+#import "KeymapLayout.h"
+#import "HidKeyCodeMap.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/// id → row 的 open addressing 表 (linear probing)，負載不超過 1/2
+/// 大小只跟列數有關，跟 id 的值無關
+static const NSUInteger kMinIdSlots = 64;
+
+
+#pragma mark - 標籤表 (keyId ↔ label / keyIndex / HID)
+
+static NSArray<NSString *> *s_labels;                       // keyId - 1 → label
+static NSDictionary<NSString *, NSNumber *> *s_keyIdByLabel;
+static uint8_t s_keyIndexById[256];
+static uint8_t s_hidById[256];
+
+static void KeymapLayoutBuildKeyTable(void)
+{
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        NSMutableSet<NSString *> *all = [NSMutableSet setWithArray:[[HidKeyCodeMap keyIndexMap] allKeys]];
+        [all addObjectsFromArray:[[HidKeyCodeMap hidKeyCodeMap] allKeys]];
+        NSArray<NSString *> *labels = [[all allObjects] sortedArrayUsingSelector:@selector(compare:)];
+        NSCAssert([labels count] < KeymapKeyIdUnknown - 1, @"key table overflow");
+
+        memset(s_keyIndexById, KeymapNoCode, sizeof(s_keyIndexById));
+        memset(s_hidById, KeymapNoCode, sizeof(s_hidById));
+
+        NSMutableDictionary<NSString *, NSNumber *> *byLabel = [NSMutableDictionary dictionaryWithCapacity:[labels count]];
+        [labels enumerateObjectsUsingBlock:^(NSString *label, NSUInteger idx, BOOL *stop) {
+            uint8_t keyId = (uint8_t)(idx + 1);
+            byLabel[label] = @(keyId);
+
+            NSNumber *ki = [HidKeyCodeMap keyIndexForLabel:label];
+            NSNumber *hid = [HidKeyCodeMap hidCodeForLabel:label];
+            if (ki) s_keyIndexById[keyId] = (uint8_t)[ki unsignedIntValue];
+            if (hid) s_hidById[keyId] = (uint8_t)[hid unsignedIntValue];
+        }];
+
+        s_labels = labels;
+        s_keyIdByLabel = byLabel;
+    });
+}
+
+
+typedef struct
+{
+    int32_t id;
+    uint32_t row;
+} KeymapSortPair;
+
+static int KeymapSortPairCompare(const void *a, const void *b)
+{
+    int32_t ia = ((const KeymapSortPair *)a) -> id;
+    int32_t ib = ((const KeymapSortPair *)b) -> id;
+    return (ia > ib) - (ia < ib);
+}
+
+
+typedef struct
+{
+    int32_t id;
+    int32_t row;        // < 0 表示空的 slot
+} KeymapIdSlot;
+
+static inline NSUInteger KeymapIdHash(int32_t aId, NSUInteger aMask)
+{
+    return (NSUInteger)((uint32_t)aId * 2654435761u) & aMask;
+}
+
+
+@interface KeymapLayout ()
+{
+    NSUInteger _count;
+    NSUInteger _capacity;
+
+    int32_t *_ids;
+    uint8_t *_keyIds;
+    uint8_t *_keyIndices;
+    uint8_t *_hidCodes;
+    float *_posX;
+    float *_posY;
+    KeymapRowFlags *_flags;
+
+    KeymapIdSlot *_idSlots;         // id → row
+    NSUInteger _idSlotMask;         // slot 數 - 1 (2 的次方)
+
+    // side tables：只有少數列會用到
+    NSMutableDictionary<NSNumber *, NSString *> *_unknownLabels;        // id → 原字串
+    NSMutableDictionary<NSNumber *, NSMutableArray *> *_hostPayloads;   // id → [Android, Windows, iOS] (NSNull 為未指定)
+}
+@end
+
+@implementation KeymapLayout
+
+- (instancetype)initWithCapacity:(NSUInteger)aCapacity
+{
+    self = [super init];
+    if (!self) return nil;
+
+    KeymapLayoutBuildKeyTable();
+
+    _unknownLabels = [NSMutableDictionary dictionary];
+    _hostPayloads = [NSMutableDictionary dictionary];
+    if (![self p_reserve:MAX(aCapacity, (NSUInteger)16)] || ![self p_growIdSlotsFor:MAX(aCapacity, (NSUInteger)16)]) return nil;
+
+    return self;
+}
+
++ (instancetype)layoutWithActions:(NSArray<TapAction *> *)aActions
+{
+    KeymapLayout *layout = [[self alloc] initWithCapacity:[aActions count]];
+    TapAction *first = [aActions firstObject];
+    layout.screenW = [first screenW];
+    layout.screenH = [first screenH];
+
+    for (TapAction *ta in aActions)
+    {
+        KeymapRowFlags f = 0;
+        if ([[ta orientation] isEqualToString:@"LANDSCAPE"]) f |= KeymapRowFlagLandscape;
+        if ([ta isPressEvent]) f |= KeymapRowFlagPressEvent;
+
+        NSUInteger row = [layout addRowWithId:[ta actionId] posX:[ta posX] posY:[ta posY] keyLabel:[ta keyCode] flags:f];
+        if (row == NSNotFound) continue;
+
+        for (HostOS os = HostOSAndroid; os <= HostOSIOS; os++)
+        {
+            HostPayload *hp = [ta payloadForHost:os];
+            if (hp) [layout setHostPayload:hp host:os atRow:row];
+        }
+    }
+    return layout;
+}
+
+- (void)dealloc
+{
+    free(_ids);
+    free(_keyIds);
+    free(_keyIndices);
+    free(_hidCodes);
+    free(_posX);
+    free(_posY);
+    free(_flags);
+    free(_idSlots);
+}
+
+- (NSUInteger)count
+{
+    return self -> _count;
+}
+
+
+#pragma mark - 標籤表
+
++ (uint8_t)keyIdForLabel:(nullable NSString *)aLabel
+{
+    KeymapLayoutBuildKeyTable();
+    if ([aLabel length] == 0 || [aLabel isEqualToString:@"null"]) return KeymapKeyIdNone;
+
+    NSNumber *keyId = s_keyIdByLabel[aLabel];
+    return keyId ? (uint8_t)[keyId unsignedIntValue] : KeymapKeyIdUnknown;
+}
+
++ (NSString *)labelForKeyId:(uint8_t)aKeyId
+{
+    KeymapLayoutBuildKeyTable();
+    if (aKeyId == KeymapKeyIdNone || aKeyId == KeymapKeyIdUnknown || aKeyId > [s_labels count]) return @"null";
+    return s_labels[aKeyId - 1];
+}
+
++ (uint8_t)keyIndexForKeyId:(uint8_t)aKeyId
+{
+    KeymapLayoutBuildKeyTable();
+    return s_keyIndexById[aKeyId];
+}
+
++ (uint8_t)hidCodeForKeyId:(uint8_t)aKeyId
+{
+    KeymapLayoutBuildKeyTable();
+    return s_hidById[aKeyId];
+}
+
+
+#pragma mark - Storage
+
+/// 每個欄位都擴到 aCapacity；任何一個配置失敗時回傳 NO，已擴好的欄位照用 (容量仍以舊值計)
+- (BOOL)p_reserve:(NSUInteger)aCapacity
+{
+    if (aCapacity <= self -> _capacity) return YES;
+
+#define KEYMAP_GROW(col, type) \
+    do { \
+        type *p = realloc(self -> col, aCapacity * sizeof(type)); \
+        if (!p) return NO; \
+        self -> col = p; \
+    } while (0)
+
+    KEYMAP_GROW(_ids, int32_t);
+    KEYMAP_GROW(_keyIds, uint8_t);
+    KEYMAP_GROW(_keyIndices, uint8_t);
+    KEYMAP_GROW(_hidCodes, uint8_t);
+    KEYMAP_GROW(_posX, float);
+    KEYMAP_GROW(_posY, float);
+    KEYMAP_GROW(_flags, KeymapRowFlags);
+
+#undef KEYMAP_GROW
+
+    self -> _capacity = aCapacity;
+    return YES;
+}
+
+/// 讓 id 表放得下 aRows 列 (負載 <= 1/2)；配置失敗時回傳 NO，舊表不動
+- (BOOL)p_growIdSlotsFor:(NSUInteger)aRows
+{
+    NSUInteger oldSlots = self -> _idSlots ? self -> _idSlotMask + 1 : 0;
+    if (aRows * 2 <= oldSlots) return YES;
+
+    NSUInteger slots = MAX(oldSlots, kMinIdSlots);
+    while (slots < aRows * 2) slots *= 2;
+
+    KeymapIdSlot *table = malloc(slots * sizeof(KeymapIdSlot));
+    if (!table) return NO;
+    memset(table, 0xFF, slots * sizeof(KeymapIdSlot));
+
+    NSUInteger mask = slots - 1;
+    for (NSUInteger i = 0; i < oldSlots; i++)
+    {
+        KeymapIdSlot e = self -> _idSlots[i];
+        if (e.row < 0) continue;
+
+        NSUInteger j = KeymapIdHash(e.id, mask);
+        while (table[j].row >= 0) j = (j + 1) & mask;
+        table[j] = e;
+    }
+
+    free(self -> _idSlots);
+    self -> _idSlots = table;
+    self -> _idSlotMask = mask;
+    return YES;
+}
+
+/// 找 id 所在的 slot，沒有時回傳 NSNotFound
+- (NSUInteger)p_slotForId:(int32_t)aActionId
+{
+    NSUInteger mask = self -> _idSlotMask;
+    for (NSUInteger i = KeymapIdHash(aActionId, mask); ; i = (i + 1) & mask)
+    {
+        if (self -> _idSlots[i].row < 0) return NSNotFound;
+        if (self -> _idSlots[i].id == aActionId) return i;
+    }
+}
+
+/// 新增或更新 id → row (新增前要先確認 p_growIdSlotsFor: 成功)
+- (void)p_setRow:(NSUInteger)aRow forId:(int32_t)aActionId
+{
+    NSUInteger mask = self -> _idSlotMask;
+    NSUInteger i = KeymapIdHash(aActionId, mask);
+    while (self -> _idSlots[i].row >= 0 && self -> _idSlots[i].id != aActionId) i = (i + 1) & mask;
+
+    self -> _idSlots[i].id = aActionId;
+    self -> _idSlots[i].row = (int32_t)aRow;
+}
+
+/// 移除 id；後面同一串的 slot 往前補位，不留墓碑
+- (void)p_removeId:(int32_t)aActionId
+{
+    NSUInteger i = [self p_slotForId:aActionId];
+    if (i == NSNotFound) return;
+
+    NSUInteger mask = self -> _idSlotMask;
+    NSUInteger j = i;
+    for (;;)
+    {
+        j = (j + 1) & mask;
+        if (self -> _idSlots[j].row < 0) break;
+
+        // j 的理想位置 k 不在 (i, j] 之間時才能搬到 i
+        NSUInteger k = KeymapIdHash(self -> _idSlots[j].id, mask);
+        BOOL between = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (between) continue;
+
+        self -> _idSlots[i] = self -> _idSlots[j];
+        i = j;
+    }
+    self -> _idSlots[i].row = -1;
+}
+
+- (NSUInteger)rowForId:(NSInteger)aActionId
+{
+    if (aActionId < INT32_MIN || aActionId > INT32_MAX) return NSNotFound;
+
+    NSUInteger slot = [self p_slotForId:(int32_t)aActionId];
+    return (slot == NSNotFound) ? NSNotFound : (NSUInteger)self -> _idSlots[slot].row;
+}
+
+
+#pragma mark - Rows
+
+- (NSUInteger)addRowWithId:(NSInteger)aActionId posX:(CGFloat)aPosX posY:(CGFloat)aPosY keyLabel:(nullable NSString *)aLabel flags:(KeymapRowFlags)aFlags
+{
+    if (aActionId < INT32_MIN || aActionId > INT32_MAX) return NSNotFound;
+
+    NSUInteger row = [self rowForId:aActionId];
+    if (row == NSNotFound)
+    {
+        if (self -> _count == self -> _capacity && ![self p_reserve:self -> _capacity * 2]) return NSNotFound;
+        if (![self p_growIdSlotsFor:self -> _count + 1]) return NSNotFound;
+
+        row = self -> _count++;
+        self -> _ids[row] = (int32_t)aActionId;
+        [self p_setRow:row forId:(int32_t)aActionId];
+    }
+
+    self -> _posX[row] = (float)aPosX;
+    self -> _posY[row] = (float)aPosY;
+    self -> _flags[row] = aFlags & ~KeymapRowFlagHasHosts;
+    [self setKeyLabel:aLabel atRow:row];
+    [self -> _hostPayloads removeObjectForKey:@(aActionId)];
+
+    return row;
+}
+
+- (void)removeRowWithId:(NSInteger)aActionId
+{
+    NSUInteger row = [self rowForId:aActionId];
+    if (row == NSNotFound) return;
+
+    NSUInteger last = self -> _count - 1;
+    if (row != last)
+    {
+        self -> _ids[row]        = self -> _ids[last];
+        self -> _keyIds[row]     = self -> _keyIds[last];
+        self -> _keyIndices[row] = self -> _keyIndices[last];
+        self -> _hidCodes[row]   = self -> _hidCodes[last];
+        self -> _posX[row]       = self -> _posX[last];
+        self -> _posY[row]       = self -> _posY[last];
+        self -> _flags[row]      = self -> _flags[last];
+        [self p_setRow:row forId:self -> _ids[row]];
+    }
+    self -> _count--;
+
+    [self p_removeId:(int32_t)aActionId];
+    [self -> _unknownLabels removeObjectForKey:@(aActionId)];
+    [self -> _hostPayloads removeObjectForKey:@(aActionId)];
+}
+
+- (void)removeAllRows
+{
+    memset(self -> _idSlots, 0xFF, (self -> _idSlotMask + 1) * sizeof(KeymapIdSlot));
+    self -> _count = 0;
+    [self -> _unknownLabels removeAllObjects];
+    [self -> _hostPayloads removeAllObjects];
+}
+
+- (const int32_t *)ids                  { return self -> _ids; }
+- (const uint8_t *)keyIds               { return self -> _keyIds; }
+- (const uint8_t *)keyIndices           { return self -> _keyIndices; }
+- (const uint8_t *)hidCodes             { return self -> _hidCodes; }
+- (const float *)posXs                  { return self -> _posX; }
+- (const float *)posYs                  { return self -> _posY; }
+- (const KeymapRowFlags *)flags         { return self -> _flags; }
+
+- (NSString *)keyLabelAtRow:(NSUInteger)aRow
+{
+    uint8_t keyId = self -> _keyIds[aRow];
+    if (keyId == KeymapKeyIdUnknown)
+    {
+        return self -> _unknownLabels[@(self -> _ids[aRow])] ?: @"null";
+    }
+    return [KeymapLayout labelForKeyId:keyId];
+}
+
+- (void)setKeyLabel:(nullable NSString *)aLabel atRow:(NSUInteger)aRow
+{
+    uint8_t keyId = [KeymapLayout keyIdForLabel:aLabel];
+    NSNumber *idKey = @(self -> _ids[aRow]);
+
+    self -> _keyIds[aRow] = keyId;
+    self -> _keyIndices[aRow] = s_keyIndexById[keyId];
+    self -> _hidCodes[aRow] = s_hidById[keyId];
+
+    if (keyId == KeymapKeyIdUnknown)
+    {
+        self -> _unknownLabels[idKey] = [aLabel copy];
+    }
+    else
+    {
+        [self -> _unknownLabels removeObjectForKey:idKey];
+    }
+}
+
+- (void)setPosX:(CGFloat)aPosX posY:(CGFloat)aPosY atRow:(NSUInteger)aRow
+{
+    self -> _posX[aRow] = (float)aPosX;
+    self -> _posY[aRow] = (float)aPosY;
+}
+
+- (void)setFlags:(KeymapRowFlags)aFlags atRow:(NSUInteger)aRow
+{
+    // HasHosts 由 side table 維護
+    self -> _flags[aRow] = (aFlags & ~KeymapRowFlagHasHosts) | (self -> _flags[aRow] & KeymapRowFlagHasHosts);
+}
+
+- (nullable HostPayload *)hostPayload:(HostOS)aHost atRow:(NSUInteger)aRow
+{
+    if (!(self -> _flags[aRow] & KeymapRowFlagHasHosts)) return nil;
+
+    id hp = self -> _hostPayloads[@(self -> _ids[aRow])][(NSUInteger)aHost];
+    return (hp == [NSNull null]) ? nil : hp;
+}
+
+- (void)setHostPayload:(nullable HostPayload *)aPayload host:(HostOS)aHost atRow:(NSUInteger)aRow
+{
+    NSNumber *idKey = @(self -> _ids[aRow]);
+    NSMutableArray *hosts = self -> _hostPayloads[idKey];
+    if (!hosts)
+    {
+        if (!aPayload) return;
+        hosts = [NSMutableArray arrayWithObjects:[NSNull null], [NSNull null], [NSNull null], nil];
+        self -> _hostPayloads[idKey] = hosts;
+    }
+    hosts[(NSUInteger)aHost] = aPayload ?: [NSNull null];
+
+    if ([hosts indexOfObjectPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) { return obj != [NSNull null]; }] == NSNotFound)
+    {
+        [self -> _hostPayloads removeObjectForKey:idKey];
+        self -> _flags[aRow] &= ~KeymapRowFlagHasHosts;
+    }
+    else
+    {
+        self -> _flags[aRow] |= KeymapRowFlagHasHosts;
+    }
+}
+
+
+#pragma mark - Bulk
+
+- (KeymapValidationResult)validateReservingLabels:(nullable NSArray<NSString *> *)aReservedLabels
+{
+    KeymapValidationResult result = { KeymapValidationOK, -1, KeymapKeyIdNone };
+
+    // 重複看的是標籤：標籤表內的用 keyId bitmap，表外的字串另外比
+    uint64_t used[4] = { 0, 0, 0, 0 };
+    NSMutableSet<NSString *> *usedUnknown = nil;
+
+    for (NSUInteger row = 0; row < self -> _count; row++)
+    {
+        uint8_t keyId = self -> _keyIds[row];
+        if (keyId == KeymapKeyIdNone)
+        {
+            return (KeymapValidationResult){ KeymapValidationEmptyKey, self -> _ids[row], keyId };
+        }
+
+        if (keyId == KeymapKeyIdUnknown)
+        {
+            NSString *label = [self keyLabelAtRow:row];
+            if ([usedUnknown containsObject:label])
+            {
+                return (KeymapValidationResult){ KeymapValidationDuplicateKey, self -> _ids[row], keyId };
+            }
+            if (!usedUnknown) usedUnknown = [NSMutableSet set];
+            [usedUnknown addObject:label];
+            continue;
+        }
+
+        uint64_t bit = 1ULL << (keyId & 63);
+        if (used[keyId >> 6] & bit)
+        {
+            return (KeymapValidationResult){ KeymapValidationDuplicateKey, self -> _ids[row], keyId };
+        }
+        used[keyId >> 6] |= bit;
+    }
+
+    for (NSString *label in aReservedLabels)
+    {
+        uint8_t keyId = [KeymapLayout keyIdForLabel:label];
+        if (keyId == KeymapKeyIdNone) continue;
+
+        if (keyId == KeymapKeyIdUnknown)
+        {
+            if ([usedUnknown containsObject:label])
+            {
+                return (KeymapValidationResult){ KeymapValidationDuplicateKey, -1, keyId };
+            }
+            if (!usedUnknown) usedUnknown = [NSMutableSet set];
+            [usedUnknown addObject:label];
+            continue;
+        }
+
+        uint64_t bit = 1ULL << (keyId & 63);
+        if (used[keyId >> 6] & bit)
+        {
+            return (KeymapValidationResult){ KeymapValidationDuplicateKey, -1, keyId };
+        }
+        used[keyId >> 6] |= bit;
+    }
+
+    // 查不到 keyIndex：跟舊版逐一打包時一樣，回報 id 最小的那一列
+    for (NSUInteger row = 0; row < self -> _count; row++)
+    {
+        if (self -> _keyIndices[row] != KeymapNoCode) continue;
+        if (result.status == KeymapValidationOK || self -> _ids[row] < result.actionId)
+        {
+            result = (KeymapValidationResult){ KeymapValidationUnmappedKey, self -> _ids[row], self -> _keyIds[row] };
+        }
+    }
+
+    return result;
+}
+
+- (void)sortById
+{
+    NSUInteger n = self -> _count;
+    if (n < 2) return;
+
+    KeymapSortPair *pairs = malloc(n * sizeof(KeymapSortPair));
+    void *tmp = malloc(n * sizeof(float));
+    if (!pairs || !tmp)
+    {
+        // 配置失敗：維持原順序
+        free(pairs);
+        free(tmp);
+        return;
+    }
+
+    BOOL sorted = YES;
+    for (NSUInteger i = 0; i < n; i++)
+    {
+        pairs[i].id = self -> _ids[i];
+        pairs[i].row = (uint32_t)i;
+        if (i > 0 && self -> _ids[i - 1] > self -> _ids[i]) sorted = NO;
+    }
+    if (sorted)
+    {
+        free(pairs);
+        free(tmp);
+        return;
+    }
+
+    qsort(pairs, n, sizeof(KeymapSortPair), KeymapSortPairCompare);
+
+    // 用同一塊暫存區依序重排每個欄位
+
+#define KEYMAP_PERMUTE(col, type) \
+    do { \
+        type *dst = (type *)tmp; \
+        for (NSUInteger i = 0; i < n; i++) dst[i] = self -> col[pairs[i].row]; \
+        memcpy(self -> col, dst, n * sizeof(type)); \
+    } while (0)
+
+    KEYMAP_PERMUTE(_ids, int32_t);
+    KEYMAP_PERMUTE(_keyIds, uint8_t);
+    KEYMAP_PERMUTE(_keyIndices, uint8_t);
+    KEYMAP_PERMUTE(_hidCodes, uint8_t);
+    KEYMAP_PERMUTE(_posX, float);
+    KEYMAP_PERMUTE(_posY, float);
+    KEYMAP_PERMUTE(_flags, KeymapRowFlags);
+
+#undef KEYMAP_PERMUTE
+
+    free(tmp);
+    free(pairs);
+
+    for (NSUInteger i = 0; i < n; i++)
+    {
+        [self p_setRow:i forId:self -> _ids[i]];
+    }
+}
+
+- (void)pixelCentersWithTransform:(KeymapPixelTransform)aTransform outX:(int32_t *)aOutX outY:(int32_t *)aOutY
+{
+    const float s = (float)aTransform.scale;
+    const float ox = (float)(aTransform.offsetX + aTransform.halfSize);
+    const float oy = (float)(aTransform.offsetY + aTransform.halfSize);
+    const float maxX = (float)aTransform.maxX;
+    const float maxY = (float)aTransform.maxY;
+
+    for (NSUInteger i = 0; i < self -> _count; i++)
+    {
+        float x = (self -> _posX[i] + ox) * s;
+        float y = (self -> _posY[i] + oy) * s;
+        x = (x < 0.0f) ? 0.0f : (x > maxX ? maxX : x);
+        y = (y < 0.0f) ? 0.0f : (y > maxY ? maxY : y);
+        aOutX[i] = (int32_t)lrintf(x);
+        aOutY[i] = (int32_t)lrintf(y);
+    }
+}
+
+- (NSArray<TapAction *> *)tapActions
+{
+    NSMutableArray<TapAction *> *list = [NSMutableArray arrayWithCapacity:self -> _count];
+    for (NSUInteger row = 0; row < self -> _count; row++)
+    {
+        KeymapRowFlags f = self -> _flags[row];
+        TapAction *ta = [[TapAction alloc] initWithId:self -> _ids[row]
+                                          orientation:(f & KeymapRowFlagLandscape) ? @"LANDSCAPE" : @"PORTRAIT"
+                                              screenW:self.screenW
+                                              screenH:self.screenH
+                                                 posX:self -> _posX[row]
+                                                 posY:self -> _posY[row]
+                                              keyCode:[self keyLabelAtRow:row]
+                                           pressEvent:(f & KeymapRowFlagPressEvent) != 0];
+        if (f & KeymapRowFlagHasHosts)
+        {
+            for (HostOS os = HostOSAndroid; os <= HostOSIOS; os++)
+            {
+                [ta setPayload:[self hostPayload:os atRow:row] forHost:os];
+            }
+        }
+        [list addObject:ta];
+    }
+    return list;
+}
+
+
+#pragma mark - Memory
+
++ (size_t)bytesPerRow
+{
+    return sizeof(int32_t) + 3 * sizeof(uint8_t) + 2 * sizeof(float) + sizeof(KeymapRowFlags);
+}
+
+- (size_t)allocatedBytes
+{
+    return self -> _capacity * [KeymapLayout bytesPerRow] + (self -> _idSlotMask + 1) * sizeof(KeymapIdSlot);
+}
+
+@end
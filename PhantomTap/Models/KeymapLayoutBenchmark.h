@@ -0,0 +1,36 @@
+//
+//  KeymapLayoutBenchmark.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/22.
+//
+//  只在 DEBUG build 編進去 (用到 malloc_size 等私有量測)，release 不帶
+//
+
+#if DEBUG
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// 比較 TapAction 陣列 (舊路徑) 與 KeymapLayout (欄位陣列) 的記憶體與 validate / sort / encode 時間
+///
+/// 一份設定最多只能用到標籤表裡有 keyIndex 的鍵，所以 aActionCount 會切成多份
+/// 「每份都不重複」的設定逐份跑，總列數 = aActionCount
+@interface KeymapLayoutBenchmark : NSObject
+
+/// 回傳:
+///   actions, profiles,
+///   legacyBytesPerAction, layoutBytesPerAction (兩邊都是建立前後 malloc 使用量的差 ÷ aActionCount),
+///   legacyValidateMs, legacySortMs, legacyEncodeMs,
+///   layoutValidateMs, layoutSortMs, layoutEncodeMs
++ (NSDictionary<NSString *, NSNumber *> *)runWithActionCount:(NSUInteger)aActionCount;
+
+/// 1k / 10k / 100k 各跑一次並印 log
++ (void)runDefaultSuite;
+
+@end
+
+NS_ASSUME_NONNULL_END
+
+#endif
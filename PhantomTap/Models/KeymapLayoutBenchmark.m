@@ -0,0 +1,210 @@
+//
+//  KeymapLayoutBenchmark.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/22.
+//
+
+#import "KeymapLayoutBenchmark.h"
+
+#if DEBUG
+
+#import "KeymapLayout.h"
+#import "KeymapModels.h"
+#import "HidKeyCodeMap.h"
+#import "BluetoothPacketBuilder.h"
+#import "BTMetrics.h"
+#import <malloc/malloc.h>
+
+// 與寫入時的換算一致 (iPhone 3x、按鍵 56pt)
+static const CGFloat kBenchScale = 3.0;
+static const CGFloat kBenchHalfSize = 28.0;
+static const CGFloat kBenchMaxX = 1179.0 - 1;
+static const CGFloat kBenchMaxY = 2556.0 - 1;
+
+@implementation KeymapLayoutBenchmark
+
+/// 目前所有 malloc zone 使用中的 bytes；兩邊都用「建立前後的差」量，包含字串、NSNumber、陣列、side table
++ (size_t)p_heapInUse
+{
+    malloc_statistics_t stats;
+    malloc_zone_statistics(NULL, &stats);
+    return stats.size_in_use;
+}
+
+/// keyIndex 不重複的標籤 (一份設定最多這麼多顆)
++ (NSArray<NSString *> *)p_uniqueLabels
+{
+    NSDictionary<NSString *, NSNumber *> *map = [HidKeyCodeMap keyIndexMap];
+    NSMutableSet<NSNumber *> *seen = [NSMutableSet set];
+    NSMutableArray<NSString *> *labels = [NSMutableArray array];
+    for (NSString *label in [[map allKeys] sortedArrayUsingSelector:@selector(compare:)])
+    {
+        if ([seen containsObject:map[label]]) continue;
+        [seen addObject:map[label]];
+        [labels addObject:label];
+    }
+    return labels;
+}
+
+/// 打亂順序的一份設定 (id 不連續，才有東西可排)
++ (NSArray<TapAction *> *)p_profileWithLabels:(NSArray<NSString *> *)aLabels count:(NSUInteger)aCount baseId:(NSInteger)aBaseId
+{
+    NSMutableArray<TapAction *> *list = [NSMutableArray arrayWithCapacity:aCount];
+    for (NSUInteger i = 0; i < aCount; i++)
+    {
+        NSInteger actionId = aBaseId + (NSInteger)((i * 7919) % aCount);
+        TapAction *ta = [[TapAction alloc] initWithId:actionId
+                                          orientation:@"PORTRAIT"
+                                              screenW:1179
+                                              screenH:2556
+                                                 posX:(CGFloat)arc4random_uniform(360)
+                                                 posY:(CGFloat)arc4random_uniform(800)
+                                              keyCode:aLabels[i]
+                                           pressEvent:NO];
+        [list addObject:ta];
+    }
+    return list;
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)runWithActionCount:(NSUInteger)aActionCount
+{
+    NSArray<NSString *> *labels = [self p_uniqueLabels];
+    NSUInteger perProfile = MIN([labels count], MAX(aActionCount, (NSUInteger)1));
+
+    // ===== 記憶體：建立前後的 heap 差 (暫時物件在 autorelease pool 結束後才量) =====
+    NSMutableArray<NSArray<TapAction *> *> *profiles = [NSMutableArray array];
+    size_t heap0 = [self p_heapInUse];
+    @autoreleasepool
+    {
+        NSUInteger remaining = aActionCount;
+        NSInteger baseId = 0;
+        while (remaining > 0)
+        {
+            NSUInteger n = MIN(perProfile, remaining);
+            [profiles addObject:[self p_profileWithLabels:labels count:n baseId:baseId]];
+            baseId += (NSInteger)n;
+            remaining -= n;
+        }
+    }
+    size_t heap1 = [self p_heapInUse];
+
+    NSMutableArray<KeymapLayout *> *layouts = [NSMutableArray arrayWithCapacity:[profiles count]];
+    size_t heap2 = [self p_heapInUse];
+    @autoreleasepool
+    {
+        for (NSArray<TapAction *> *p in profiles)
+        {
+            [layouts addObject:[KeymapLayout layoutWithActions:p]];
+        }
+    }
+    size_t heap3 = [self p_heapInUse];
+
+    size_t legacyBytes = (heap1 > heap0) ? heap1 - heap0 : 0;
+    size_t layoutBytes = (heap3 > heap2) ? heap3 - heap2 : 0;
+
+    // ===== 舊路徑：字串 set 驗證 → 物件排序 → 逐一查表打包 =====
+    double legacyValidateMs = 0, legacySortMs = 0, legacyEncodeMs = 0;
+    NSUInteger legacyFrames = 0;
+    for (NSArray<TapAction *> *p in profiles)
+    {
+        double t0 = [BTMetrics nowMs];
+        NSMutableSet<NSString *> *keys = [NSMutableSet set];
+        for (TapAction *ta in p)
+        {
+            NSString *k = [ta keyCode] ?: @"null";
+            if ([k isEqualToString:@"null"] || [keys containsObject:k]) break;
+            [keys addObject:k];
+        }
+
+        double t1 = [BTMetrics nowMs];
+        NSArray<TapAction *> *ordered = [p sortedArrayUsingComparator:^NSComparisonResult(TapAction *a, TapAction *b) {
+            return (a.actionId < b.actionId) ? NSOrderedAscending :
+                   (a.actionId > b.actionId) ? NSOrderedDescending : NSOrderedSame;
+        }];
+
+        double t2 = [BTMetrics nowMs];
+        for (TapAction *ta in ordered)
+        {
+            NSNumber *keyIndexNum = [HidKeyCodeMap keyIndexForLabel:[ta keyCode]];
+            NSNumber *hidCodeNum = [HidKeyCodeMap hidCodeForLabel:[ta keyCode]];
+            if (!keyIndexNum) continue;
+
+            NSInteger x = (NSInteger)lrint(MAX(0, MIN(([ta posX] + kBenchHalfSize) * kBenchScale, kBenchMaxX)));
+            NSInteger y = (NSInteger)lrint(MAX(0, MIN(([ta posY] + kBenchHalfSize) * kBenchScale, kBenchMaxY)));
+            NSData *pkt = [BluetoothPacketBuilder buildKeyMappingPacketWithKeyIndex:[keyIndexNum integerValue]
+                                                                            keyCode:(hidCodeNum ? [hidCodeNum integerValue] : 0)
+                                                                                  x:x
+                                                                                  y:y
+                                                                       hostPayloads:[ta hostPayloads]];
+            if (pkt) legacyFrames++;
+        }
+        double t3 = [BTMetrics nowMs];
+
+        legacyValidateMs += t1 - t0;
+        legacySortMs += t2 - t1;
+        legacyEncodeMs += t3 - t2;
+    }
+
+    // ===== Layout 路徑 =====
+    KeymapPixelTransform transform = { kBenchScale, 0, 0, kBenchHalfSize, kBenchMaxX, kBenchMaxY };
+    double layoutValidateMs = 0, layoutSortMs = 0, layoutEncodeMs = 0;
+    NSUInteger layoutFrames = 0;
+    for (KeymapLayout *l in layouts)
+    {
+        double t0 = [BTMetrics nowMs];
+        KeymapValidationResult r = [l validateReservingLabels:nil];
+        double t1 = [BTMetrics nowMs];
+        [l sortById];
+        double t2 = [BTMetrics nowMs];
+        layoutFrames += [[BluetoothPacketBuilder buildKeyMappingFramesForLayout:l transform:transform] count];
+        double t3 = [BTMetrics nowMs];
+
+        if (r.status != KeymapValidationOK)
+        {
+            NSLog(@"[BENCH] unexpected validation status=%ld id=%ld", (long)r.status, (long)r.actionId);
+        }
+
+        layoutValidateMs += t1 - t0;
+        layoutSortMs += t2 - t1;
+        layoutEncodeMs += t3 - t2;
+    }
+
+    if (legacyFrames != layoutFrames)
+    {
+        NSLog(@"[BENCH] frame count mismatch legacy=%lu layout=%lu", (unsigned long)legacyFrames, (unsigned long)layoutFrames);
+    }
+
+    double n = (double)MAX(aActionCount, (NSUInteger)1);
+    return @{
+        @"actions": @(aActionCount),
+        @"profiles": @([profiles count]),
+        @"legacyBytesPerAction": @((double)legacyBytes / n),
+        @"layoutBytesPerAction": @((double)layoutBytes / n),
+        @"legacyValidateMs": @(legacyValidateMs),
+        @"legacySortMs": @(legacySortMs),
+        @"legacyEncodeMs": @(legacyEncodeMs),
+        @"layoutValidateMs": @(layoutValidateMs),
+        @"layoutSortMs": @(layoutSortMs),
+        @"layoutEncodeMs": @(layoutEncodeMs),
+    };
+}
+
++ (void)runDefaultSuite
+{
+    for (NSNumber *count in @[ @1000, @10000, @100000 ])
+    {
+        @autoreleasepool
+        {
+            NSDictionary<NSString *, NSNumber *> *r = [self runWithActionCount:[count unsignedIntegerValue]];
+            NSLog(@"[BENCH] n=%@ (%@ profiles) bytes/action legacy=%.1f layout=%.1f", r[@"actions"], r[@"profiles"], [r[@"legacyBytesPerAction"] doubleValue], [r[@"layoutBytesPerAction"] doubleValue]);
+            NSLog(@"[BENCH]   validate legacy=%.2fms layout=%.2fms", [r[@"legacyValidateMs"] doubleValue], [r[@"layoutValidateMs"] doubleValue]);
+            NSLog(@"[BENCH]   sort     legacy=%.2fms layout=%.2fms", [r[@"legacySortMs"] doubleValue], [r[@"layoutSortMs"] doubleValue]);
+            NSLog(@"[BENCH]   encode   legacy=%.2fms layout=%.2fms", [r[@"legacyEncodeMs"] doubleValue], [r[@"layoutEncodeMs"] doubleValue]);
+        }
+    }
+}
+
+@end
+
+#endif
@@ -10,6 +10,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class KeymapLayout;
+
 
 /// 對應 Kotlin: enum class KeymapType { DRAGGABLE_TAP, SWIPE }
 typedef NS_ENUM(NSInteger, KeymapType)
@@ -25,6 +27,72 @@ typedef NS_ENUM(NSInteger, KeymapType)
 
 @property (nonatomic, readonly) NSInteger actionId;
 
+- (KeymapType)keymapType;
+
+@end
+
+
+/// 按鍵設定封包 (ID 0x03) 裡的三個 9 bytes 主機區段
+typedef NS_ENUM(NSInteger, HostOS)
+{
+    HostOSAndroid = 0,      // Data3-11
+    HostOSWindows = 1,      // Data12-20
+    HostOSIOS = 2,          // Data21-29
+};
+
+/// 主機區段 Byte 0 的類型 (與巨集步驟的 type 相同)
+typedef NS_ENUM(uint8_t, HostPayloadType)
+{
+    HostPayloadTypeNone = 0x00,
+    HostPayloadTypeMouse = 0x01,            // buttons, dx, dy, wheel
+    HostPayloadTypeKeyboard = 0x02,         // modifiers, HID key code
+    HostPayloadTypeMultimedia = 0x03,       // consumer usage (16 bit)
+    HostPayloadTypeCoordinateTap = 0x04,    // touch, X, Y
+};
+
+
+/// 單一主機要執行的動作 (immutable)
+/// JSON: { "type": "NONE" | "MOUSE" | "KEYBOARD" | "MULTIMEDIA" | "TAP", ... }
+///   MOUSE:      "buttons", "dx", "dy", "wheel"
+///   KEYBOARD:   "modifiers", "hid"
+///   MULTIMEDIA: "usage"
+///   TAP:        "x", "y", "touch"
+@interface HostPayload : NSObject
+
+@property (nonatomic, readonly) HostPayloadType type;
+
+// Mouse
+@property (nonatomic, readonly) uint8_t buttons;        // bit0 左鍵, bit1 右鍵, bit2 中鍵
+@property (nonatomic, readonly) NSInteger deltaX;       // -127 ~ 127
+@property (nonatomic, readonly) NSInteger deltaY;
+@property (nonatomic, readonly) NSInteger wheel;
+
+// Keyboard
+@property (nonatomic, readonly) uint8_t modifiers;      // HID modifier bits
+@property (nonatomic, readonly) uint8_t hidCode;
+
+// Multimedia
+@property (nonatomic, readonly) uint16_t usage;         // HID consumer page usage
+
+// Coordinate tap
+@property (nonatomic, readonly) NSInteger x;
+@property (nonatomic, readonly) NSInteger y;
+@property (nonatomic, readonly) NSInteger touch;        // 同 MacroTouch：0 放開, 1 單次, 2 長按
+
++ (instancetype)none;
++ (instancetype)mouseWithButtons:(uint8_t)aButtons deltaX:(NSInteger)aDX deltaY:(NSInteger)aDY wheel:(NSInteger)aWheel;
++ (instancetype)keyboardWithModifiers:(uint8_t)aModifiers hidCode:(uint8_t)aHidCode;
++ (instancetype)multimediaWithUsage:(uint16_t)aUsage;
++ (instancetype)coordinateTapWithX:(NSInteger)aX y:(NSInteger)aY touch:(NSInteger)aTouch;
+
++ (nullable instancetype)payloadFromJSON:(NSDictionary *)aJSON;
+- (NSDictionary *)toJSON;
+
++ (NSString *)jsonKeyForHost:(HostOS)aHost;     // "android" / "windows" / "ios"
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
 @end
 
 
@@ -40,6 +108,32 @@ typedef NS_ENUM(NSInteger, KeymapType)
 @property (nonatomic, copy) NSString *keyCode;      // 預設 @"null"
 @property (nonatomic, getter=isPressEvent) BOOL pressEvent;
 
+/// 各主機的動作；nil 表示未指定，寫入時為 None (區段全 0，與沒有 "hosts" 的設定檔相同)
+/// JSON: TAP 項目裡的 "hosts": { "android": {...}, "windows": {...}, "ios": {...} }
+@property (nonatomic, strong, nullable) HostPayload *androidPayload;
+@property (nonatomic, strong, nullable) HostPayload *windowsPayload;
+@property (nonatomic, strong, nullable) HostPayload *iosPayload;
+
+- (nullable HostPayload *)payloadForHost:(HostOS)aHost;
+- (void)setPayload:(nullable HostPayload *)aPayload forHost:(HostOS)aHost;
+
+/// 寫入用：依 Android / Windows / iOS 順序回傳三個區段，未指定的主機為 None
+- (NSArray<HostPayload *> *)hostPayloads;
+
+
+/// attach 之後，這個物件只是 layout 裡某一列的 view：只留 (layout, id)，所有屬性都直接讀寫該列
+/// screenW / screenH 為整個 layout 共用，attach 中唯讀 (要改請改 layout)
+/// 該列不可以在 attach 中被別人刪掉 (debug 下 assert)，請先 detachFromLayout
+@property (nonatomic, strong, readonly, nullable) KeymapLayout *layout;
+
+/// 以目前的值新增 (或覆寫) layout 裡同 id 的列並 attach；id 超出 int32 範圍或配置失敗時不 attach
+- (void)attachToLayout:(KeymapLayout *)aLayout;
+/// 把 layout 的值抄回自己後 detach，並從 layout 移除該列
+- (void)detachFromLayout;
+
+/// 不掛在任何 layout 上的複本
+- (TapAction *)detachedCopy;
+
 
 - (instancetype)initWithId:(NSInteger)aActionId orientation:(NSString *)aOrientation screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH posX:(CGFloat)aPosX posY:(CGFloat)aPosY keyCode:(NSString *)aKeyCode pressEvent:(BOOL)aPressEvent NS_DESIGNATED_INITIALIZER;
 
@@ -53,6 +147,85 @@ typedef NS_ENUM(NSInteger, KeymapType)
 @end
 
 
+/// 手勢路徑上的一點：螢幕像素座標 + 相對起點的時間 (ms)
+@interface GesturePoint : NSObject
+
+@property (nonatomic) CGFloat x;
+@property (nonatomic) CGFloat y;
+@property (nonatomic) NSInteger timeMs;
+
++ (instancetype)pointWithX:(CGFloat)aX y:(CGFloat)aY timeMs:(NSInteger)aTimeMs;
+
+@end
+
+
+/// 滑動：按下 key 時，沿著 points 拖曳一次
+/// JSON: { "type": "SWIPE", "id", "key", "points": [ { "x", "y", "t" }, ... ] }
+@interface SwipeAction : NSObject <KeymapAction, NSCopying>
+
+@property (nonatomic, readonly) NSInteger actionId;
+@property (nonatomic) NSInteger screenW;            // 存檔時的螢幕寬 (points 的座標系)
+@property (nonatomic) NSInteger screenH;
+@property (nonatomic, copy) NSString *keyCode;      // 預設 @"null"
+@property (nonatomic, copy) NSArray<GesturePoint *> *points;
+
+- (instancetype)initWithId:(NSInteger)aActionId screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH keyCode:(NSString *)aKeyCode points:(NSArray<GesturePoint *> *)aPoints NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+/// 搖桿：四個方向鍵各自從 center 拖到 center + radius × 方向，按住期間保持
+/// JSON: { "type": "JOYSTICK", "id", "center_portrait_x", "center_portrait_y", "radius", "ramp_ms",
+///         "keys": { "up", "down", "left", "right" } }
+@interface JoystickAction : NSObject <KeymapAction, NSCopying>
+
+@property (nonatomic, readonly) NSInteger actionId;
+@property (nonatomic) NSInteger screenW;
+@property (nonatomic) NSInteger screenH;
+@property (nonatomic) CGFloat centerX;
+@property (nonatomic) CGFloat centerY;
+@property (nonatomic) CGFloat radius;
+@property (nonatomic) NSInteger rampMs;             // 從中心推到邊緣的時間，預設 120
+@property (nonatomic, copy) NSString *upKey;        // 未指定為 @"null"
+@property (nonatomic, copy) NSString *downKey;
+@property (nonatomic, copy) NSString *leftKey;
+@property (nonatomic, copy) NSString *rightKey;
+
+- (instancetype)initWithId:(NSInteger)aActionId screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH centerX:(CGFloat)aCenterX centerY:(CGFloat)aCenterY radius:(CGFloat)aRadius NS_DESIGNATED_INITIALIZER;
+
+/// 有指定的方向鍵 (不含 @"null")
+- (NSArray<NSString *> *)assignedKeys;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+/// 巨集步驟「點擊指定座標」(type 0x04) 的觸控狀態 (content Byte 0)
+typedef NS_ENUM(NSInteger, MacroTouch)
+{
+    MacroTouchRelease = 0,      // 0: 不點擊 → 放開
+    MacroTouchTap = 1,          // 1: 單次點擊
+    MacroTouchHold = 2,         // 2: 長按 → 按住並移動到此座標
+};
+
+/// 一個巨集步驟：在 (x, y) 做 touch，之後等 delayMs 再執行下一步
+@interface MacroStep : NSObject
+
+@property (nonatomic) MacroTouch touch;
+@property (nonatomic) NSInteger x;
+@property (nonatomic) NSInteger y;
+@property (nonatomic) NSInteger delayMs;
+
++ (instancetype)stepWithTouch:(MacroTouch)aTouch x:(NSInteger)aX y:(NSInteger)aY delayMs:(NSInteger)aDelayMs;
+
+@end
+
+
 /// 對應 Kotlin: data class KeymapFile(...)
 @interface KeymapFile : NSObject
 
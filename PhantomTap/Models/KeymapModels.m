@@ -6,8 +6,170 @@
 //
 
 #import "KeymapModels.h"
+#import "KeymapLayout.h"
+
+@interface HostPayload ()
+
+- (instancetype)initWithType:(HostPayloadType)aType NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@implementation HostPayload
+
+- (instancetype)initWithType:(HostPayloadType)aType
+{
+    self = [super init];
+    if (!self) return nil;
+    
+    _type = aType;
+    return self;
+}
+
++ (instancetype)p_payloadWithType:(HostPayloadType)aType
+{
+    return [[self alloc] initWithType:aType];
+}
+
++ (instancetype)none
+{
+    return [self p_payloadWithType:HostPayloadTypeNone];
+}
+
++ (instancetype)mouseWithButtons:(uint8_t)aButtons deltaX:(NSInteger)aDX deltaY:(NSInteger)aDY wheel:(NSInteger)aWheel
+{
+    HostPayload *p = [self p_payloadWithType:HostPayloadTypeMouse];
+    p -> _buttons = aButtons;
+    p -> _deltaX = MAX(-127, MIN(127, aDX));
+    p -> _deltaY = MAX(-127, MIN(127, aDY));
+    p -> _wheel = MAX(-127, MIN(127, aWheel));
+    return p;
+}
+
++ (instancetype)keyboardWithModifiers:(uint8_t)aModifiers hidCode:(uint8_t)aHidCode
+{
+    HostPayload *p = [self p_payloadWithType:HostPayloadTypeKeyboard];
+    p -> _modifiers = aModifiers;
+    p -> _hidCode = aHidCode;
+    return p;
+}
+
++ (instancetype)multimediaWithUsage:(uint16_t)aUsage
+{
+    HostPayload *p = [self p_payloadWithType:HostPayloadTypeMultimedia];
+    p -> _usage = aUsage;
+    return p;
+}
+
++ (instancetype)coordinateTapWithX:(NSInteger)aX y:(NSInteger)aY touch:(NSInteger)aTouch
+{
+    HostPayload *p = [self p_payloadWithType:HostPayloadTypeCoordinateTap];
+    p -> _x = MAX(0, MIN(aX, 0xFFFF));
+    p -> _y = MAX(0, MIN(aY, 0xFFFF));
+    p -> _touch = MAX(0, MIN(aTouch, 2));
+    return p;
+}
+
++ (nullable instancetype)payloadFromJSON:(NSDictionary *)aJSON
+{
+    if (![aJSON isKindOfClass:[NSDictionary class]]) return nil;
+    
+    NSString *typeStr = [(aJSON[@"type"] ?: @"NONE") uppercaseString];
+    if ([typeStr isEqualToString:@"NONE"]) return [self none];
+    if ([typeStr isEqualToString:@"MOUSE"])
+    {
+        return [self mouseWithButtons:(uint8_t)[aJSON[@"buttons"] integerValue] deltaX:[aJSON[@"dx"] integerValue] deltaY:[aJSON[@"dy"] integerValue] wheel:[aJSON[@"wheel"] integerValue]];
+    }
+    if ([typeStr isEqualToString:@"KEYBOARD"])
+    {
+        return [self keyboardWithModifiers:(uint8_t)[aJSON[@"modifiers"] integerValue] hidCode:(uint8_t)[aJSON[@"hid"] integerValue]];
+    }
+    if ([typeStr isEqualToString:@"MULTIMEDIA"])
+    {
+        return [self multimediaWithUsage:(uint16_t)[aJSON[@"usage"] integerValue]];
+    }
+    if ([typeStr isEqualToString:@"TAP"])
+    {
+        NSInteger touch = aJSON[@"touch"] ? [aJSON[@"touch"] integerValue] : 1;
+        return [self coordinateTapWithX:[aJSON[@"x"] integerValue] y:[aJSON[@"y"] integerValue] touch:touch];
+    }
+    return nil;
+}
+
+- (NSDictionary *)toJSON
+{
+    switch (self.type)
+    {
+        case HostPayloadTypeMouse:
+            return @{ @"type": @"MOUSE", @"buttons": @(self.buttons), @"dx": @(self.deltaX), @"dy": @(self.deltaY), @"wheel": @(self.wheel) };
+        case HostPayloadTypeKeyboard:
+            return @{ @"type": @"KEYBOARD", @"modifiers": @(self.modifiers), @"hid": @(self.hidCode) };
+        case HostPayloadTypeMultimedia:
+            return @{ @"type": @"MULTIMEDIA", @"usage": @(self.usage) };
+        case HostPayloadTypeCoordinateTap:
+            return @{ @"type": @"TAP", @"x": @(self.x), @"y": @(self.y), @"touch": @(self.touch) };
+        case HostPayloadTypeNone:
+            break;
+    }
+    return @{ @"type": @"NONE" };
+}
+
++ (NSString *)jsonKeyForHost:(HostOS)aHost
+{
+    switch (aHost)
+    {
+        case HostOSAndroid: return @"android";
+        case HostOSWindows: return @"windows";
+        case HostOSIOS:     return @"ios";
+    }
+    return @"android";
+}
+
+- (BOOL)isEqual:(id)aObject
+{
+    if (self == aObject) return YES;
+    if (![aObject isKindOfClass:[HostPayload class]]) return NO;
+    return [[self toJSON] isEqualToDictionary:[(HostPayload *)aObject toJSON]];
+}
+
+- (NSUInteger)hash
+{
+    return [[self toJSON] hash];
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<HostPayload %@>", [self toJSON]];
+}
+
+@end
+
+
+
+/// 獨立 (未 attach) 時的欄位；attach 後整個放掉，TapAction 只剩 (layout, id)
+@interface TapActionValues : NSObject
+{
+@public
+    NSString *_orientation;
+    NSInteger _screenW;
+    NSInteger _screenH;
+    CGFloat _posX;
+    CGFloat _posY;
+    NSString *_keyCode;
+    BOOL _pressEvent;
+    HostPayload *_androidPayload;
+    HostPayload *_windowsPayload;
+    HostPayload *_iosPayload;
+}
+@end
+
+@implementation TapActionValues
+@end
+
 
 @implementation TapAction
+{
+    TapActionValues *_values;       // attach 中為 nil
+}
 
 - (instancetype)initWithId:(NSInteger)aActionId orientation:(NSString *)aOrientation screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH posX:(CGFloat)aPosX posY:(CGFloat)aPosY keyCode:(NSString *)aKeyCode pressEvent:(BOOL)aPressEvent
 {
@@ -15,13 +177,16 @@
     if (self)
     {
         _actionId = aActionId;
-        _orientation = [aOrientation length] ? [aOrientation copy] : @"PORTRAIT";
-        _screenW = aScreenW;
-        _screenH = aScreenH;
-        _posX = aPosX;
-        _posY = aPosY;
-        _keyCode = [aKeyCode length] ? [aKeyCode copy] : @"null";
-        _pressEvent = aPressEvent;
+        
+        TapActionValues *v = [TapActionValues new];
+        v -> _orientation = [aOrientation length] ? [aOrientation copy] : @"PORTRAIT";
+        v -> _screenW = aScreenW;
+        v -> _screenH = aScreenH;
+        v -> _posX = aPosX;
+        v -> _posY = aPosY;
+        v -> _keyCode = [aKeyCode length] ? [aKeyCode copy] : @"null";
+        v -> _pressEvent = aPressEvent;
+        _values = v;
     }
     
     return self;
@@ -34,6 +199,280 @@
 }
 
 
+- (KeymapType)keymapType
+{
+    return KeymapTypePhantomTap;
+}
+
+
+#pragma mark - Layout view
+
+/// attach 中的 row；該列被外部刪掉是呼叫端的錯 (應該先 detach)
+- (NSUInteger)p_row
+{
+    NSUInteger row = [self -> _layout rowForId:self -> _actionId];
+    NSAssert(row != NSNotFound, @"TapAction %ld 的列已經不在 layout 裡，請先 detachFromLayout", (long)self -> _actionId);
+    return row;
+}
+
+- (void)attachToLayout:(KeymapLayout *)aLayout
+{
+    if (self -> _layout == aLayout) return;
+    if (self -> _layout) [self detachFromLayout];
+    
+    TapActionValues *v = self -> _values;
+    KeymapRowFlags f = 0;
+    if ([v -> _orientation isEqualToString:@"LANDSCAPE"]) f |= KeymapRowFlagLandscape;
+    if (v -> _pressEvent) f |= KeymapRowFlagPressEvent;
+    
+    NSUInteger row = [aLayout addRowWithId:self -> _actionId posX:v -> _posX posY:v -> _posY keyLabel:v -> _keyCode flags:f];
+    if (row == NSNotFound) return;      // id 超出 int32 範圍或配置失敗，保持獨立
+    
+    [aLayout setHostPayload:v -> _androidPayload host:HostOSAndroid atRow:row];
+    [aLayout setHostPayload:v -> _windowsPayload host:HostOSWindows atRow:row];
+    [aLayout setHostPayload:v -> _iosPayload host:HostOSIOS atRow:row];
+    if ([aLayout count] == 1 || [aLayout screenW] == 0)
+    {
+        [aLayout setScreenW:v -> _screenW];
+        [aLayout setScreenH:v -> _screenH];
+    }
+    
+    // 之後只讀寫 layout，自己不留一份
+    self -> _layout = aLayout;
+    self -> _values = nil;
+}
+
+- (void)detachFromLayout
+{
+    KeymapLayout *layout = self -> _layout;
+    if (!layout) return;
+    
+    NSUInteger row = [self p_row];
+    TapActionValues *v = [TapActionValues new];
+    v -> _screenW = [layout screenW];
+    v -> _screenH = [layout screenH];
+    if (row != NSNotFound)
+    {
+        KeymapRowFlags f = [layout flags][row];
+        v -> _orientation = (f & KeymapRowFlagLandscape) ? @"LANDSCAPE" : @"PORTRAIT";
+        v -> _pressEvent = (f & KeymapRowFlagPressEvent) != 0;
+        v -> _posX = [layout posXs][row];
+        v -> _posY = [layout posYs][row];
+        v -> _keyCode = [layout keyLabelAtRow:row];
+        v -> _androidPayload = [layout hostPayload:HostOSAndroid atRow:row];
+        v -> _windowsPayload = [layout hostPayload:HostOSWindows atRow:row];
+        v -> _iosPayload = [layout hostPayload:HostOSIOS atRow:row];
+        [layout removeRowWithId:self -> _actionId];
+    }
+    else
+    {
+        v -> _orientation = @"PORTRAIT";
+        v -> _keyCode = @"null";
+    }
+    
+    self -> _values = v;
+    self -> _layout = nil;
+}
+
+- (TapAction *)detachedCopy
+{
+    TapAction *copy = [[TapAction alloc] initWithId:self.actionId orientation:self.orientation screenW:self.screenW screenH:self.screenH posX:self.posX posY:self.posY keyCode:self.keyCode pressEvent:self.isPressEvent];
+    copy.androidPayload = self.androidPayload;
+    copy.windowsPayload = self.windowsPayload;
+    copy.iosPayload = self.iosPayload;
+    return copy;
+}
+
+
+#pragma mark - Accessors (attach 時只讀寫 layout 的那一列)
+
+- (NSString *)orientation
+{
+    if (!self -> _layout) return self -> _values -> _orientation;
+    
+    NSUInteger row = [self p_row];
+    if (row == NSNotFound) return @"PORTRAIT";
+    return ([self -> _layout flags][row] & KeymapRowFlagLandscape) ? @"LANDSCAPE" : @"PORTRAIT";
+}
+
+- (void)setOrientation:(NSString *)aOrientation
+{
+    if (!self -> _layout)
+    {
+        self -> _values -> _orientation = [aOrientation length] ? [aOrientation copy] : @"PORTRAIT";
+        return;
+    }
+    
+    NSUInteger row = [self p_row];
+    if (row == NSNotFound) return;
+    
+    KeymapRowFlags f = [self -> _layout flags][row] & ~KeymapRowFlagLandscape;
+    if ([aOrientation isEqualToString:@"LANDSCAPE"]) f |= KeymapRowFlagLandscape;
+    [self -> _layout setFlags:f atRow:row];
+}
+
+// 螢幕尺寸是整個 layout 共用的，attach 中只能讀；要改請改 layout
+- (NSInteger)screenW
+{
+    return self -> _layout ? [self -> _layout screenW] : self -> _values -> _screenW;
+}
+
+- (void)setScreenW:(NSInteger)aScreenW
+{
+    NSAssert(!self -> _layout, @"attach 中的 TapAction 不能改 screenW，請改 -[KeymapLayout setScreenW:]");
+    if (!self -> _layout) self -> _values -> _screenW = aScreenW;
+}
+
+- (NSInteger)screenH
+{
+    return self -> _layout ? [self -> _layout screenH] : self -> _values -> _screenH;
+}
+
+- (void)setScreenH:(NSInteger)aScreenH
+{
+    NSAssert(!self -> _layout, @"attach 中的 TapAction 不能改 screenH，請改 -[KeymapLayout setScreenH:]");
+    if (!self -> _layout) self -> _values -> _screenH = aScreenH;
+}
+
+- (CGFloat)posX
+{
+    if (!self -> _layout) return self -> _values -> _posX;
+    
+    NSUInteger row = [self p_row];
+    return (row == NSNotFound) ? 0 : [self -> _layout posXs][row];
+}
+
+- (void)setPosX:(CGFloat)aPosX
+{
+    if (!self -> _layout)
+    {
+        self -> _values -> _posX = aPosX;
+        return;
+    }
+    
+    NSUInteger row = [self p_row];
+    if (row != NSNotFound) [self -> _layout setPosX:aPosX posY:[self -> _layout posYs][row] atRow:row];
+}
+
+- (CGFloat)posY
+{
+    if (!self -> _layout) return self -> _values -> _posY;
+    
+    NSUInteger row = [self p_row];
+    return (row == NSNotFound) ? 0 : [self -> _layout posYs][row];
+}
+
+- (void)setPosY:(CGFloat)aPosY
+{
+    if (!self -> _layout)
+    {
+        self -> _values -> _posY = aPosY;
+        return;
+    }
+    
+    NSUInteger row = [self p_row];
+    if (row != NSNotFound) [self -> _layout setPosX:[self -> _layout posXs][row] posY:aPosY atRow:row];
+}
+
+- (NSString *)keyCode
+{
+    if (!self -> _layout) return self -> _values -> _keyCode;
+    
+    NSUInteger row = [self p_row];
+    return (row == NSNotFound) ? @"null" : [self -> _layout keyLabelAtRow:row];
+}
+
+- (void)setKeyCode:(NSString *)aKeyCode
+{
+    NSString *key = [aKeyCode length] ? [aKeyCode copy] : @"null";
+    if (!self -> _layout)
+    {
+        self -> _values -> _keyCode = key;
+        return;
+    }
+    
+    NSUInteger row = [self p_row];
+    if (row != NSNotFound) [self -> _layout setKeyLabel:key atRow:row];
+}
+
+- (BOOL)isPressEvent
+{
+    if (!self -> _layout) return self -> _values -> _pressEvent;
+    
+    NSUInteger row = [self p_row];
+    if (row == NSNotFound) return NO;
+    return ([self -> _layout flags][row] & KeymapRowFlagPressEvent) != 0;
+}
+
+- (void)setPressEvent:(BOOL)aPressEvent
+{
+    if (!self -> _layout)
+    {
+        self -> _values -> _pressEvent = aPressEvent;
+        return;
+    }
+    
+    NSUInteger row = [self p_row];
+    if (row == NSNotFound) return;
+    
+    KeymapRowFlags f = [self -> _layout flags][row] & ~KeymapRowFlagPressEvent;
+    if (aPressEvent) f |= KeymapRowFlagPressEvent;
+    [self -> _layout setFlags:f atRow:row];
+}
+
+- (nullable HostPayload *)androidPayload    { return [self payloadForHost:HostOSAndroid]; }
+- (nullable HostPayload *)windowsPayload    { return [self payloadForHost:HostOSWindows]; }
+- (nullable HostPayload *)iosPayload        { return [self payloadForHost:HostOSIOS]; }
+
+- (void)setAndroidPayload:(nullable HostPayload *)aPayload  { [self setPayload:aPayload forHost:HostOSAndroid]; }
+- (void)setWindowsPayload:(nullable HostPayload *)aPayload  { [self setPayload:aPayload forHost:HostOSWindows]; }
+- (void)setIosPayload:(nullable HostPayload *)aPayload      { [self setPayload:aPayload forHost:HostOSIOS]; }
+
+- (nullable HostPayload *)payloadForHost:(HostOS)aHost
+{
+    if (self -> _layout)
+    {
+        NSUInteger row = [self p_row];
+        return (row == NSNotFound) ? nil : [self -> _layout hostPayload:aHost atRow:row];
+    }
+    
+    switch (aHost)
+    {
+        case HostOSAndroid: return self -> _values -> _androidPayload;
+        case HostOSWindows: return self -> _values -> _windowsPayload;
+        case HostOSIOS:     return self -> _values -> _iosPayload;
+    }
+    return nil;
+}
+
+- (void)setPayload:(nullable HostPayload *)aPayload forHost:(HostOS)aHost
+{
+    if (self -> _layout)
+    {
+        NSUInteger row = [self p_row];
+        if (row != NSNotFound) [self -> _layout setHostPayload:aPayload host:aHost atRow:row];
+        return;
+    }
+    
+    switch (aHost)
+    {
+        case HostOSAndroid: self -> _values -> _androidPayload = aPayload; break;
+        case HostOSWindows: self -> _values -> _windowsPayload = aPayload; break;
+        case HostOSIOS:     self -> _values -> _iosPayload = aPayload; break;
+    }
+}
+
+- (NSArray<HostPayload *> *)hostPayloads
+{
+    HostPayload *none = [HostPayload none];
+    return @[
+        self.androidPayload ?: none,
+        self.windowsPayload ?: none,
+        self.iosPayload ?: none,
+    ];
+}
+
+
 - (NSString *)description
 {
     return [NSString stringWithFormat:@"<TapAction id=%ld ori=%@ pos=(%.1f,%.1f) screen=%ldx%ld key=%@ press=%@>",
@@ -50,6 +489,149 @@
 
 
 
+@implementation GesturePoint
+
++ (instancetype)pointWithX:(CGFloat)aX y:(CGFloat)aY timeMs:(NSInteger)aTimeMs
+{
+    GesturePoint *p = [GesturePoint new];
+    p.x = aX;
+    p.y = aY;
+    p.timeMs = aTimeMs;
+    return p;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"(%.1f,%.1f @%ldms)", self.x, self.y, (long)self.timeMs];
+}
+
+@end
+
+
+
+@implementation SwipeAction
+
+- (instancetype)initWithId:(NSInteger)aActionId screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH keyCode:(NSString *)aKeyCode points:(NSArray<GesturePoint *> *)aPoints
+{
+    self = [super init];
+    if (self)
+    {
+        _actionId = aActionId;
+        _screenW = aScreenW;
+        _screenH = aScreenH;
+        _keyCode = [aKeyCode length] ? [aKeyCode copy] : @"null";
+        _points = [aPoints copy] ?: @[];
+    }
+    
+    return self;
+}
+
+- (KeymapType)keymapType
+{
+    return KeymapTypeSwipe;
+}
+
+- (id)copyWithZone:(NSZone *)aZone
+{
+    // points 內的 GesturePoint 建立後不再修改，共用即可
+    return [[SwipeAction alloc] initWithId:self.actionId screenW:self.screenW screenH:self.screenH keyCode:self.keyCode points:self.points];
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<SwipeAction id=%ld key=%@ points=%lu screen=%ldx%ld>",
+            (long)self.actionId,
+            self.keyCode,
+            (unsigned long)self.points.count,
+            (long)self.screenW, (long)self.screenH];
+}
+
+@end
+
+
+
+@implementation JoystickAction
+
+- (instancetype)initWithId:(NSInteger)aActionId screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH centerX:(CGFloat)aCenterX centerY:(CGFloat)aCenterY radius:(CGFloat)aRadius
+{
+    self = [super init];
+    if (self)
+    {
+        _actionId = aActionId;
+        _screenW = aScreenW;
+        _screenH = aScreenH;
+        _centerX = aCenterX;
+        _centerY = aCenterY;
+        _radius = aRadius;
+        _rampMs = 120;
+        _upKey = @"null";
+        _downKey = @"null";
+        _leftKey = @"null";
+        _rightKey = @"null";
+    }
+    
+    return self;
+}
+
+- (KeymapType)keymapType
+{
+    return KeymapTypeJoystick;
+}
+
+- (id)copyWithZone:(NSZone *)aZone
+{
+    JoystickAction *copy = [[JoystickAction alloc] initWithId:self.actionId screenW:self.screenW screenH:self.screenH centerX:self.centerX centerY:self.centerY radius:self.radius];
+    copy.rampMs = self.rampMs;
+    copy.upKey = self.upKey;
+    copy.downKey = self.downKey;
+    copy.leftKey = self.leftKey;
+    copy.rightKey = self.rightKey;
+    return copy;
+}
+
+- (NSArray<NSString *> *)assignedKeys
+{
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:4];
+    for (NSString *k in @[self.upKey ?: @"null", self.downKey ?: @"null", self.leftKey ?: @"null", self.rightKey ?: @"null"])
+    {
+        if ([k length] && ![k isEqualToString:@"null"]) [keys addObject:k];
+    }
+    return keys;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<JoystickAction id=%ld center=(%.1f,%.1f) r=%.1f keys=%@/%@/%@/%@>",
+            (long)self.actionId,
+            self.centerX, self.centerY, self.radius,
+            self.upKey, self.downKey, self.leftKey, self.rightKey];
+}
+
+@end
+
+
+
+@implementation MacroStep
+
++ (instancetype)stepWithTouch:(MacroTouch)aTouch x:(NSInteger)aX y:(NSInteger)aY delayMs:(NSInteger)aDelayMs
+{
+    MacroStep *st = [MacroStep new];
+    st.touch = aTouch;
+    st.x = aX;
+    st.y = aY;
+    st.delayMs = aDelayMs;
+    return st;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<MacroStep touch=%ld (%ld,%ld) +%ldms>", (long)self.touch, (long)self.x, (long)self.y, (long)self.delayMs];
+}
+
+@end
+
+
+
 @implementation KeymapFile
 
 - (instancetype)initWithVersion:(NSInteger)aVersion createdAt:(NSString *)aCreatedAt nickname:(NSString *)aNickname portraitW:(NSInteger)aPortraitW portraitH:(NSInteger)aPortraitH rotationWhenSaved:(NSInteger)aRotation actions:(NSArray<id<KeymapAction>> *)aActions
@@ -87,17 +669,32 @@
     NSInteger portraitH    = [root[@"portraitH"] integerValue];
     NSInteger rotation     = [root[@"rotation_when_saved"] integerValue];
     
-    NSMutableArray<TapAction *> *list = [NSMutableArray array];
+    NSMutableArray<id<KeymapAction>> *list = [NSMutableArray array];
     NSArray *actions = root[@"actions"];
     if ([actions isKindOfClass:[NSArray class]])
     {
         [actions enumerateObjectsUsingBlock:^(id  _Nonnull obj, NSUInteger idx, BOOL * _Nonnull stop) {
+            if (![obj isKindOfClass:[NSDictionary class]]) return;
             NSDictionary *it = (NSDictionary *)obj;
-            // 只處理 type == TAP
-            NSString *typeStr = it[@"type"] ?: @"TAP";
-            if (![[typeStr uppercaseString] isEqualToString:@"TAP"]) return;
+            NSString *typeStr = [(it[@"type"] ?: @"TAP") uppercaseString];
+            
+            if ([typeStr isEqualToString:@"SWIPE"])
+            {
+                SwipeAction *sa = [self p_swipeFromJSON:it screenW:portraitW screenH:portraitH];
+                if (sa) [list addObject:sa];
+                return;
+            }
+            if ([typeStr isEqualToString:@"JOYSTICK"])
+            {
+                JoystickAction *ja = [self p_joystickFromJSON:it screenW:portraitW screenH:portraitH];
+                if (ja) [list addObject:ja];
+                return;
+            }
+            if (![typeStr isEqualToString:@"TAP"]) return;
             
+            // layout / journal 的 id 是 32 bit，超出範圍的項目不收
             NSInteger aid = [it[@"id"] integerValue];
+            if (aid < INT32_MIN || aid > INT32_MAX) return;
             NSString *key = it[@"key"] ?: @"null";
             // 注意：Android 存的是「螢幕左上角絕對座標」(posX/posY)，
             // iOS 畫面要顯示時通常會換算成容器座標；這裡先照存檔讀出。
@@ -105,6 +702,15 @@
             CGFloat cy = [it[@"center_portrait_y"] doubleValue];
             
             TapAction *ta = [[TapAction alloc] initWithId:aid orientation:@"PORTRAIT" screenW:portraitW screenH:portraitH posX:cx posY:cy keyCode:key pressEvent:YES];
+            
+            NSDictionary *hosts = it[@"hosts"];
+            if ([hosts isKindOfClass:[NSDictionary class]])
+            {
+                for (HostOS os = HostOSAndroid; os <= HostOSIOS; os++)
+                {
+                    [ta setPayload:[HostPayload payloadFromJSON:hosts[[HostPayload jsonKeyForHost:os]]] forHost:os];
+                }
+            }
             [list addObject:ta];
             
         }];
@@ -113,19 +719,113 @@
     return [[self alloc] initWithVersion:version createdAt:createdAt nickname:nickname portraitW:portraitW portraitH:portraitH rotationWhenSaved:rotation actions:list];
 }
 
+/// 存檔裡的按鍵欄位：不是字串 (數字、null、陣列…) 一律當成未指定
++ (NSString *)p_keyFromJSON:(id)aValue
+{
+    return ([aValue isKindOfClass:[NSString class]] && [aValue length] > 0) ? aValue : @"null";
+}
+
++ (nullable SwipeAction *)p_swipeFromJSON:(NSDictionary *)aItem screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH
+{
+    NSArray *rawPoints = aItem[@"points"];
+    if (![rawPoints isKindOfClass:[NSArray class]] || [rawPoints count] < 2) return nil;
+    
+    NSMutableArray<GesturePoint *> *points = [NSMutableArray arrayWithCapacity:[rawPoints count]];
+    for (NSDictionary *p in rawPoints)
+    {
+        if (![p isKindOfClass:[NSDictionary class]]) continue;
+        [points addObject:[GesturePoint pointWithX:[p[@"x"] doubleValue] y:[p[@"y"] doubleValue] timeMs:[p[@"t"] integerValue]]];
+    }
+    if ([points count] < 2) return nil;
+    
+    NSInteger aid = [aItem[@"id"] integerValue];
+    if (aid < INT32_MIN || aid > INT32_MAX) return nil;
+    
+    return [[SwipeAction alloc] initWithId:aid screenW:aScreenW screenH:aScreenH keyCode:[self p_keyFromJSON:aItem[@"key"]] points:points];
+}
+
++ (nullable JoystickAction *)p_joystickFromJSON:(NSDictionary *)aItem screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH
+{
+    CGFloat radius = [aItem[@"radius"] doubleValue];
+    NSInteger aid = [aItem[@"id"] integerValue];
+    if (radius <= 0 || aid < INT32_MIN || aid > INT32_MAX) return nil;
+    
+    JoystickAction *ja = [[JoystickAction alloc] initWithId:aid screenW:aScreenW screenH:aScreenH centerX:[aItem[@"center_portrait_x"] doubleValue] centerY:[aItem[@"center_portrait_y"] doubleValue] radius:radius];
+    if (aItem[@"ramp_ms"]) ja.rampMs = MAX(0, [aItem[@"ramp_ms"] integerValue]);
+    
+    NSDictionary *keys = aItem[@"keys"];
+    if ([keys isKindOfClass:[NSDictionary class]])
+    {
+        ja.upKey = [self p_keyFromJSON:keys[@"up"]];
+        ja.downKey = [self p_keyFromJSON:keys[@"down"]];
+        ja.leftKey = [self p_keyFromJSON:keys[@"left"]];
+        ja.rightKey = [self p_keyFromJSON:keys[@"right"]];
+    }
+    
+    return ja;
+}
+
 - (NSData *)toJSONPretty:(BOOL)aPrettyJson error:(NSError **)aError
 {
     NSMutableArray *arr = [NSMutableArray arrayWithCapacity:self.actions.count];
-    [self.actions enumerateObjectsUsingBlock:^(TapAction * _Nonnull v, NSUInteger idx, BOOL * _Nonnull stop) {
+    [self.actions enumerateObjectsUsingBlock:^(id<KeymapAction> _Nonnull act, NSUInteger idx, BOOL * _Nonnull stop) {
+        if ([act keymapType] == KeymapTypeSwipe)
+        {
+            SwipeAction *sa = (SwipeAction *)act;
+            NSMutableArray *pts = [NSMutableArray arrayWithCapacity:sa.points.count];
+            for (GesturePoint *p in sa.points)
+            {
+                [pts addObject:@{ @"x": @(p.x), @"y": @(p.y), @"t": @(p.timeMs) }];
+            }
+            [arr addObject:@{
+                @"type": @"SWIPE",
+                @"id": @(sa.actionId),
+                @"key": sa.keyCode ?: @"null",
+                @"points": pts,
+            }];
+            return;
+        }
+        
+        if ([act keymapType] == KeymapTypeJoystick)
+        {
+            JoystickAction *ja = (JoystickAction *)act;
+            [arr addObject:@{
+                @"type": @"JOYSTICK",
+                @"id": @(ja.actionId),
+                @"center_portrait_x": @(ja.centerX),
+                @"center_portrait_y": @(ja.centerY),
+                @"radius": @(ja.radius),
+                @"ramp_ms": @(ja.rampMs),
+                @"keys": @{
+                    @"up": ja.upKey ?: @"null",
+                    @"down": ja.downKey ?: @"null",
+                    @"left": ja.leftKey ?: @"null",
+                    @"right": ja.rightKey ?: @"null",
+                },
+            }];
+            return;
+        }
+        
+        TapAction *v = (TapAction *)act;
         // 存成 Android 版 schema：posX/posY = 「螢幕左上角絕對座標」
         // 你在組 JSON 前，請先把 view 的 centerOnScreen 算好/或保留原本螢幕座標放進 v.posX / v.posY
-        NSDictionary *item = @{
+        NSMutableDictionary *item = [@{
             @"type": @"TAP",
             @"id": @(v.actionId),
             @"key": v.keyCode ?: @"null",
             @"center_portrait_x": @(v.posX),
             @"center_portrait_y": @(v.posY),
-        };
+        } mutableCopy];
+        
+        // 只寫有指定的主機
+        NSMutableDictionary *hosts = [NSMutableDictionary dictionary];
+        for (HostOS os = HostOSAndroid; os <= HostOSIOS; os++)
+        {
+            HostPayload *hp = [v payloadForHost:os];
+            if (hp) hosts[[HostPayload jsonKeyForHost:os]] = [hp toJSON];
+        }
+        if ([hosts count] > 0) item[@"hosts"] = hosts;
+        
         [arr addObject:item];
     }];
     
@@ -0,0 +1,59 @@
+//
+//  KeymapProfileCompiler.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/24.
+//
+
+#import <Foundation/Foundation.h>
+#import "KeymapModels.h"
+#import "KeymapLayout.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+extern NSString * const KeymapProfileErrorDomain;
+
+/// error.code 為 KeymapValidationStatus，或下列值
+typedef NS_ENUM(NSInteger, KeymapProfileError)
+{
+    KeymapProfileErrorEmptyProfile = 100,       // 沒有任何點
+    KeymapProfileErrorMalformedFrame,           // 封包流無法還原
+    KeymapProfileErrorMacroTooLong,             // 滑動 / 搖桿的巨集太長，封包索引超出範圍
+};
+
+/// userInfo key：出問題的標籤 / action id
+extern NSString * const KeymapProfileErrorLabelKey;
+extern NSString * const KeymapProfileErrorActionIdKey;
+
+
+/// 與 UI 無關的「設定檔 ⇄ 封包流」轉換 (App 寫入與 Tools/ 的 CLI 共用)
+///
+/// 寫入順序與 -onWriteToKeyboard 相同：點擊鍵依 id 排序的 key mapping 封包 → 滑動 / 搖桿的巨集封包
+@interface KeymapProfileCompiler : NSObject
+
+/// 滑動 / 搖桿用到的按鍵 (寫入時與點擊鍵一起檢查重複)
++ (NSArray<NSString *> *)gestureKeyLabelsForActions:(NSArray<id<KeymapAction>> *)aActions;
+
+/// 滑動 / 搖桿 → 巨集封包，座標換算到 aScreenW × aScreenH 像素
+/// 有查不到 keyIndex 的按鍵、或巨集太長寫不進去時回傳 nil (aError 的 label 為該鍵)
++ (nullable NSArray<NSData *> *)buildGestureFramesForActions:(NSArray<id<KeymapAction>> *)aActions screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError;
+
+/// 檢查整份設定：空鍵 / 重複標籤 → 查不到 keyIndex (規則與順序同 -onWriteToKeyboard)
++ (BOOL)validateFile:(KeymapFile *)aFile error:(NSError **)aError;
+
+/// 寫入用的封包流 (-onWriteToKeyboard 與 -compileFile: 都走這裡)
+/// 檢查 → 依 id 排序 aLayout → key mapping 封包 (座標經 aTransform 換成像素) → 滑動 / 搖桿巨集 (換算到 aScreenW × aScreenH)
+/// 檢查不過時回傳 nil，aError.code 為 KeymapValidationStatus、KeymapProfileErrorEmptyProfile 或 KeymapProfileErrorMacroTooLong
++ (nullable NSArray<NSData *> *)compileLayout:(KeymapLayout *)aLayout transform:(KeymapPixelTransform)aTransform gestures:(NSArray<id<KeymapAction>> *)aGestures screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError;
+
+/// 整份設定 → 封包流；aScreenW / aScreenH <= 0 時用存檔時的螢幕尺寸
+/// 點擊鍵的存檔座標 (像素中心點) 依比例換算後夾在螢幕內
++ (nullable NSArray<NSData *> *)compileFile:(KeymapFile *)aFile screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError;
+
+/// 封包流 → 設定檔 (只認 app → 鍵盤的寫入封包，其他略過)
+/// 座標為封包內的螢幕像素，aScreenW / aScreenH 寫進檔案的 portraitW / portraitH
++ (nullable KeymapFile *)decodeFrames:(NSArray<NSData *> *)aFrames screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH nickname:(NSString *)aNickname error:(NSError **)aError;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,387 @@
+//
+//  KeymapProfileCompiler.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2025/12/24.
+//
+
+#import "KeymapProfileCompiler.h"
+#import "GestureCompiler.h"
+#import "HidKeyCodeMap.h"
+#import "BluetoothPacketBuilder.h"
+#import "BluetoothPacketParser.h"
+#import "GlobalConfig.h"
+
+NSString * const KeymapProfileErrorDomain = @"KeymapProfileErrorDomain";
+NSString * const KeymapProfileErrorLabelKey = @"label";
+NSString * const KeymapProfileErrorActionIdKey = @"actionId";
+
+/// 存檔沒有螢幕尺寸時的預設值 (同 -p_convertStepTo13Bytes:)
+static const NSInteger kDefaultScreenW = 1080;
+static const NSInteger kDefaultScreenH = 1920;
+
+
+static NSError *KeymapProfileMakeError(NSInteger aCode, NSString *aMessage, NSString *aLabel, NSInteger aActionId)
+{
+    NSMutableDictionary *info = [NSMutableDictionary dictionaryWithObject:aMessage forKey:NSLocalizedDescriptionKey];
+    if (aLabel) info[KeymapProfileErrorLabelKey] = aLabel;
+    if (aActionId >= 0) info[KeymapProfileErrorActionIdKey] = @(aActionId);
+    return [NSError errorWithDomain:KeymapProfileErrorDomain code:aCode userInfo:info];
+}
+
+
+@implementation KeymapProfileCompiler
+
+#pragma mark - Gestures
+
++ (NSArray<NSString *> *)gestureKeyLabelsForActions:(NSArray<id<KeymapAction>> *)aActions
+{
+    NSMutableArray<NSString *> *labels = [NSMutableArray array];
+    for (id<KeymapAction> act in aActions)
+    {
+        if ([act keymapType] == KeymapTypeSwipe)
+        {
+            NSString *k = [(SwipeAction *)act keyCode];
+            if ([k length] && ![k isEqualToString:@"null"]) [labels addObject:k];
+        }
+        else if ([act keymapType] == KeymapTypeJoystick)
+        {
+            [labels addObjectsFromArray:[(JoystickAction *)act assignedKeys]];
+        }
+    }
+    return labels;
+}
+
++ (nullable NSArray<NSData *> *)buildGestureFramesForActions:(NSArray<id<KeymapAction>> *)aActions screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError
+{
+    GestureCompilerOptions *opt = [GestureCompilerOptions defaultOptions];
+    opt.targetScreenSize = CGSizeMake(aScreenW, aScreenH);
+
+    NSMutableArray<NSData *> *frames = [NSMutableArray array];
+
+    for (id<KeymapAction> act in aActions)
+    {
+        NSDictionary<NSString *, NSArray<MacroStep *> *> *macros = nil;
+
+        if ([act keymapType] == KeymapTypeSwipe)
+        {
+            SwipeAction *sa = (SwipeAction *)act;
+            if ([[sa keyCode] isEqualToString:@"null"]) continue;
+            macros = @{ [sa keyCode]: [GestureCompiler compileSwipe:sa options:opt] };
+        }
+        else if ([act keymapType] == KeymapTypeJoystick)
+        {
+            // 停在邊緣按住即可，不用連續模式 (重跑會讓觸控回到中心重新按下)
+            macros = [GestureCompiler compileJoystick:(JoystickAction *)act options:opt];
+        }
+
+        // 依標籤排序，同一份設定每次產生的封包流都一樣
+        for (NSString *label in [[macros allKeys] sortedArrayUsingSelector:@selector(compare:)])
+        {
+            NSNumber *keyIndexNum = [HidKeyCodeMap keyIndexForLabel:label];
+            if (!keyIndexNum)
+            {
+                if (aError) *aError = KeymapProfileMakeError(KeymapValidationUnmappedKey, [NSString stringWithFormat:@"無法取得按鍵 %@ 的索引，請確認對應表。", label], label, [act actionId]);
+                return nil;
+            }
+
+            NSArray<MacroStep *> *steps = macros[label];
+            NSString *name = [NSString stringWithFormat:@"%@_%ld_%@", ([act keymapType] == KeymapTypeSwipe) ? @"SWIPE" : @"JOY", (long)[act actionId], label];
+            NSError *buildErr = nil;
+            NSArray<NSData *> *macroFrames = [BluetoothPacketBuilder buildMacroFramesWithKeyIndex:[keyIndexNum integerValue] steps:steps isContinuous:NO macroName:name screenW:aScreenW screenH:aScreenH error:&buildErr];
+            if (!macroFrames)
+            {
+                if (aError) *aError = KeymapProfileMakeError(KeymapProfileErrorMacroTooLong, [buildErr localizedDescription], label, [act actionId]);
+                return nil;
+            }
+            [frames addObjectsFromArray:macroFrames];
+        }
+    }
+
+    return frames;
+}
+
+
+#pragma mark - Profile → frames
+
+/// 點擊鍵 → 以「螢幕像素中心點」為座標的 layout；其他動作放進 aOutGestures
++ (KeymapLayout *)p_layoutForFile:(KeymapFile *)aFile screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH gestures:(NSMutableArray<id<KeymapAction>> *)aOutGestures
+{
+    CGFloat sx = ([aFile portraitW] > 0) ? (CGFloat)aScreenW / (CGFloat)[aFile portraitW] : 1.0;
+    CGFloat sy = ([aFile portraitH] > 0) ? (CGFloat)aScreenH / (CGFloat)[aFile portraitH] : 1.0;
+
+    KeymapLayout *layout = [[KeymapLayout alloc] initWithCapacity:[[aFile actions] count]];
+    layout.screenW = aScreenW;
+    layout.screenH = aScreenH;
+
+    for (id<KeymapAction> act in [aFile actions])
+    {
+        if (![act isKindOfClass:[TapAction class]])
+        {
+            [aOutGestures addObject:act];
+            continue;
+        }
+
+        TapAction *ta = (TapAction *)act;
+        KeymapRowFlags f = 0;
+        if ([[ta orientation] isEqualToString:@"LANDSCAPE"]) f |= KeymapRowFlagLandscape;
+        if ([ta isPressEvent]) f |= KeymapRowFlagPressEvent;
+
+        NSUInteger row = [layout addRowWithId:[ta actionId] posX:[ta posX] * sx posY:[ta posY] * sy keyLabel:[ta keyCode] flags:f];
+        if (row == NSNotFound) continue;    // KeymapFile 讀檔時已經擋掉，這裡只是保險
+
+        for (HostOS os = HostOSAndroid; os <= HostOSIOS; os++)
+        {
+            HostPayload *hp = [ta payloadForHost:os];
+            if (hp) [layout setHostPayload:hp host:os atRow:row];
+        }
+    }
+
+    return layout;
+}
+
++ (BOOL)p_validateLayout:(KeymapLayout *)aLayout gestures:(NSArray<id<KeymapAction>> *)aGestures error:(NSError **)aError
+{
+    if ([aLayout count] == 0 && [aGestures count] == 0)
+    {
+        if (aError) *aError = KeymapProfileMakeError(KeymapProfileErrorEmptyProfile, @"no points available to write", nil, -1);
+        return NO;
+    }
+
+    NSArray<NSString *> *gestureLabels = [self gestureKeyLabelsForActions:aGestures];
+    KeymapValidationResult check = [aLayout validateReservingLabels:gestureLabels];
+
+    NSString *label = nil;
+    if (check.status != KeymapValidationOK)
+    {
+        NSUInteger row = [aLayout rowForId:check.actionId];
+        label = (row != NSNotFound) ? [aLayout keyLabelAtRow:row] : [KeymapLayout labelForKeyId:check.keyId];
+    }
+
+    switch (check.status)
+    {
+        case KeymapValidationOK:
+            break;
+        case KeymapValidationEmptyKey:
+            if (aError) *aError = KeymapProfileMakeError(check.status, @"all items must have a keycode assigned", nil, check.actionId);
+            return NO;
+        case KeymapValidationDuplicateKey:
+            if (aError) *aError = KeymapProfileMakeError(check.status, [NSString stringWithFormat:@"duplicate key %@", label], label, check.actionId);
+            return NO;
+        case KeymapValidationUnmappedKey:
+            if (aError) *aError = KeymapProfileMakeError(check.status, [NSString stringWithFormat:@"無法取得按鍵 %@ 的索引，請確認對應表。", label], label, check.actionId);
+            return NO;
+    }
+
+    // 滑動 / 搖桿的鍵只在這裡檢查有沒有 keyIndex (App 是編譯巨集時才發現)
+    for (NSString *g in gestureLabels)
+    {
+        if (![HidKeyCodeMap keyIndexForLabel:g])
+        {
+            if (aError) *aError = KeymapProfileMakeError(KeymapValidationUnmappedKey, [NSString stringWithFormat:@"無法取得按鍵 %@ 的索引，請確認對應表。", g], g, -1);
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
++ (BOOL)validateFile:(KeymapFile *)aFile error:(NSError **)aError
+{
+    NSMutableArray<id<KeymapAction>> *gestures = [NSMutableArray array];
+    KeymapLayout *layout = [self p_layoutForFile:aFile screenW:MAX([aFile portraitW], 0) screenH:MAX([aFile portraitH], 0) gestures:gestures];
+    return [self p_validateLayout:layout gestures:gestures error:aError];
+}
+
++ (nullable NSArray<NSData *> *)compileFile:(KeymapFile *)aFile screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError
+{
+    NSInteger W = (aScreenW > 0) ? aScreenW : (([aFile portraitW] > 0) ? [aFile portraitW] : kDefaultScreenW);
+    NSInteger H = (aScreenH > 0) ? aScreenH : (([aFile portraitH] > 0) ? [aFile portraitH] : kDefaultScreenH);
+
+    NSMutableArray<id<KeymapAction>> *gestures = [NSMutableArray array];
+    KeymapLayout *layout = [self p_layoutForFile:aFile screenW:W screenH:H gestures:gestures];
+
+    // 座標已經是像素中心點，只需夾在螢幕內
+    KeymapPixelTransform transform = { 1.0, 0, 0, 0, (CGFloat)(W - 1), (CGFloat)(H - 1) };
+    return [self compileLayout:layout transform:transform gestures:gestures screenW:W screenH:H error:aError];
+}
+
++ (nullable NSArray<NSData *> *)compileLayout:(KeymapLayout *)aLayout transform:(KeymapPixelTransform)aTransform gestures:(NSArray<id<KeymapAction>> *)aGestures screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH error:(NSError **)aError
+{
+    if (![self p_validateLayout:aLayout gestures:aGestures error:aError]) return nil;
+
+    [aLayout sortById];
+    NSMutableArray<NSData *> *frames = [[BluetoothPacketBuilder buildKeyMappingFramesForLayout:aLayout transform:aTransform] mutableCopy];
+
+    NSArray<NSData *> *gestureFrames = [self buildGestureFramesForActions:aGestures screenW:aScreenW screenH:aScreenH error:aError];
+    if (!gestureFrames) return nil;
+    [frames addObjectsFromArray:gestureFrames];
+
+    return frames;
+}
+
+
+#pragma mark - Frames → profile
+
+/// keyIndex → 標籤；同一個 keyIndex 有多個標籤時優先用 HID 相符的那個
++ (NSString *)p_labelForKeyIndex:(NSInteger)aKeyIndex hidCode:(NSInteger)aHidCode
+{
+    NSDictionary<NSString *, NSNumber *> *map = [HidKeyCodeMap keyIndexMap];
+    NSString *fallback = nil;
+    for (NSString *label in [[map allKeys] sortedArrayUsingSelector:@selector(compare:)])
+    {
+        if ([map[label] integerValue] != aKeyIndex) continue;
+        if ([[HidKeyCodeMap hidCodeForLabel:label] integerValue] == aHidCode) return label;
+        if (!fallback) fallback = label;
+    }
+    return fallback ?: @"null";
+}
+
+/// 巨集名稱 "SWIPE_<id>_<label>" / "JOY_<id>_<label>"
++ (BOOL)p_parseMacroName:(NSString *)aName kind:(NSString **)aOutKind actionId:(NSInteger *)aOutId label:(NSString **)aOutLabel
+{
+    NSArray<NSString *> *parts = [aName componentsSeparatedByString:@"_"];
+    if ([parts count] < 3) return NO;
+    if (![parts[0] isEqualToString:@"SWIPE"] && ![parts[0] isEqualToString:@"JOY"]) return NO;
+
+    *aOutKind = parts[0];
+    *aOutId = [parts[1] integerValue];
+    // 標籤本身可能含有 "_"
+    *aOutLabel = [[parts subarrayWithRange:NSMakeRange(2, [parts count] - 2)] componentsJoinedByString:@"_"];
+    return YES;
+}
+
++ (nullable KeymapFile *)decodeFrames:(NSArray<NSData *> *)aFrames screenW:(NSInteger)aScreenW screenH:(NSInteger)aScreenH nickname:(NSString *)aNickname error:(NSError **)aError
+{
+    NSMutableArray<NSDictionary *> *keyMappings = [NSMutableArray array];
+    NSMutableArray<id<KeymapAction>> *gestures = [NSMutableArray array];
+    NSMutableDictionary<NSNumber *, JoystickAction *> *joysticks = [NSMutableDictionary dictionary];
+    NSMutableIndexSet *usedIds = [NSMutableIndexSet indexSet];
+
+    NSMutableArray<MacroStep *> *pendingSteps = [NSMutableArray array];
+
+    for (NSData *frame in aFrames)
+    {
+        NSDictionary *km = [BluetoothPacketParser parseKeyMappingWrite:frame];
+        if (km)
+        {
+            [keyMappings addObject:km];
+            continue;
+        }
+
+        NSDictionary *content = [BluetoothPacketParser parseMacroContentWrite:frame];
+        if (content)
+        {
+            // 第一包代表新的巨集開始
+            if ([content[@"packetIndex"] integerValue] == 1) [pendingSteps removeAllObjects];
+            [pendingSteps addObjectsFromArray:content[@"steps"]];
+            continue;
+        }
+
+        NSDictionary *trigger = [BluetoothPacketParser parseMacroTriggerWrite:frame];
+        if (!trigger) continue;
+
+        NSArray<MacroStep *> *steps = [pendingSteps copy];
+        [pendingSteps removeAllObjects];
+        if ([steps count] == 0) continue;
+
+        NSString *kind = nil;
+        NSString *label = nil;
+        NSInteger actionId = 0;
+        if (![self p_parseMacroName:trigger[@"name"] kind:&kind actionId:&actionId label:&label])
+        {
+            // 不是 App 產生的巨集 → 當成滑動，id 之後再配
+            kind = @"SWIPE";
+            actionId = -1;
+            label = [self p_labelForKeyIndex:[trigger[@"keyIndex"] integerValue] hidCode:-1];
+        }
+
+        if ([kind isEqualToString:@"SWIPE"])
+        {
+            NSMutableArray<GesturePoint *> *points = [NSMutableArray arrayWithCapacity:[steps count] + 1];
+            NSInteger t = 0;
+            for (MacroStep *s in steps)
+            {
+                [points addObject:[GesturePoint pointWithX:[s x] y:[s y] timeMs:t]];
+                t += [s delayMs];
+            }
+            // 單點的巨集 (點擊) 補成兩點，讀檔時才不會被略過
+            if ([points count] == 1)
+            {
+                [points addObject:[GesturePoint pointWithX:[steps[0] x] y:[steps[0] y] timeMs:[GestureCompilerOptions defaultOptions].minStepDelayMs]];
+            }
+
+            if (actionId < 0) actionId = (NSInteger)[gestures count] + 100000;
+            [gestures addObject:[[SwipeAction alloc] initWithId:actionId screenW:aScreenW screenH:aScreenH keyCode:label points:points]];
+            [usedIds addIndex:(NSUInteger)actionId];
+            continue;
+        }
+
+        // 搖桿：中心按下 → 推到邊緣，依位移方向判斷是哪個方向鍵
+        MacroStep *center = steps[0];
+        MacroStep *edge = ([steps count] > 1) ? steps[1] : steps[0];
+        NSInteger dx = [edge x] - [center x];
+        NSInteger dy = [edge y] - [center y];
+
+        JoystickAction *ja = joysticks[@(actionId)];
+        if (!ja)
+        {
+            ja = [[JoystickAction alloc] initWithId:actionId screenW:aScreenW screenH:aScreenH centerX:[center x] centerY:[center y] radius:MAX(labs(dx), labs(dy))];
+            ja.rampMs = MAX((NSInteger)1, [center delayMs]);
+            joysticks[@(actionId)] = ja;
+            [gestures addObject:ja];
+            [usedIds addIndex:(NSUInteger)actionId];
+        }
+
+        if (labs(dx) >= labs(dy))
+        {
+            if (dx < 0) ja.leftKey = label; else ja.rightKey = label;
+        }
+        else
+        {
+            if (dy < 0) ja.upKey = label; else ja.downKey = label;
+        }
+    }
+
+    if ([keyMappings count] == 0 && [gestures count] == 0)
+    {
+        if (aError) *aError = KeymapProfileMakeError(KeymapProfileErrorMalformedFrame, @"no key mapping or macro frames found", nil, -1);
+        return nil;
+    }
+
+    // 點擊鍵：封包裡沒有 id，依寫入順序 (= 原本的 id 順序) 重新編號，避開滑動 / 搖桿用掉的 id
+    NSMutableArray<id<KeymapAction>> *actions = [NSMutableArray arrayWithCapacity:[keyMappings count] + [gestures count]];
+    NSInteger nextId = 0;
+    for (NSDictionary *km in keyMappings)
+    {
+        while ([usedIds containsIndex:(NSUInteger)nextId]) nextId++;
+
+        NSInteger x = [km[@"x"] integerValue];
+        NSInteger y = [km[@"y"] integerValue];
+        NSString *label = [self p_labelForKeyIndex:[km[@"keyIndex"] integerValue] hidCode:[km[@"hidCode"] integerValue]];
+
+        TapAction *ta = [[TapAction alloc] initWithId:nextId++ orientation:@"PORTRAIT" screenW:aScreenW screenH:aScreenH posX:x posY:y keyCode:label pressEvent:NO];
+
+        // 三個主機區段都是 None (預設) 就不用存
+        NSArray<HostPayload *> *defaults = [ta hostPayloads];
+        NSArray<HostPayload *> *hosts = @[ km[@"android"], km[@"windows"], km[@"ios"] ];
+        if (![hosts isEqualToArray:defaults])
+        {
+            for (HostOS os = HostOSAndroid; os <= HostOSIOS; os++)
+            {
+                [ta setPayload:hosts[(NSUInteger)os] forHost:os];
+            }
+        }
+
+        [actions addObject:ta];
+    }
+    [actions addObjectsFromArray:gestures];
+
+    NSDateFormatter *fmt = [[NSDateFormatter alloc] init];
+    [fmt setLocale:[NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"]];
+    [fmt setDateFormat:@"yyyy-MM-dd'T'HH:mm:ssZ"];
+
+    return [[KeymapFile alloc] initWithVersion:[GlobalConfig JSON_VERSION] createdAt:[fmt stringFromDate:[NSDate date]] nickname:aNickname portraitW:aScreenW portraitH:aScreenH rotationWhenSaved:0 actions:actions];
+}
+
+@end
@@ -13,11 +13,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @optional
 - (void)onTapAddPhantomTap;
+- (void)onTapAddSwipe;
+- (void)onTapAddJoystick;
 - (void)onTapPickPhoto;
 - (void)onTapSave;
 - (void)onTapUpload;
 - (void)onTapClear;
+- (void)onUndo;
+- (void)onRedo;
 - (void)onWriteToKeyboard;
+- (void)toggleLivePreview;
 - (void)toggleSidebar;
 
 @end
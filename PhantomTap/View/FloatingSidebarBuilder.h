@@ -18,6 +18,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (NSInteger)getDragButtonTag;
 
+/// Live preview 開關按鈕 (在 expanded bar 上)
++ (NSInteger)getLivePreviewButtonTag;
+
+/// 依開關狀態更新 Live preview 按鈕的底色
++ (void)setLivePreviewButton:(UIButton *)aButton on:(BOOL)aOn;
+
 @end
 
 NS_ASSUME_NONNULL_END
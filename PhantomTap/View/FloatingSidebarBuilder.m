@@ -11,6 +11,7 @@
 static const CGFloat kSidebarWidth = 56.0;
 
 static const NSInteger kDragButtonTag = 9999;
+static const NSInteger kLivePreviewButtonTag = 9998;
 
 
 @implementation FloatingSidebarBuilder
@@ -20,12 +21,36 @@ static const NSInteger kDragButtonTag = 9999;
     return kDragButtonTag;
 }
 
++ (NSInteger)getLivePreviewButtonTag
+{
+    return kLivePreviewButtonTag;
+}
+
++ (void)setLivePreviewButton:(UIButton *)aButton on:(BOOL)aOn
+{
+    UIButtonConfiguration *cfg = [[aButton configuration] copy];
+    [cfg setBaseBackgroundColor:(aOn ? [UIColor systemGreenColor] : nil)];
+    [aButton setConfiguration:cfg];
+}
+
 
 + (UIButton *)makeIconButton:(NSString *)aImageName target:(id)aTarget action:(SEL)aSEL
 {
-    UIButton *btn = [UIButton buttonWithType:UIButtonTypeSystem];
     UIImage *img = [[UIImage imageNamed:aImageName] imageWithRenderingMode:UIImageRenderingModeAlwaysOriginal];
-    [btn setImage:img forState:UIControlStateNormal];
+    return [self makeButtonWithImage:img target:aTarget action:aSEL];
+}
+
+/// 沒有對應圖檔的按鈕改用 SF Symbol，外觀跟 makeIconButton: 一致
++ (UIButton *)makeSymbolButton:(NSString *)aSymbolName target:(id)aTarget action:(SEL)aSEL
+{
+    UIImage *img = [[UIImage systemImageNamed:aSymbolName] imageWithTintColor:[UIColor whiteColor] renderingMode:UIImageRenderingModeAlwaysOriginal];
+    return [self makeButtonWithImage:img target:aTarget action:aSEL];
+}
+
++ (UIButton *)makeButtonWithImage:(UIImage *)aImage target:(id)aTarget action:(SEL)aSEL
+{
+    UIButton *btn = [UIButton buttonWithType:UIButtonTypeSystem];
+    [btn setImage:aImage forState:UIControlStateNormal];
     [btn setTintColor:[UIColor clearColor]];
     
     UIButtonConfiguration *btnConfig = [UIButtonConfiguration filledButtonConfiguration];
@@ -167,20 +192,31 @@ static const NSInteger kDragButtonTag = 9999;
     
     // ✅【關鍵修正】只加入功能按鈕
     UIButton *add = [self makeIconButton:@"add_donut" target:aTarget action:@selector(onTapAddPhantomTap)];
+    UIButton *addSwipe = [self makeSymbolButton:@"hand.draw" target:aTarget action:@selector(onTapAddSwipe)];
+    UIButton *addJoystick = [self makeSymbolButton:@"dpad" target:aTarget action:@selector(onTapAddJoystick)];
     UIButton *pickPhoto = [self makeIconButton:@"icon_photo" target:aTarget action:@selector(onTapPickPhoto)];
     UIButton *save = [self makeIconButton:@"save_config_to_json" target:aTarget action:@selector(onTapSave)];
     UIButton *upload = [self makeIconButton:@"load_from_json" target:aTarget action:@selector(onTapUpload)];
     UIButton *clear = [self makeIconButton:@"icon_clear" target:aTarget action:@selector(onTapClear)];
+    UIButton *undo = [self makeSymbolButton:@"arrow.uturn.backward" target:aTarget action:@selector(onUndo)];
+    UIButton *redo = [self makeSymbolButton:@"arrow.uturn.forward" target:aTarget action:@selector(onRedo)];
     UIButton *writeToKeyboard = [self makeIconButton:@"flash_to_keyboard" target:aTarget action:@selector(onWriteToKeyboard)];
+    UIButton *livePreview = [self makeSymbolButton:@"dot.radiowaves.left.and.right" target:aTarget action:@selector(toggleLivePreview)];
+    [livePreview setTag:kLivePreviewButtonTag];
     UIButton *user = [self makeIconButton:@"icon_user" target:aTarget action:nil];
     UIButton *collapse= [self makeIconButton:@"icon_collapse" target:aTarget action:@selector(toggleSidebar)];
 
     [buttonStackView addArrangedSubview:add];
+    [buttonStackView addArrangedSubview:addSwipe];
+    [buttonStackView addArrangedSubview:addJoystick];
     [buttonStackView addArrangedSubview:pickPhoto];
     [buttonStackView addArrangedSubview:save];
     [buttonStackView addArrangedSubview:upload];
     [buttonStackView addArrangedSubview:clear];
+    [buttonStackView addArrangedSubview:undo];
+    [buttonStackView addArrangedSubview:redo];
     [buttonStackView addArrangedSubview:writeToKeyboard];
+    [buttonStackView addArrangedSubview:livePreview];
     [buttonStackView addArrangedSubview:user];
     [buttonStackView addArrangedSubview:collapse];
     
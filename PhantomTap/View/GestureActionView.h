@@ -0,0 +1,60 @@
+//
+//  GestureActionView.h
+//  PhantomTap
+//
+//  Created by ethanlin on 2026/01/12.
+//
+//  編輯畫面上的滑動 / 搖桿：畫出路徑或搖桿範圍，可點選、拖曳整組移動、刪除
+//  view 鋪滿容器，只有碰到路徑 / 搖桿範圍時才接觸控，其餘交給底下的 view
+//
+
+#import <UIKit/UIKit.h>
+#import "KeymapModels.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class GestureActionView;
+
+typedef void (^GestureActionViewHandler)(GestureActionView *aGestureView);
+
+/// 搖桿方向 (依 W / A / S / D 的順序)
+typedef NS_ENUM(NSInteger, JoystickDirection)
+{
+    JoystickDirectionUp = 0,
+    JoystickDirectionLeft = 1,
+    JoystickDirectionDown = 2,
+    JoystickDirectionRight = 3,
+};
+
+@interface GestureActionView : UIView
+
+/// SwipeAction 或 JoystickAction；座標為 action 自己的 screenW / screenH 像素
+@property (nonatomic, strong, readonly) id<KeymapAction> action;
+@property (nonatomic, assign) BOOL viewSelected;
+
+/// 搖桿：下一個按鍵要指定給的方向；點搖桿的某一側可切換
+@property (nonatomic, assign) JoystickDirection armedDirection;
+
+/// 建構：提供模型與回呼（任何一個可為 nil）
+/// aOnChangeCommitted：拖曳 / 縮放放開且有變動時呼叫
+- (instancetype)initWithAction:(id<KeymapAction>)aAction
+                    onSelected:(nullable GestureActionViewHandler)aOnSelected
+                      onDelete:(nullable GestureActionViewHandler)aOnDelete
+             onChangeCommitted:(nullable GestureActionViewHandler)aOnChangeCommitted NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)initWithFrame:(CGRect)aFrame NS_UNAVAILABLE;
+- (instancetype)initWithCoder:(NSCoder *)aCoder NS_UNAVAILABLE;
+
+
+/// 目前會被 updateKeyCode: 覆寫的按鍵 (滑動：keyCode；搖桿：armedDirection 那一格)
+- (NSString *)currentKeyCode;
+
+/// 寫回 action (空字串視為 @"null")；搖桿寫完後 armedDirection 換到下一個方向
+- (void)updateKeyCode:(NSString *)aKey;
+
+/// action 被外部改動後重畫
+- (void)refresh;
+
+@end
+
+NS_ASSUME_NONNULL_END
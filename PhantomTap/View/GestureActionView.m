@@ -0,0 +1,496 @@
+//
+//  GestureActionView.m
+//  PhantomTap
+//
+//  Created by ethanlin on 2026/01/12.
+//
+
+#import "GestureActionView.h"
+
+static const CGFloat kGAVHitSlop = 22.0;            // 離路徑多近算點到 (pt)
+static const CGFloat kGAVDragThreshold = 4.0;       // 移動超過才算拖曳 (pt)
+static const CGFloat kGAVDeleteSize = 24.0;
+static const CGFloat kGAVMinJoystickRadius = 24.0;  // 搖桿最小半徑 (pt)
+
+
+/// 點到線段 ab 的距離
+static CGFloat GAVDistanceToSegment(CGPoint aP, CGPoint aA, CGPoint aB)
+{
+    CGFloat vx = aB.x - aA.x, vy = aB.y - aA.y;
+    CGFloat len2 = vx * vx + vy * vy;
+    CGFloat f = (len2 > 0) ? ((aP.x - aA.x) * vx + (aP.y - aA.y) * vy) / len2 : 0;
+    f = MAX(0, MIN(f, 1));
+    return hypot(aP.x - (aA.x + vx * f), aP.y - (aA.y + vy * f));
+}
+
+
+@interface GestureActionView()
+{
+    CAShapeLayer *_pathLayer;
+    CAShapeLayer *_markerLayer;         // 滑動起點 / 搖桿中心
+    NSArray<UILabel *> *_keyLabels;     // 滑動 1 個；搖桿 4 個 (依 JoystickDirection)
+    CGRect _contentBox;                 // 路徑 / 搖桿範圍 (本地座標)
+
+    CGPoint _touchStart;
+    BOOL _didMove;
+    BOOL _isDeleting;
+    NSArray<GesturePoint *> *_pointsAtTouchStart;
+    CGPoint _centerAtTouchStart;
+    CGFloat _radiusAtPinchStart;
+}
+
+@property (nonatomic, strong, readwrite) id<KeymapAction> action;
+
+@property (nonatomic, copy, nullable) GestureActionViewHandler onSelected;
+@property (nonatomic, copy, nullable) GestureActionViewHandler onDelete;
+@property (nonatomic, copy, nullable) GestureActionViewHandler onChangeCommitted;
+
+@property (nonatomic, strong) UIImageView *delecteButtonView;
+
+@end
+
+
+@implementation GestureActionView
+
+#pragma mark - Init
+
+- (instancetype)initWithFrame:(CGRect)aFrame
+{
+    NSAssert(NO, @"請使用 initWithAction:...");
+    return nil;
+}
+
+- (instancetype)initWithCoder:(NSCoder *)aCoder
+{
+    NSAssert(NO, @"請使用 initWithAction:...");
+    return nil;
+}
+
+- (instancetype)initWithAction:(id<KeymapAction>)aAction onSelected:(GestureActionViewHandler)aOnSelected onDelete:(GestureActionViewHandler)aOnDelete onChangeCommitted:(GestureActionViewHandler)aOnChangeCommitted
+{
+    NSAssert([aAction keymapType] == KeymapTypeSwipe || [aAction keymapType] == KeymapTypeJoystick, @"只接受 SwipeAction / JoystickAction");
+
+    self = [super initWithFrame:CGRectZero];
+    if (!self) return nil;
+
+    _action = aAction;
+    _onSelected = [aOnSelected copy];
+    _onDelete = [aOnDelete copy];
+    _onChangeCommitted = [aOnChangeCommitted copy];
+    _armedDirection = JoystickDirectionUp;
+
+    // 鋪滿容器，跟著容器大小重畫
+    [self setUserInteractionEnabled:YES];
+    [self setBackgroundColor:[UIColor clearColor]];
+    [self setAutoresizingMask:(UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight)];
+
+    self -> _pathLayer = [CAShapeLayer layer];
+    [self -> _pathLayer setLineWidth:3.0];
+    [self -> _pathLayer setLineCap:kCALineCapRound];
+    [self -> _pathLayer setLineJoin:kCALineJoinRound];
+    [[self layer] addSublayer:self -> _pathLayer];
+
+    self -> _markerLayer = [CAShapeLayer layer];
+    [[self layer] addSublayer:self -> _markerLayer];
+
+    NSUInteger labelCount = ([aAction keymapType] == KeymapTypeJoystick) ? 4 : 1;
+    NSMutableArray<UILabel *> *labels = [NSMutableArray arrayWithCapacity:labelCount];
+    for (NSUInteger i = 0; i < labelCount; i++)
+    {
+        UILabel *label = [[UILabel alloc] initWithFrame:CGRectMake(0, 0, 44, 22)];
+        [label setTextAlignment:NSTextAlignmentCenter];
+        [label setFont:[UIFont systemFontOfSize:14 weight:UIFontWeightSemibold]];
+        [label setTextColor:[UIColor whiteColor]];
+        [[label layer] setCornerRadius:4];
+        [label setClipsToBounds:YES];
+        [self addSubview:label];
+        [labels addObject:label];
+    }
+    self -> _keyLabels = labels;
+
+    self -> _delecteButtonView = [[UIImageView alloc] initWithImage:[UIImage imageNamed:@"delecte_view"]];
+    [self -> _delecteButtonView setFrame:CGRectMake(0, 0, kGAVDeleteSize, kGAVDeleteSize)];
+    [self -> _delecteButtonView setHidden:YES];
+    [self addSubview:self -> _delecteButtonView];
+
+    if ([aAction keymapType] == KeymapTypeJoystick)
+    {
+        UIPinchGestureRecognizer *pinch = [[UIPinchGestureRecognizer alloc] initWithTarget:self action:@selector(p_onPinch:)];
+        [self addGestureRecognizer:pinch];
+    }
+
+    return self;
+}
+
+
+#pragma mark - Public API
+
+- (void)setViewSelected:(BOOL)aViewSelected
+{
+    self -> _viewSelected = aViewSelected;
+    [self -> _delecteButtonView setHidden:!aViewSelected];
+    [self refresh];
+}
+
+- (void)setArmedDirection:(JoystickDirection)aArmedDirection
+{
+    self -> _armedDirection = aArmedDirection;
+    [self refresh];
+}
+
+- (NSString *)currentKeyCode
+{
+    NSString *key = nil;
+    if ([self -> _action keymapType] == KeymapTypeSwipe)
+    {
+        key = [(SwipeAction *)self -> _action keyCode];
+    }
+    else
+    {
+        key = [self p_joystickKeyForDirection:self -> _armedDirection];
+    }
+    return [key length] ? key : @"null";
+}
+
+- (void)updateKeyCode:(NSString *)aKey
+{
+    if ([aKey length] == 0) aKey = @"null";
+
+    if ([self -> _action keymapType] == KeymapTypeSwipe)
+    {
+        [(SwipeAction *)self -> _action setKeyCode:aKey];
+        [self refresh];
+        return;
+    }
+
+    // 搖桿：依序 上 → 左 → 下 → 右，直接按 W A S D 就能指定完
+    JoystickAction *ja = (JoystickAction *)self -> _action;
+    switch (self -> _armedDirection)
+    {
+        case JoystickDirectionUp:    [ja setUpKey:aKey]; break;
+        case JoystickDirectionLeft:  [ja setLeftKey:aKey]; break;
+        case JoystickDirectionDown:  [ja setDownKey:aKey]; break;
+        case JoystickDirectionRight: [ja setRightKey:aKey]; break;
+    }
+    [self setArmedDirection:(self -> _armedDirection + 1) % 4];
+}
+
+- (void)refresh
+{
+    UIBezierPath *path = [UIBezierPath bezierPath];
+    UIBezierPath *marker = [UIBezierPath bezierPath];
+    CGRect box = CGRectNull;
+
+    if ([self -> _action keymapType] == KeymapTypeSwipe)
+    {
+        SwipeAction *sa = (SwipeAction *)self -> _action;
+        NSArray<GesturePoint *> *points = [sa points];
+
+        for (NSUInteger i = 0; i < [points count]; i++)
+        {
+            CGPoint p = [self p_viewPointForPixelX:points[i].x y:points[i].y];
+            if (i == 0) [path moveToPoint:p]; else [path addLineToPoint:p];
+            box = CGRectUnion(box, CGRectMake(p.x, p.y, 0, 0));
+        }
+
+        if ([points count] > 0)
+        {
+            CGPoint start = [self p_viewPointForPixelX:[points firstObject].x y:[points firstObject].y];
+            CGPoint end = [self p_viewPointForPixelX:[points lastObject].x y:[points lastObject].y];
+            [marker appendPath:[UIBezierPath bezierPathWithArcCenter:start radius:7 startAngle:0 endAngle:2 * M_PI clockwise:YES]];
+            [marker appendPath:[UIBezierPath bezierPathWithArcCenter:end radius:3 startAngle:0 endAngle:2 * M_PI clockwise:YES]];
+
+            [self p_setLabel:self -> _keyLabels[0] key:[sa keyCode] center:CGPointMake(start.x, start.y - 20) armed:NO];
+        }
+    }
+    else
+    {
+        JoystickAction *ja = (JoystickAction *)self -> _action;
+        CGPoint c = [self p_viewPointForPixelX:[ja centerX] y:[ja centerY]];
+        CGFloat r = [self p_viewLengthForPixels:[ja radius]];
+
+        [path appendPath:[UIBezierPath bezierPathWithArcCenter:c radius:r startAngle:0 endAngle:2 * M_PI clockwise:YES]];
+        [marker appendPath:[UIBezierPath bezierPathWithArcCenter:c radius:6 startAngle:0 endAngle:2 * M_PI clockwise:YES]];
+        box = CGRectMake(c.x - r, c.y - r, r * 2, r * 2);
+
+        // 標籤放在各方向邊緣內側
+        CGFloat inset = MAX(r - 16, 0);
+        CGPoint offsets[4] = { {0, -inset}, {-inset, 0}, {0, inset}, {inset, 0} };
+        for (NSInteger dir = 0; dir < 4; dir++)
+        {
+            CGPoint at = CGPointMake(c.x + offsets[dir].x, c.y + offsets[dir].y);
+            BOOL armed = (self -> _viewSelected && dir == self -> _armedDirection);
+            [self p_setLabel:self -> _keyLabels[dir] key:[self p_joystickKeyForDirection:dir] center:at armed:armed];
+        }
+    }
+
+    UIColor *stroke = self -> _viewSelected ? [UIColor systemOrangeColor] : [[UIColor whiteColor] colorWithAlphaComponent:0.8];
+    BOOL isJoystick = ([self -> _action keymapType] == KeymapTypeJoystick);
+
+    [self -> _pathLayer setPath:[path CGPath]];
+    [self -> _pathLayer setStrokeColor:[stroke CGColor]];
+    [self -> _pathLayer setFillColor:isJoystick ? [[[UIColor whiteColor] colorWithAlphaComponent:0.15] CGColor] : [[UIColor clearColor] CGColor]];
+
+    [self -> _markerLayer setPath:[marker CGPath]];
+    [self -> _markerLayer setFillColor:[stroke CGColor]];
+
+    self -> _contentBox = CGRectIsNull(box) ? CGRectZero : box;
+    [self -> _delecteButtonView setFrame:CGRectMake(CGRectGetMaxX(self -> _contentBox), CGRectGetMinY(self -> _contentBox) - kGAVDeleteSize, kGAVDeleteSize, kGAVDeleteSize)];
+}
+
+- (void)layoutSubviews
+{
+    [super layoutSubviews];
+    [self refresh];
+}
+
+// 座標跟視窗走，換視窗時也要重畫
+- (void)didMoveToWindow
+{
+    [super didMoveToWindow];
+    [self refresh];
+}
+
+
+#pragma mark - Touch / Drag
+
+- (BOOL)pointInside:(CGPoint)point withEvent:(UIEvent *)event
+{
+    if (self -> _viewSelected && CGRectContainsPoint(CGRectInset([self -> _delecteButtonView frame], -6, -6), point))
+    {
+        return YES;
+    }
+
+    if ([self -> _action keymapType] == KeymapTypeJoystick)
+    {
+        JoystickAction *ja = (JoystickAction *)self -> _action;
+        CGPoint c = [self p_viewPointForPixelX:[ja centerX] y:[ja centerY]];
+        return hypot(point.x - c.x, point.y - c.y) <= [self p_viewLengthForPixels:[ja radius]] + kGAVHitSlop;
+    }
+
+    // 只有碰到路徑附近才接，其他位置讓給底下的點擊鍵
+    NSArray<GesturePoint *> *points = [(SwipeAction *)self -> _action points];
+    for (NSUInteger i = 0; i < [points count]; i++)
+    {
+        CGPoint a = [self p_viewPointForPixelX:points[i].x y:points[i].y];
+        CGPoint b = (i + 1 < [points count]) ? [self p_viewPointForPixelX:points[i + 1].x y:points[i + 1].y] : a;
+        if (GAVDistanceToSegment(point, a, b) <= kGAVHitSlop) return YES;
+    }
+    return NO;
+}
+
+- (void)touchesBegan:(NSSet<UITouch *> *)touches withEvent:(UIEvent *)event
+{
+    UITouch *t = [touches anyObject];
+    if (!t) return;
+
+    CGPoint p = [t locationInView:self];
+    self -> _isDeleting = (self -> _viewSelected && CGRectContainsPoint(CGRectInset([self -> _delecteButtonView frame], -6, -6), p));
+    if (self -> _isDeleting)
+    {
+        if (self.onDelete) self.onDelete(self);
+        return;
+    }
+
+    self -> _touchStart = p;
+    self -> _didMove = NO;
+    if ([self -> _action keymapType] == KeymapTypeSwipe)
+    {
+        self -> _pointsAtTouchStart = [[(SwipeAction *)self -> _action points] copy];
+    }
+    else
+    {
+        JoystickAction *ja = (JoystickAction *)self -> _action;
+        self -> _centerAtTouchStart = CGPointMake([ja centerX], [ja centerY]);
+    }
+
+    if (self.onSelected) self.onSelected(self);
+}
+
+- (void)touchesMoved:(NSSet<UITouch *> *)touches withEvent:(UIEvent *)event
+{
+    UITouch *t = [touches anyObject];
+    if (!t || self -> _isDeleting) return;
+
+    CGPoint p = [t locationInView:self];
+    CGFloat dx = p.x - self -> _touchStart.x;
+    CGFloat dy = p.y - self -> _touchStart.y;
+    if (!self -> _didMove && hypot(dx, dy) < kGAVDragThreshold) return;
+    self -> _didMove = YES;
+
+    [self p_moveByViewDelta:CGPointMake(dx, dy)];
+    [self refresh];
+}
+
+- (void)touchesEnded:(NSSet<UITouch *> *)touches withEvent:(UIEvent *)event
+{
+    if (self -> _isDeleting) return;
+
+    if (self -> _didMove)
+    {
+        if (self.onChangeCommitted) self.onChangeCommitted(self);
+        return;
+    }
+
+    // 沒拖動：點搖桿的哪一側，下一個按鍵就指定給那個方向
+    UITouch *t = [touches anyObject];
+    if (t && [self -> _action keymapType] == KeymapTypeJoystick)
+    {
+        JoystickAction *ja = (JoystickAction *)self -> _action;
+        CGPoint c = [self p_viewPointForPixelX:[ja centerX] y:[ja centerY]];
+        CGPoint p = [t locationInView:self];
+        CGFloat dx = p.x - c.x, dy = p.y - c.y;
+
+        if (hypot(dx, dy) > [self p_viewLengthForPixels:[ja radius]] * 0.35)
+        {
+            if (fabs(dx) >= fabs(dy)) [self setArmedDirection:(dx < 0) ? JoystickDirectionLeft : JoystickDirectionRight];
+            else [self setArmedDirection:(dy < 0) ? JoystickDirectionUp : JoystickDirectionDown];
+        }
+    }
+}
+
+- (void)touchesCancelled:(NSSet<UITouch *> *)touches withEvent:(UIEvent *)event
+{
+    if (self -> _isDeleting) return;
+
+    if (self -> _didMove && self.onChangeCommitted) self.onChangeCommitted(self);
+}
+
+- (void)p_onPinch:(UIPinchGestureRecognizer *)aPinch
+{
+    JoystickAction *ja = (JoystickAction *)self -> _action;
+
+    if ([aPinch state] == UIGestureRecognizerStateBegan)
+    {
+        self -> _radiusAtPinchStart = [ja radius];
+    }
+    else if ([aPinch state] == UIGestureRecognizerStateChanged)
+    {
+        CGFloat minRadius = [self p_pixelLengthForView:kGAVMinJoystickRadius];
+        [ja setRadius:MAX(minRadius, self -> _radiusAtPinchStart * [aPinch scale])];
+        [self refresh];
+    }
+    else if ([aPinch state] == UIGestureRecognizerStateEnded || [aPinch state] == UIGestureRecognizerStateCancelled)
+    {
+        if ([ja radius] != self -> _radiusAtPinchStart && self.onChangeCommitted) self.onChangeCommitted(self);
+    }
+}
+
+
+#pragma mark - Helper
+
+/// action 座標系 (像素)；沒有記錄時當成本機螢幕
+- (CGSize)p_screenSize
+{
+    CGSize s = CGSizeZero;
+    if ([self -> _action keymapType] == KeymapTypeSwipe)
+    {
+        s = CGSizeMake([(SwipeAction *)self -> _action screenW], [(SwipeAction *)self -> _action screenH]);
+    }
+    else
+    {
+        s = CGSizeMake([(JoystickAction *)self -> _action screenW], [(JoystickAction *)self -> _action screenH]);
+    }
+
+    if (s.width <= 0 || s.height <= 0)
+    {
+        s = [[UIScreen mainScreen] nativeBounds].size;
+    }
+    return s;
+}
+
+/// action 像素 → 本機螢幕 points 的比例 (action 的 screenW 跟本機不同時等比換算)
+- (CGFloat)p_pointsPerPixel
+{
+    CGSize s = [self p_screenSize];
+    CGFloat nativeW = [[UIScreen mainScreen] nativeBounds].size.width;
+    CGFloat scale = [[UIScreen mainScreen] nativeScale];
+    if (s.width <= 0 || scale <= 0) return 0;
+    return nativeW / s.width / scale;
+}
+
+/// 跟點擊鍵一樣以視窗座標換算 (-[MainViewController screenCenterInPixelsForView:])，容器不在 (0, 0) 時也對得上
+- (CGPoint)p_viewPointForPixelX:(CGFloat)aX y:(CGFloat)aY
+{
+    CGSize s = [self p_screenSize];
+    CGSize nb = [[UIScreen mainScreen] nativeBounds].size;
+    CGFloat scale = [[UIScreen mainScreen] nativeScale];
+    if (s.width <= 0 || s.height <= 0 || scale <= 0) return CGPointZero;
+
+    CGPoint inWindow = CGPointMake(aX * nb.width / s.width / scale, aY * nb.height / s.height / scale);
+    return [self convertPoint:inWindow fromView:nil];
+}
+
+- (CGFloat)p_viewLengthForPixels:(CGFloat)aPixels
+{
+    return aPixels * [self p_pointsPerPixel];
+}
+
+- (CGFloat)p_pixelLengthForView:(CGFloat)aLength
+{
+    CGFloat ppp = [self p_pointsPerPixel];
+    return (ppp > 0) ? aLength / ppp : aLength;
+}
+
+/// 以觸控開始時的位置為基準整組平移，夾在螢幕內
+- (void)p_moveByViewDelta:(CGPoint)aDelta
+{
+    CGSize s = [self p_screenSize];
+    CGSize nb = [[UIScreen mainScreen] nativeBounds].size;
+    CGFloat scale = [[UIScreen mainScreen] nativeScale];
+    if (nb.width <= 0 || nb.height <= 0) return;
+
+    CGFloat dx = aDelta.x * scale * s.width / nb.width;
+    CGFloat dy = aDelta.y * scale * s.height / nb.height;
+
+    if ([self -> _action keymapType] == KeymapTypeSwipe)
+    {
+        NSArray<GesturePoint *> *src = self -> _pointsAtTouchStart;
+        if ([src count] == 0) return;
+
+        CGFloat minX = CGFLOAT_MAX, minY = CGFLOAT_MAX, maxX = -CGFLOAT_MAX, maxY = -CGFLOAT_MAX;
+        for (GesturePoint *p in src)
+        {
+            minX = MIN(minX, p.x); maxX = MAX(maxX, p.x);
+            minY = MIN(minY, p.y); maxY = MAX(maxY, p.y);
+        }
+        dx = MAX(-minX, MIN(dx, s.width - 1 - maxX));
+        dy = MAX(-minY, MIN(dy, s.height - 1 - maxY));
+
+        NSMutableArray<GesturePoint *> *moved = [NSMutableArray arrayWithCapacity:[src count]];
+        for (GesturePoint *p in src)
+        {
+            [moved addObject:[GesturePoint pointWithX:p.x + dx y:p.y + dy timeMs:p.timeMs]];
+        }
+        [(SwipeAction *)self -> _action setPoints:moved];
+    }
+    else
+    {
+        JoystickAction *ja = (JoystickAction *)self -> _action;
+        [ja setCenterX:MAX(0, MIN(self -> _centerAtTouchStart.x + dx, s.width - 1))];
+        [ja setCenterY:MAX(0, MIN(self -> _centerAtTouchStart.y + dy, s.height - 1))];
+    }
+}
+
+- (nullable NSString *)p_joystickKeyForDirection:(NSInteger)aDirection
+{
+    JoystickAction *ja = (JoystickAction *)self -> _action;
+    switch (aDirection)
+    {
+        case JoystickDirectionUp:    return [ja upKey];
+        case JoystickDirectionLeft:  return [ja leftKey];
+        case JoystickDirectionDown:  return [ja downKey];
+        case JoystickDirectionRight: return [ja rightKey];
+    }
+    return nil;
+}
+
+- (void)p_setLabel:(UILabel *)aLabel key:(nullable NSString *)aKey center:(CGPoint)aCenter armed:(BOOL)aArmed
+{
+    BOOL unset = ([aKey length] == 0 || [aKey isEqualToString:@"null"]);
+    [aLabel setText:unset ? (aArmed ? @"?" : @"") : aKey];
+    [aLabel setBackgroundColor:aArmed ? [[UIColor systemOrangeColor] colorWithAlphaComponent:0.8] : [UIColor clearColor]];
+    [aLabel setCenter:aCenter];
+}
+
+@end
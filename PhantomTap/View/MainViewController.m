@@ -11,9 +11,18 @@
 #import "BluetoothPacketBuilder.h"
 #import "DeviceResponse.h"
 #import "BTManager.h"
+#import "BTMetrics.h"
+#import "BTLivePreviewStream.h"
 #import "HidKeyCodeMap.h"
 #import "KeymapModels.h"
+#import "KeymapLayout.h"
+#if DEBUG
+#import "KeymapLayoutBenchmark.h"
+#endif
+#import "KeymapProfileCompiler.h"
+#import "EditorJournal.h"
 #import "PhantomTapView.h"
+#import "GestureActionView.h"
 #import "ThirdPartySignInManager.h"
 #import "GlobalConfig.h"
 #import "Utils.h"
@@ -33,14 +42,30 @@
     NSLayoutConstraint *_expandedLeadingConstraint;
     
     // ===== 封包佇列 + 寫入狀態 + Popup =====
-    NSMutableArray<NSData *> *_commandQueue;
     BOOL _isWritingBle;
     CustomPopupDialog *_sendingPopup;
 }
 
 @property (nonatomic, strong) NSMutableArray<PhantomTapView *> *phantomTapViewsList;
+/// 從 JSON 載入的滑動 / 搖桿動作 (目前沒有對應的 view，存檔與寫入時一起帶上)
+@property (nonatomic, strong) NSMutableArray<id<KeymapAction>> *gestureActionsList;
+@property (nonatomic, strong) NSMutableArray<GestureActionView *> *gestureViewsList;
+@property (nonatomic, weak) GestureActionView *selectedGestureView;
 @property (nonatomic, weak) PhantomTapView *selectedView;
 @property (nonatomic, assign) NSInteger viewIdCouner;
+/// 所有點擊鍵的欄位資料 (TapAction / PhantomTapView 都是它的一列)
+@property (nonatomic, strong) KeymapLayout *keymapLayout;
+/// 編輯操作的 journal (undo / redo、crash 後還原)
+@property (nonatomic, strong) EditorJournal *editorJournal;
+
+// 錄製滑動路徑中 (按下滑動鈕後蓋在畫面上)
+@property (nonatomic, strong, nullable) UIView *swipeRecordOverlay;
+@property (nonatomic, strong, nullable) CAShapeLayer *swipeRecordLayer;
+@property (nonatomic, strong, nullable) NSMutableArray<GesturePoint *> *swipeRecordPoints;
+@property (nonatomic, assign) CFTimeInterval swipeRecordStartTime;
+/// Live preview：拖曳時即時把單顆按鍵的位置送到鍵盤
+@property (nonatomic, assign) BOOL livePreviewEnabled;
+@property (nonatomic, strong) BTLivePreviewStream *livePreviewStream;
 
 @property (nonatomic, strong, nullable) CustomPopupDialog *currentPopup;
 @property (nonatomic, weak) UIStackView *jsonFilesStackView;
@@ -61,12 +86,22 @@
     [self setupBTManagerCallback];
     
     self -> _phantomTapViewsList = [NSMutableArray array];
+    self -> _gestureActionsList = [NSMutableArray array];
+    self -> _gestureViewsList = [NSMutableArray array];
     self -> _viewIdCouner = 0;
+    self -> _keymapLayout = [[KeymapLayout alloc] initWithCapacity:64];
     
-    self -> _commandQueue = [NSMutableArray array];
     self -> _isWritingBle = NO;
     self -> _sendingPopup = nil;
     
+    // 編輯 journal：上次沒存檔 / crash 的編輯內容直接還原
+    self -> _editorJournal = [[EditorJournal alloc] initWithPath:[EditorJournal defaultPath]];
+    [self restoreFromEditorJournal];
+    
+    self -> _livePreviewStream = [[BTLivePreviewStream alloc] init];
+    self -> _livePreviewEnabled = NO;
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onAppDidEnterBackground:) name:UIApplicationDidEnterBackgroundNotification object:nil];
+    
     // Test API
     [self testAPI];
 }
@@ -112,11 +147,17 @@
         NSDictionary *km = [BluetoothPacketParser parseKeyMappingRead:aData];
         if (km)
         {
-            NSLog(@"[PARSE] keyIndex=%@, hid=%@, x=%@, y=%@", km[@"keyIndex"], km[@"hidCode"], km[@"x"], km[@"y"]);
+            NSLog(@"[PARSE] keyIndex=%@, hid=%@, x=%@, y=%@, android=%@, windows=%@, ios=%@", km[@"keyIndex"], km[@"hidCode"], km[@"x"], km[@"y"], km[@"android"], km[@"windows"], km[@"ios"]);
             return;
         }
         
         DeviceResponse *mr = [BluetoothPacketParser parse:aData];
+        if (mr && [mr kind] == DeviceResponseKindAccessories)
+        {
+            // 周邊列表由 BTManager 更新到各自的 session，這裡不用處理
+            return;
+        }
+        
         if (mr)
         {
             NSLog(@"[PARSE] macro result keyIndex=%ld, success=%d", (long)mr.keyIndex, mr.success);
@@ -354,6 +395,7 @@
     TapAction *action = [[TapAction alloc] initWithId:self.viewIdCouner++ orientation:orientationStr screenW:(NSInteger)nb.width screenH:(NSInteger)nb.height posX:posX_pts posY:posY_pts keyCode:@"null" pressEvent:YES];
     
     PhantomTapView *ptv = [self createAndAddPhantomTapViewWithAction:action];
+    [self -> _editorJournal recordOp:[EditorOp addOpWithEntry:[self editorEntryForView:ptv]]];
     
     [self handleTapViewSeleted:ptv];
     
@@ -397,6 +439,46 @@
     */
 }
 
+- (void)onTapAddSwipe
+{
+    if (self -> _swipeRecordOverlay) return;
+    
+    // 蓋一層透明 overlay，使用者在上面畫一次就是滑動路徑
+    UIView *overlay = [[UIView alloc] initWithFrame:[self -> _contentView bounds]];
+    [overlay setAutoresizingMask:(UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight)];
+    [overlay setBackgroundColor:[[UIColor blackColor] colorWithAlphaComponent:0.25]];
+    
+    CAShapeLayer *line = [CAShapeLayer layer];
+    [line setStrokeColor:[[UIColor systemOrangeColor] CGColor]];
+    [line setFillColor:[[UIColor clearColor] CGColor]];
+    [line setLineWidth:3.0];
+    [[overlay layer] addSublayer:line];
+    
+    [overlay addGestureRecognizer:[[UIPanGestureRecognizer alloc] initWithTarget:self action:@selector(onSwipeRecordPan:)]];
+    [overlay addGestureRecognizer:[[UITapGestureRecognizer alloc] initWithTarget:self action:@selector(endSwipeRecording)]];
+    
+    [self -> _contentView addSubview:overlay];
+    self -> _swipeRecordOverlay = overlay;
+    self -> _swipeRecordLayer = line;
+    
+    [self showBottomToast:NSLocalizedString(@"draw_the_swipe_path_tap_to_cancel", nil)];
+}
+
+- (void)onTapAddJoystick
+{
+    CGSize nb = [[UIScreen mainScreen] nativeBounds].size;
+    CGSize vb = [self -> _contentView bounds].size;
+    if (vb.width <= 0 || vb.height <= 0) return;
+    
+    // 預設放在畫面中央，半徑 60pt；座標存成像素
+    const CGFloat defaultRadius = 60.0;
+    JoystickAction *ja = [[JoystickAction alloc] initWithId:self -> _viewIdCouner++ screenW:(NSInteger)nb.width screenH:(NSInteger)nb.height centerX:nb.width * 0.5 centerY:nb.height * 0.5 radius:defaultRadius * [[UIScreen mainScreen] nativeScale]];
+    
+    GestureActionView *gv = [self createAndAddGestureViewWithAction:ja];
+    [self -> _editorJournal recordOp:[EditorOp addOpWithEntry:[EditorEntry entryWithGesture:ja]]];
+    [self handleGestureViewSelected:gv];
+}
+
 - (void)onTapPickPhoto
 {
     if (@available(iOS 14, *))
@@ -431,7 +513,7 @@
 
 - (void)onTapClear
 {
-    if ([self -> _phantomTapViewsList count] == 0)
+    if ([self -> _phantomTapViewsList count] == 0 && [self -> _gestureActionsList count] == 0)
     {
         return;
     }
@@ -447,12 +529,21 @@
         __strong typeof(weakSelf) strongSelf = weakSelf;
         if (!strongSelf) return;
         
-        for (PhantomTapView *v in self -> _phantomTapViewsList)
+        // 記成一筆可 undo 的操作，誤按清除時可以還原
+        [strongSelf -> _editorJournal recordOp:[EditorOp replaceOpWithBefore:[strongSelf editorEntriesForCurrentViews] after:@[]]];
+        
+        for (PhantomTapView *v in strongSelf -> _phantomTapViewsList)
         {
             [v removeFromSuperview];
+            [[v action] detachFromLayout];
         }
         [strongSelf -> _phantomTapViewsList removeAllObjects];
         
+        for (GestureActionView *gv in [strongSelf -> _gestureViewsList copy])
+        {
+            [strongSelf removeGestureView:gv];
+        }
+        
         strongSelf -> _selectedView = nil;
         strongSelf -> _viewIdCouner = 0;
         
@@ -466,8 +557,8 @@
 
 - (void)onWriteToKeyboard
 {
-    // 檢查是否有連線中的裝置
-    if (![[BTManager shared] getConnected])
+    // 檢查是否有已就緒的裝置 (可能多台)
+    if ([[[BTManager shared] readySessions] count] == 0)
     {
         NSLog(@"[WRITE] abort: no connected peripheral.");
         [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:NSLocalizedString(@"keyboard_is_not_connected_check_your_ble_connection", nil)];
@@ -475,7 +566,7 @@
         return;
     }
     
-    if ([self -> _phantomTapViewsList count] == 0)
+    if ([self -> _phantomTapViewsList count] == 0 && [self -> _gestureActionsList count] == 0)
     {
         NSLog(@"[WRITE] no points to send");
         [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:NSLocalizedString(@"no_points_available_to_write", nil)];
@@ -483,70 +574,48 @@
         return;
     }
     
-    // 檢查是否有 "null" key，或重複 key
-    NSMutableSet<NSString *> *keys = [NSMutableSet set];
-    for (PhantomTapView *v in self -> _phantomTapViewsList)
-    {
-        NSString *k = v.action.keyCode ?: @"null";
-        if ([k isEqualToString:@"null"])
-        {
-            NSLog(@"[WRITE] found null key, abort");
-            [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:NSLocalizedString(@"all_items_must_have_a_keycode_assigned", nil)];
-            return;
-        }
-        if ([keys containsObject:k])
-        {
-            NSLog(@"[WRITE] duplicated key=%@", k);
-            [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:NSLocalizedString(@"duplicate_keys_detected_fix_them_before_submitting", nil)];
-            return;
-        }
-        [keys addObject:k];
-    }
- 
-    // 依照 id 排序，固定順序
-    NSArray<PhantomTapView *> *ordered = [self.phantomTapViewsList sortedArrayUsingComparator:^NSComparisonResult(PhantomTapView *a, PhantomTapView *b) {
-            return (a.action.actionId < b.action.actionId) ? NSOrderedAscending :
-                   (a.action.actionId > b.action.actionId) ? NSOrderedDescending : NSOrderedSame;
-        }];
-    
-    // [self showLoadingPopupWithTitle:NSLocalizedString(@"sending", nil) message:NSLocalizedString(@"sending_commands_to_keyboard", nil)];
-    [_commandQueue removeAllObjects];
+    // 容器座標 (points) → 螢幕像素，與 -screenCenterInPixelsForView: / -clampPixelPointToScreen: 相同
+    CGSize nb = [[UIScreen mainScreen] nativeBounds].size;
+    CGPoint origin = [self -> _contentView convertPoint:CGPointZero toView:nil];
+    CGFloat halfSize = ([self -> _phantomTapViewsList count] > 0) ? CGRectGetWidth([[self -> _phantomTapViewsList firstObject] bounds]) / 2.0 : 28.0;
+    KeymapPixelTransform transform = {
+        .scale = [[UIScreen mainScreen] nativeScale],
+        .offsetX = origin.x,
+        .offsetY = origin.y,
+        .halfSize = halfSize,
+        .maxX = nb.width - 1,
+        .maxY = nb.height - 1,
+    };
     
-    // 逐一打包並寫入
-    for (PhantomTapView *v in ordered)
+    // 與 CLI 的 compile 同一條路：檢查空鍵 / 重複 / 查不到索引 → 依 id 排序打包 → 滑動 / 搖桿巨集
+    NSError *err = nil;
+    NSArray<NSData *> *frames = [KeymapProfileCompiler compileLayout:self -> _keymapLayout transform:transform gestures:self -> _gestureActionsList screenW:(NSInteger)nb.width screenH:(NSInteger)nb.height error:&err];
+    if (!frames)
     {
-        NSString *label = v.action.keyCode;
-        NSNumber *keyIndexNum = [HidKeyCodeMap keyIndexForLabel:label];
-        NSNumber *hidCodeNum  = [HidKeyCodeMap hidCodeForLabel:label]; // 目前你的韌體忽略 HID，可先填 0
-        if (!keyIndexNum)
+        NSLog(@"[WRITE] abort: %@ (id=%@)", [err localizedDescription], [err userInfo][KeymapProfileErrorActionIdKey]);
+        
+        NSString *msg = [err localizedDescription];
+        switch ([err code])
         {
-            NSLog(@"[WRITE] keyIndex not found for label=%@", label);
-            NSString *msg = [NSString stringWithFormat:@"無法取得按鍵 %@ 的索引，請確認對應表。", label];
-            [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:msg];
-            
-            return;
+            case KeymapProfileErrorEmptyProfile:
+                msg = NSLocalizedString(@"no_points_available_to_write", nil);
+                break;
+            case KeymapValidationEmptyKey:
+                msg = NSLocalizedString(@"all_items_must_have_a_keycode_assigned", nil);
+                break;
+            case KeymapValidationDuplicateKey:
+                msg = NSLocalizedString(@"duplicate_keys_detected_fix_them_before_submitting", nil);
+                break;
+            default:
+                break;      // 查不到索引：訊息裡已經有按鍵名稱
         }
-        
-        CGPoint px = [self screenCenterInPixelsForView:v];
-        px = [self clampPixelPointToScreen:px];
-
-        NSData *pkt = [BluetoothPacketBuilder buildKeyMappingPacketWithKeyIndex:keyIndexNum.integerValue
-                                                                        keyCode:(hidCodeNum ? hidCodeNum.integerValue : 0)
-                                                                              x:(NSInteger)lrint(px.x)
-                                                                              y:(NSInteger)lrint(px.y)];
-        
-        [_commandQueue addObject:pkt];
-        
-//        [BTManager.shared write:pkt
-//                              toService:[BTManager Custom_Service_UUID]
-//                         characteristic:[BTManager Write_Characteristic_UUID]
-//                          withResponse:NO];
-
-        NSLog(@"[WRITE] key=%@ idx=%@ -> x=%ld y=%ld", label, keyIndexNum, (long)lrint(px.x), (long)lrint(px.y));
+        [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:msg];
+        return;
     }
+    NSLog(@"[WRITE] %lu frames (%lu taps, %lu gestures)", (unsigned long)[frames count], (unsigned long)[self -> _keymapLayout count], (unsigned long)[self -> _gestureActionsList count]);
     
-    // 真正開始送
-    [self startSendingCommandQueue];
+    // 同一組封包平行寫到所有已連線的鍵盤
+    [self fanOutFramesToAllDevices:frames];
     
     // [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:NSLocalizedString(@"all_commands_are_completed", nil)];
     // for testing
@@ -577,70 +646,73 @@
     NSLog(@"%@, toggleSidebar %d", [GlobalConfig DebugTag], _isExpanded);
 }
 
-#pragma mark - BLE write queue
+#pragma mark - BLE write
 
-- (void)startSendingCommandQueue
+- (void)onAllCommandsSent
+{
+    NSLog(@"[MainVC] 所有指令已傳送完畢！");
+    [self showBottomToast:@"寫入完成"];
+}
+
+
+#pragma mark - BLE fan-out (多台裝置)
+
+- (void)fanOutFramesToAllDevices:(NSArray<NSData *> *)aFrames
 {
-    if ([_commandQueue count] == 0)
-    {
-        NSLog(@"[QUEUE] no packets to send.");
-        return;
-    }
-    
     if (_isWritingBle)
     {
-        NSLog(@"[QUEUE] already sending, skip start.");
+        NSLog(@"[FANOUT] already sending, skip.");
         return;
     }
     
     _isWritingBle = YES;
     
+    // 整份寫入會蓋過所有按鍵，live preview 還沒送的不用再送
+    [self -> _livePreviewStream cancel];
+    
     if (!_sendingPopup)
     {
         _sendingPopup = [CustomPopupDialog showLoadingInView:[self view] title:NSLocalizedString(@"sending", nil) message:NSLocalizedString(@"sending_commands_to_keyboard", nil)];
     }
     
-    [self processCommandQueue];
-}
-
-- (void)processCommandQueue
-{
-    if ([_commandQueue count] == 0 || _isWritingBle)
-    {
-        if ([_commandQueue count] == 0 && !_isWritingBle)
+    __weak typeof(self) wself = self;
+    [[BTManager shared] fanOutFrames:aFrames progress:^(BTDeviceSession * _Nonnull aSession, NSInteger aSent, NSInteger aTotal) {
+        NSLog(@"[FANOUT] %@ %ld/%ld", [aSession displayName], (long)aSent, (long)aTotal);
+    } completion:^(NSArray<BTFanOutResult *> * _Nonnull aResults) {
+        __strong typeof(wself) self = wself;
+        if (!self) return;
+        
+        self -> _isWritingBle = NO;
+        
+#if DEBUG
+        NSData *metrics = [[BTMetrics shared] exportJSONPretty:NO error:nil];
+        NSLog(@"[METRICS] %@", metrics ? [[NSString alloc] initWithData:metrics encoding:NSUTF8StringEncoding] : @"");
+#endif
+        
+        if (self -> _sendingPopup)
         {
-            [self onAllCommandsSent];
+            [self -> _sendingPopup dismiss];
+            self -> _sendingPopup = nil;
         }
-        return;
-    }
-    
-    NSData *packet = [_commandQueue firstObject];
-    [_commandQueue removeObjectAtIndex:0];
-    
-    if (packet)
-    {
-        _isWritingBle = YES;
         
-        NSLog(@"[MainVC] 送封包(剩餘%lu): %@", (unsigned long)[_commandQueue count], [BTManager byteArrayToHexString:packet]);
+        NSMutableArray<NSString *> *failed = [NSMutableArray array];
+        for (BTFanOutResult *r in aResults)
+        {
+            if (![r isSuccess])
+            {
+                [failed addObject:[NSString stringWithFormat:@"%@ (%ld/%ld)", [r name], (long)[r sentFrames], (long)[r totalFrames]]];
+            }
+        }
         
-        [[BTManager shared] write:packet toService:[BTManager Custom_Service_UUID] characteristic:[BTManager Write_Characteristic_UUID] withResponse:NO];
+        if ([aResults count] == 0 || [failed count] > 0)
+        {
+            NSString *msg = [NSString stringWithFormat:@"%@\n%@", NSLocalizedString(@"write_failed_on_devices", nil), [failed componentsJoinedByString:@"\n"]];
+            [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:msg];
+            return;
+        }
         
-        // 延遲 500ms 避免塞爆
-        __weak typeof(self) wself = self;
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_MSEC)), dispatch_get_main_queue(), ^{
-            __strong typeof(wself) self = wself;
-            if (!self) return;
-            
-            self -> _isWritingBle = NO;
-            [self processCommandQueue];
-        });
-    }
-}
-
-- (void)onAllCommandsSent
-{
-    NSLog(@"[MainVC] 所有指令已傳送完畢！");
-    [self showBottomToast:@"寫入完成"];
+        [self onAllCommandsSent];
+    }];
 }
 
 
@@ -818,6 +890,13 @@
     [arr addObject:[UIKeyCommand keyCommandWithInput:UIKeyInputLeftArrow modifierFlags:0 action:@selector(onKeyCommand:)]];
     [arr addObject:[UIKeyCommand keyCommandWithInput:UIKeyInputRightArrow modifierFlags:0 action:@selector(onKeyCommand:)]];
 
+    // Undo / Redo
+    [arr addObject:[UIKeyCommand keyCommandWithInput:@"z" modifierFlags:UIKeyModifierCommand action:@selector(onUndo)]];
+    [arr addObject:[UIKeyCommand keyCommandWithInput:@"z" modifierFlags:(UIKeyModifierCommand | UIKeyModifierShift) action:@selector(onRedo)]];
+    
+    // Live preview 開關
+    [arr addObject:[UIKeyCommand keyCommandWithInput:@"l" modifierFlags:UIKeyModifierCommand action:@selector(toggleLivePreview)]];
+
     cmds = arr.copy;
     return cmds;
 }
@@ -826,7 +905,7 @@
 - (void)onKeyCommand:(UIKeyCommand *)aCommand
 {
     NSLog(@"[KEYCOMMAND] detected key input: %@", [aCommand input]);
-    if (!self -> _selectedView) return;
+    if (!self -> _selectedView && !self -> _selectedGestureView) return;
     
     NSString *label = [aCommand input];
     if (label == UIKeyInputUpArrow) label = @"UpArrow";
@@ -836,6 +915,12 @@
     else if ([label isEqualToString:@" "]) label = @"SPACE";
     else label = label.uppercaseString;
     
+    if (self -> _selectedGestureView)
+    {
+        [self assignKeyLabel:label toGestureView:self -> _selectedGestureView];
+        return;
+    }
+    
     if ([self isKeyLabel:label usedByOtherThan:self -> _selectedView])
     {
         // [self showInfoPopupWithTitle:NSLocalizedString(@"notice", nil) message:NSLocalizedString(@"duplicate_keys_detected_fix_them_before_submitting", nil)];
@@ -843,16 +928,30 @@
         return;
     }
     
+    NSString *oldLabel = [[self -> _selectedView action] keyCode] ?: @"null";
+    if ([oldLabel isEqualToString:label]) return;
+    
     [self -> _selectedView updateKeyCode:label];
+    [self -> _editorJournal recordOp:[EditorOp setKeyOpWithId:[[self -> _selectedView action] actionId] from:oldLabel to:label]];
 }
 
 - (BOOL)isKeyLabel:(NSString *)aLabel usedByOtherThan:(PhantomTapView *)aCurrent
+{
+    return [self isKeyLabel:aLabel usedByOtherThan:aCurrent includingGestures:YES];
+}
+
+- (BOOL)isKeyLabel:(NSString *)aLabel usedByOtherThan:(nullable PhantomTapView *)aCurrent includingGestures:(BOOL)aIncludingGestures
 {
     if ([aLabel length] == 0 || [aLabel isEqualToString:@"null"])
     {
         return NO;
     }
     
+    if (aIncludingGestures && [[self gestureKeyLabels] containsObject:aLabel])
+    {
+        return YES;
+    }
+    
     for (PhantomTapView *v in self -> _phantomTapViewsList)
     {
         if (v == aCurrent) continue;
@@ -871,7 +970,7 @@
 - (void)showSaveNicknameDialog
 {
     // 如果沒有任何 PhantomTapView → popup 提醒
-    if ([self -> _phantomTapViewsList count] == 0)
+    if ([self -> _phantomTapViewsList count] == 0 && [self -> _gestureActionsList count] == 0)
     {
         CustomPopupDialog *popup = [CustomPopupDialog showInView:[self view] style:CustomPopupDialogStyleSingleButton title:NSLocalizedString(@"notice", nil) message:NSLocalizedString(@"no_items_can_be_saved", nil) positiveButtonLabel:NSLocalizedString(@"ok", nil) negativeButtonLabel:nil onPositive:nil onNegative:nil];
         
@@ -1007,11 +1106,14 @@
     {
         CGPoint px = [v centerOnScreen];  // 這裡已經是 pixels
         
-        v.action.posX = px.x;
-        v.action.posY = px.y;
+        // 存檔用的是像素中心點；畫面上的 action 仍是容器座標，另外複製一份
+        TapAction *snapshot = [[v action] detachedCopy];
+        snapshot.posX = px.x;
+        snapshot.posY = px.y;
         
-        [actions addObject:v.action];
+        [actions addObject:snapshot];
     }
+    [actions addObjectsFromArray:self -> _gestureActionsList];
     NSString *createAt = [Utils currentISO8601String];
     KeymapFile *file = [[KeymapFile alloc] initWithVersion:[GlobalConfig JSON_VERSION] createdAt:createAt nickname:aNickname portraitW:pW portraitH:pH rotationWhenSaved:0 actions:actions];
     
@@ -1299,13 +1401,21 @@
 
     NSLog(@"[DEBUG] apply keymap: %@", [aFile nickname]);
 
-    NSArray *currentViews = [self -> _phantomTapViewsList copy];
-    for (UIView *v in currentViews)
+    NSArray<EditorEntry *> *entriesBefore = [self editorEntriesForCurrentViews];
+
+    NSArray<PhantomTapView *> *currentViews = [self -> _phantomTapViewsList copy];
+    for (PhantomTapView *v in currentViews)
     {
         [v removeFromSuperview];
+        [[v action] detachFromLayout];
     }
     [self -> _phantomTapViewsList removeAllObjects];
     
+    for (GestureActionView *gv in [self -> _gestureViewsList copy])
+    {
+        [self removeGestureView:gv];
+    }
+    
     self -> _viewIdCouner = 0;
     
     CGSize viewSize = [[self view] bounds].size;
@@ -1319,6 +1429,13 @@
     
     for (id<KeymapAction> act in [aFile actions])
     {
+        if ([act keymapType] == KeymapTypeSwipe || [act keymapType] == KeymapTypeJoystick)
+        {
+            // 座標維持存檔時的螢幕像素，顯示 / 寫入時才換算
+            [self createAndAddGestureViewWithAction:act];
+            self -> _viewIdCouner = MAX(self -> _viewIdCouner, [act actionId] + 1);
+            continue;
+        }
         if (![act isKindOfClass:[TapAction class]]) continue;
         TapAction *ta = (TapAction *)act;
         
@@ -1360,6 +1477,9 @@
         */
     }
     
+    // 載入檔案也是一筆可 undo 的操作
+    [self -> _editorJournal recordOp:[EditorOp replaceOpWithBefore:entriesBefore after:[self editorEntriesForCurrentViews]]];
+    
     [self bringSidebarsToFront];
 }
 
@@ -1370,6 +1490,9 @@
 {
     __weak typeof(self) weakSelf = self;
     
+    // 之後讀寫位置 / 按鍵都直接落在 layout 的欄位上
+    [aAction attachToLayout:self -> _keymapLayout];
+    
     PhantomTapView *ptv = [[PhantomTapView alloc] initWithAction:aAction onSelected:^(PhantomTapView * _Nonnull aPhantomTapView) {
         [weakSelf handleTapViewSeleted:aPhantomTapView];
     } onDelete:^(PhantomTapView * _Nonnull aPhantomTapView) {
@@ -1377,6 +1500,9 @@
     } onPositionCommed:^(PhantomTapView * _Nonnull aPhantomTapView) {
         [weakSelf onPhantomTapViewPositionCommitted:aPhantomTapView];
     }];
+    [ptv setOnPositionChanging:^(PhantomTapView * _Nonnull aPhantomTapView) {
+        [weakSelf streamLivePreviewForView:aPhantomTapView];
+    }];
     
     [self -> _contentView addSubview:ptv];
     [self -> _phantomTapViewsList addObject:ptv];
@@ -1397,6 +1523,9 @@
     }
     self -> _selectedView = aSelectedView;
     
+    [self -> _selectedGestureView setViewSelected:NO];
+    self -> _selectedGestureView = nil;
+    
     [[aSelectedView superview] bringSubviewToFront:aSelectedView];
     [self bringSidebarsToFront];
     
@@ -1408,8 +1537,15 @@
 }
 
 - (void)handleTapViewDelete:(PhantomTapView *)aDeletedView
+{
+    [self -> _editorJournal recordOp:[EditorOp deleteOpWithEntry:[self editorEntryForView:aDeletedView]]];
+    [self removeTapView:aDeletedView];
+}
+
+- (void)removeTapView:(PhantomTapView *)aDeletedView
 {
     [aDeletedView removeFromSuperview];
+    [[aDeletedView action] detachFromLayout];
     [self -> _phantomTapViewsList removeObject:aDeletedView];
     
     if (self -> _selectedView == aDeletedView)
@@ -1427,7 +1563,380 @@
     
     [aPhantomTapView clampIntoSuperviewBounds];
     
-    NSLog(@"[DEBUG] position committed id=%ld (%.1f, %.1f)", (long)[[aPhantomTapView action] actionId], p.x, p.y);
+    // 只點選沒拖動時也會 commit，位置沒變就不記
+    NSInteger actionId = [[aPhantomTapView action] actionId];
+    CGPoint from = [[self -> _editorJournal entryForId:actionId] origin];
+    CGPoint to = [aPhantomTapView frame].origin;
+    if (!CGPointEqualToPoint(from, to))
+    {
+        [self -> _editorJournal recordOp:[EditorOp moveOpWithId:actionId from:from to:to]];
+    }
+    
+    // 放開時送最後位置 (夾回畫面後的)
+    [self streamLivePreviewForView:aPhantomTapView];
+}
+
+
+#pragma mark - Live Preview
+
+- (void)toggleLivePreview
+{
+    self -> _livePreviewEnabled = !self -> _livePreviewEnabled;
+    if (!self -> _livePreviewEnabled)
+    {
+        [self -> _livePreviewStream cancel];
+    }
+    
+    UIButton *btn = (UIButton *)[self -> _sidebarExpanded viewWithTag:[FloatingSidebarBuilder getLivePreviewButtonTag]];
+    if ([btn isKindOfClass:[UIButton class]])
+    {
+        [FloatingSidebarBuilder setLivePreviewButton:btn on:self -> _livePreviewEnabled];
+    }
+    
+    NSLog(@"[LIVE] live preview %@", self -> _livePreviewEnabled ? @"ON" : @"OFF");
+    [self showBottomToast:(self -> _livePreviewEnabled ? NSLocalizedString(@"live_preview_on", nil) : NSLocalizedString(@"live_preview_off", nil))];
+}
+
+/// 把這顆按鍵目前的位置包成單顆 key mapping 封包丟進 live stream
+/// 還沒指定按鍵 / 沒有裝置 / 正在整份寫入時不送
+- (void)streamLivePreviewForView:(PhantomTapView *)aView
+{
+    if (!self -> _livePreviewEnabled || self -> _isWritingBle) return;
+    if ([[[BTManager shared] readySessions] count] == 0) return;
+    
+    NSString *label = [[aView action] keyCode];
+    if ([label length] == 0 || [label isEqualToString:@"null"]) return;
+    
+    NSNumber *keyIndexNum = [HidKeyCodeMap keyIndexForLabel:label];
+    if (!keyIndexNum) return;
+    NSNumber *hidCodeNum = [HidKeyCodeMap hidCodeForLabel:label];
+    
+    CGPoint px = [self clampPixelPointToScreen:[self screenCenterInPixelsForView:aView]];
+    
+    NSData *pkt = [BluetoothPacketBuilder buildKeyMappingPacketWithKeyIndex:keyIndexNum.integerValue
+                                                                    keyCode:(hidCodeNum ? hidCodeNum.integerValue : 0)
+                                                                          x:(NSInteger)lrint(px.x)
+                                                                          y:(NSInteger)lrint(px.y)
+                                                               hostPayloads:[[aView action] hostPayloads]];
+    
+    [self -> _livePreviewStream submitFrame:pkt forKeyIndex:keyIndexNum.integerValue];
+}
+
+
+#pragma mark - Editor Journal (Undo / Redo / 還原)
+
+- (EditorEntry *)editorEntryForView:(PhantomTapView *)aView
+{
+    return [EditorEntry entryWithTapAction:[aView action] origin:[aView frame].origin];
+}
+
+/// 畫面上所有點擊鍵 + 滑動 / 搖桿 (清除 / 載入檔案時整批記下)
+- (NSArray<EditorEntry *> *)editorEntriesForCurrentViews
+{
+    NSMutableArray<EditorEntry *> *entries = [NSMutableArray arrayWithCapacity:[self -> _phantomTapViewsList count] + [self -> _gestureViewsList count]];
+    for (PhantomTapView *v in self -> _phantomTapViewsList)
+    {
+        [entries addObject:[self editorEntryForView:v]];
+    }
+    for (GestureActionView *gv in self -> _gestureViewsList)
+    {
+        [entries addObject:[EditorEntry entryWithGesture:[gv action]]];
+    }
+    return entries;
+}
+
+- (nullable PhantomTapView *)tapViewForId:(NSInteger)aActionId
+{
+    for (PhantomTapView *v in self -> _phantomTapViewsList)
+    {
+        if ([[v action] actionId] == aActionId) return v;
+    }
+    return nil;
+}
+
+- (nullable GestureActionView *)gestureViewForId:(NSInteger)aActionId
+{
+    for (GestureActionView *gv in self -> _gestureViewsList)
+    {
+        if ([[gv action] actionId] == aActionId) return gv;
+    }
+    return nil;
+}
+
+- (PhantomTapView *)addTapViewForEntry:(EditorEntry *)aEntry
+{
+    CGSize nb = [[UIScreen mainScreen] nativeBounds].size;
+    
+    TapAction *action = [[TapAction alloc] initWithId:[aEntry actionId] orientation:[aEntry orientation] screenW:(NSInteger)nb.width screenH:(NSInteger)nb.height posX:[aEntry origin].x posY:[aEntry origin].y keyCode:[aEntry keyCode] pressEvent:[aEntry isPressEvent]];
+    action.androidPayload = [aEntry androidPayload];
+    action.windowsPayload = [aEntry windowsPayload];
+    action.iosPayload = [aEntry iosPayload];
+    
+    if ([aEntry actionId] >= self -> _viewIdCouner)
+    {
+        self -> _viewIdCouner = [aEntry actionId] + 1;
+    }
+    
+    return [self createAndAddPhantomTapViewWithAction:action];
+}
+
+/// 依 entry 類型放回點擊鍵或滑動 / 搖桿
+- (void)addViewForEntry:(EditorEntry *)aEntry
+{
+    if ([aEntry gesture])
+    {
+        // entry 是 immutable snapshot，畫面上編輯的是另一份
+        [self createAndAddGestureViewWithAction:[(id<NSCopying>)[aEntry gesture] copyWithZone:nil]];
+        return;
+    }
+    [self addTapViewForEntry:aEntry];
+}
+
+- (void)removeViewForId:(NSInteger)aActionId
+{
+    PhantomTapView *v = [self tapViewForId:aActionId];
+    if (v) [self removeTapView:v];
+    
+    GestureActionView *gv = [self gestureViewForId:aActionId];
+    if (gv) [self removeGestureView:gv];
+}
+
+/// 把 journal 回傳的操作套用到畫面上 (不再記回 journal)
+- (void)applyEditorOp:(EditorOp *)aOp
+{
+    switch ([aOp kind])
+    {
+        case EditorOpKindAdd:
+            [self addViewForEntry:[aOp entry]];
+            break;
+        case EditorOpKindDelete:
+            [self removeViewForId:[aOp actionId]];
+            break;
+        case EditorOpKindMove:
+        {
+            PhantomTapView *v = [self tapViewForId:[aOp actionId]];
+            CGRect f = [v frame];
+            f.origin = [aOp toOrigin];
+            [v setFrame:f];
+            [[v action] setPosX:f.origin.x];
+            [[v action] setPosY:f.origin.y];
+            break;
+        }
+        case EditorOpKindSetKey:
+            [[self tapViewForId:[aOp actionId]] updateKeyCode:[aOp toKey]];
+            break;
+        case EditorOpKindReplace:
+            for (EditorEntry *e in [aOp beforeEntries])
+            {
+                [self removeViewForId:[e actionId]];
+            }
+            for (EditorEntry *e in [aOp afterEntries])
+            {
+                [self addViewForEntry:e];
+            }
+            break;
+    }
+}
+
+- (void)onUndo
+{
+    EditorOp *op = [self -> _editorJournal undo];
+    if (!op) return;
+    
+    [self applyEditorOp:op];
+    NSLog(@"[Editor] undo kind=%d id=%ld", [op kind], (long)[op actionId]);
+}
+
+- (void)onRedo
+{
+    EditorOp *op = [self -> _editorJournal redo];
+    if (!op) return;
+    
+    [self applyEditorOp:op];
+    NSLog(@"[Editor] redo kind=%d id=%ld", [op kind], (long)[op actionId]);
+}
+
+- (void)restoreFromEditorJournal
+{
+    NSArray<EditorEntry *> *entries = [self -> _editorJournal currentEntries];
+    for (EditorEntry *e in entries)
+    {
+        [self addViewForEntry:e];
+    }
+    
+    if ([entries count] > 0)
+    {
+        NSLog(@"[Editor] restored %lu items from journal", (unsigned long)[entries count]);
+    }
+}
+
+- (void)onAppDidEnterBackground:(NSNotification *)aNote
+{
+    [self -> _editorJournal flush];
+}
+
+
+#pragma mark - Swipe / Joystick
+
+- (NSArray<NSString *> *)gestureKeyLabels
+{
+    return [KeymapProfileCompiler gestureKeyLabelsForActions:self -> _gestureActionsList];
+}
+
+- (GestureActionView *)createAndAddGestureViewWithAction:(id<KeymapAction>)aAction
+{
+    __weak typeof(self) weakSelf = self;
+    
+    GestureActionView *gv = [[GestureActionView alloc] initWithAction:aAction onSelected:^(GestureActionView * _Nonnull aGestureView) {
+        [weakSelf handleGestureViewSelected:aGestureView];
+    } onDelete:^(GestureActionView * _Nonnull aGestureView) {
+        [weakSelf handleGestureViewDelete:aGestureView];
+    } onChangeCommitted:^(GestureActionView * _Nonnull aGestureView) {
+        [weakSelf onGestureViewChangeCommitted:aGestureView];
+    }];
+    [gv setFrame:[self -> _contentView bounds]];
+    [gv setAutoresizingMask:(UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight)];
+    
+    [self -> _contentView addSubview:gv];
+    [self -> _gestureViewsList addObject:gv];
+    [self -> _gestureActionsList addObject:aAction];
+    self -> _viewIdCouner = MAX(self -> _viewIdCouner, [aAction actionId] + 1);
+    
+    [self bringSidebarsToFront];
+    
+    return gv;
+}
+
+- (void)handleGestureViewSelected:(GestureActionView *)aGestureView
+{
+    for (PhantomTapView *v in self -> _phantomTapViewsList)
+    {
+        [v setViewSelected:NO];
+    }
+    self -> _selectedView = nil;
+    
+    for (GestureActionView *gv in self -> _gestureViewsList)
+    {
+        [gv setViewSelected:(gv == aGestureView)];
+    }
+    self -> _selectedGestureView = aGestureView;
+    
+    [[aGestureView superview] bringSubviewToFront:aGestureView];
+    [self bringSidebarsToFront];
+    
+    if (![self isFirstResponder])
+    {
+        [self becomeFirstResponder];
+    }
+    NSLog(@"[Editor] Selected gesture: %@", [aGestureView action]);
+}
+
+- (void)handleGestureViewDelete:(GestureActionView *)aGestureView
+{
+    [self -> _editorJournal recordOp:[EditorOp deleteOpWithEntry:[EditorEntry entryWithGesture:[aGestureView action]]]];
+    [self removeGestureView:aGestureView];
+}
+
+- (void)removeGestureView:(GestureActionView *)aGestureView
+{
+    [aGestureView removeFromSuperview];
+    [self -> _gestureViewsList removeObject:aGestureView];
+    [self -> _gestureActionsList removeObjectIdenticalTo:[aGestureView action]];
+    
+    if (self -> _selectedGestureView == aGestureView)
+    {
+        self -> _selectedGestureView = nil;
+    }
+}
+
+- (void)onGestureViewChangeCommitted:(GestureActionView *)aGestureView
+{
+    [self recordGestureChangeForView:aGestureView];
+    NSLog(@"[DEBUG] gesture changed %@", [aGestureView action]);
+}
+
+/// 滑動 / 搖桿的移動、縮放、改鍵：以 Replace 記下整個 action 改前 / 改後
+- (void)recordGestureChangeForView:(GestureActionView *)aGestureView
+{
+    EditorEntry *before = [self -> _editorJournal entryForId:[[aGestureView action] actionId]];
+    EditorEntry *after = [EditorEntry entryWithGesture:[aGestureView action]];
+    [self -> _editorJournal recordOp:[EditorOp replaceOpWithBefore:(before ? @[before] : @[]) after:@[after]]];
+}
+
+/// 選取中的滑動 / 搖桿方向指定按鍵；跟其他按鍵重複時不指定
+- (void)assignKeyLabel:(NSString *)aLabel toGestureView:(GestureActionView *)aGestureView
+{
+    NSString *oldLabel = [aGestureView currentKeyCode];
+    if ([oldLabel isEqualToString:aLabel]) return;
+    
+    // 自己這一格原本的按鍵不算重複
+    NSMutableArray<NSString *> *used = [[self gestureKeyLabels] mutableCopy];
+    NSUInteger own = [used indexOfObject:oldLabel];
+    if (own != NSNotFound) [used removeObjectAtIndex:own];
+    
+    if ([used containsObject:aLabel] || [self isKeyLabel:aLabel usedByOtherThan:nil includingGestures:NO])
+    {
+        NSLog(@"duplicate_keys_detected_fix_them_before_submitting");
+        return;
+    }
+    
+    [aGestureView updateKeyCode:aLabel];
+    [self recordGestureChangeForView:aGestureView];
+}
+
+#pragma mark - Swipe recording
+
+- (void)onSwipeRecordPan:(UIPanGestureRecognizer *)aPan
+{
+    // 跟點擊鍵一樣：視窗座標 (points) × nativeScale = 螢幕像素
+    CGSize nb = [[UIScreen mainScreen] nativeBounds].size;
+    CGFloat scale = [[UIScreen mainScreen] nativeScale];
+    CGPoint p = [aPan locationInView:nil];
+    
+    if ([aPan state] == UIGestureRecognizerStateBegan)
+    {
+        self -> _swipeRecordPoints = [NSMutableArray array];
+        self -> _swipeRecordStartTime = CACurrentMediaTime();
+    }
+    
+    if ([aPan state] == UIGestureRecognizerStateBegan || [aPan state] == UIGestureRecognizerStateChanged || [aPan state] == UIGestureRecognizerStateEnded)
+    {
+        // 存成像素座標 + 相對起點的毫秒
+        NSInteger t = (NSInteger)lround((CACurrentMediaTime() - self -> _swipeRecordStartTime) * 1000.0);
+        [self -> _swipeRecordPoints addObject:[GesturePoint pointWithX:p.x * scale y:p.y * scale timeMs:t]];
+        
+        UIBezierPath *path = [UIBezierPath bezierPath];
+        for (GesturePoint *gp in self -> _swipeRecordPoints)
+        {
+            CGPoint vp = [self -> _swipeRecordOverlay convertPoint:CGPointMake(gp.x / scale, gp.y / scale) fromView:nil];
+            if ([path isEmpty]) [path moveToPoint:vp]; else [path addLineToPoint:vp];
+        }
+        [self -> _swipeRecordLayer setPath:[path CGPath]];
+    }
+    
+    if ([aPan state] == UIGestureRecognizerStateEnded)
+    {
+        NSArray<GesturePoint *> *points = [self -> _swipeRecordPoints copy];
+        [self endSwipeRecording];
+        if ([points count] < 2) return;
+        
+        SwipeAction *sa = [[SwipeAction alloc] initWithId:self -> _viewIdCouner++ screenW:(NSInteger)nb.width screenH:(NSInteger)nb.height keyCode:@"null" points:points];
+        GestureActionView *gv = [self createAndAddGestureViewWithAction:sa];
+        [self -> _editorJournal recordOp:[EditorOp addOpWithEntry:[EditorEntry entryWithGesture:sa]]];
+        [self handleGestureViewSelected:gv];
+    }
+    else if ([aPan state] == UIGestureRecognizerStateCancelled || [aPan state] == UIGestureRecognizerStateFailed)
+    {
+        [self endSwipeRecording];
+    }
+}
+
+- (void)endSwipeRecording
+{
+    [self -> _swipeRecordOverlay removeFromSuperview];
+    self -> _swipeRecordOverlay = nil;
+    self -> _swipeRecordLayer = nil;
+    self -> _swipeRecordPoints = nil;
 }
 
 
@@ -1439,6 +1948,13 @@
     
     // 我們等到旋轉動畫結束後，再傳送新的解析度給硬體
     [coordinator animateAlongsideTransition:nil completion:^(id<UIViewControllerTransitionCoordinatorContext>  _Nonnull context) {
+        // 滑動 / 搖桿以視窗座標換算，容器位置變了也要重畫
+        for (GestureActionView *gv in self -> _gestureViewsList)
+        {
+            [gv setFrame:[self -> _contentView bounds]];
+            [gv refresh];
+        }
+        
         // 取得當前的原生縮放比例
         CGFloat scale = [[UIScreen mainScreen] nativeScale];
         
@@ -1457,9 +1973,15 @@
 {
     NSData *pkt = [BluetoothPacketBuilder buildScreenCalibrationPacketWithWidth:aWidth height:aHeight];
     
-    [[BTManager shared] write:pkt toService:[BTManager Custom_Service_UUID] characteristic:[BTManager Write_Characteristic_UUID] withResponse:NO];
+    // 每台已就緒的周邊都要校正，否則 fan-out 的設定檔座標在其他台上會跑掉
+    [[BTManager shared] fanOutFrames:@[ pkt ] progress:nil completion:^(NSArray<BTFanOutResult *> * _Nonnull aResults) {
+        for (BTFanOutResult *r in aResults)
+        {
+            if (![r isSuccess]) NSLog(@"[WRITE] calibration to %@ fail: %@", [r name], [[r error] localizedDescription]);
+        }
+    }];
     
-    NSLog(@"[WRITE] calibration pixels=%ldx%ld", (long)aWidth, (long)aHeight);
+    NSLog(@"[WRITE] calibration pixels=%ldx%ld -> %lu devices", (long)aWidth, (long)aHeight, (unsigned long)[[[BTManager shared] readySessions] count]);
 }
 
 #pragma mark - Helper Function
@@ -1477,6 +1999,12 @@
 
 - (IBAction)testSomething:(id)aSender
 {
+#if DEBUG
+    // 順便在背景跑 KeymapLayout 的 benchmark (結果看 log)
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        [KeymapLayoutBenchmark runDefaultSuite];
+    });
+#endif
     [self onTapTestAButton];
 }
 
@@ -1484,11 +2012,6 @@
 
 - (void)onTapTestAButton
 {
-    if (!_commandQueue)
-    {
-        _commandQueue = [NSMutableArray array];
-    }
-    
     if ([_phantomTapViewsList count] != 1)
     {
         NSLog(@"[MainVC] 現在在測試，只用一個PhantomTapView就好了.");
@@ -1496,7 +2019,7 @@
         return;
     }
     
-    if (![[BTManager shared] getConnected])
+    if ([[[BTManager shared] readySessions] count] == 0)
     {
         NSLog(@"尚未連線藍牙裝置");
         [self showBottomToast:@"尚未連線藍牙裝置"];
@@ -1531,9 +2054,6 @@
         NSLog(@"[MainVC] Unknown keyCode=%@, fallback to A(44)", [action keyCode]);
     }
     
-    [_commandQueue removeAllObjects];
-    _isWritingBle = NO;
-    
     TapAction *down = [self createTempActionFrom:action isPress:YES];
     TapAction *up = [self createTempActionFrom:action isPress:NO];
     
@@ -1544,36 +2064,38 @@
     }
     
     NSArray *steps = @[down, up];
+    NSMutableArray<NSData *> *frames = [NSMutableArray arrayWithCapacity:3];
     
     NSData *writeMacroPacket = [BluetoothPacketBuilder buildWriteMacroContentPacketWithPacketIndex:1 actions:steps];
     if (writeMacroPacket)
     {
-        [_commandQueue addObject:writeMacroPacket];
+        [frames addObject:writeMacroPacket];
     }
     
     NSData *setTriggerKeyPacket = [BluetoothPacketBuilder buildSetMacroTriggerKeyPacket:keyIndex isContinuous:NO macroName:@"TEST_SHORT_CLICK"];
     if (setTriggerKeyPacket)
     {
-        [_commandQueue addObject:setTriggerKeyPacket];
+        [frames addObject:setTriggerKeyPacket];
     }
     
     NSData *notifyCompletePacket = [BluetoothPacketBuilder buildNotifyMacroWriteCompletePacketWithKeyIndex:keyIndex totalActions:[steps count]];
     if (notifyCompletePacket)
     {
-        [_commandQueue addObject:notifyCompletePacket];
+        [frames addObject:notifyCompletePacket];
     }
     
-    if ([_commandQueue count] == 0)
+    if ([frames count] == 0)
     {
-        NSLog(@"[MainVC] queue empty after build");
+        NSLog(@"[MainVC] no frames after build");
         [self showBottomToast:@"沒有可送出的封包"];
         return;
     }
     
-    NSLog(@"[MainVC] testingWritingShortClickMacroFromView: queue size=%lu", (unsigned long)[_commandQueue count]);
+    NSLog(@"[MainVC] testingWritingShortClickMacroFromView: frames=%lu", (unsigned long)[frames count]);
     
+    // 跟正式寫入一樣送到所有已連線的鍵盤
     [self showBottomToast:@"寫入按鍵設定中..."];
-    [self processCommandQueue];
+    [self fanOutFramesToAllDevices:frames];
 }
 
 
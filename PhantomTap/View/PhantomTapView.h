@@ -15,12 +15,16 @@ NS_ASSUME_NONNULL_BEGIN
 typedef void (^PhantomTapViewSelectedHandler)(PhantomTapView *aPhantomTapView);
 typedef void (^PhantomTapViewDeleteHandler)(PhantomTapView *aPhantomTapView);
 typedef void (^PhantomTapViewPositionCommittedHandler)(PhantomTapView *aPhantomTapView);
+typedef void (^PhantomTapViewPositionChangingHandler)(PhantomTapView *aPhantomTapView);
 
 @interface PhantomTapView : UIView
 
 @property (nonatomic, strong, readonly) TapAction *action;
 @property (nonatomic, assign) BOOL viewSelected;
 
+/// 拖曳中每次 touchesMoved: 都會呼叫 (live preview 用)，可為 nil
+@property (nonatomic, copy, nullable) PhantomTapViewPositionChangingHandler onPositionChanging;
+
 /// 建構：提供模型與回呼（任何一個可為 nil）
 - (instancetype)initWithAction:(TapAction *)aAction
                 onSelected:(nullable PhantomTapViewSelectedHandler)aOnSelected
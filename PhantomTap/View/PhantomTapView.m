@@ -170,6 +170,8 @@ static const CGFloat kPTVDeleteRadius = 18.0;
     [self clampIntoSuperviewBounds];
 
     _prevCenterInSuperview = [self center];
+
+    if (self.onPositionChanging) self.onPositionChanging(self);
 }
 
 - (void)touchesEnded:(NSSet<UITouch *> *)touches withEvent:(UIEvent *)event
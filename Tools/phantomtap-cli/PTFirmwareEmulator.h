@@ -0,0 +1,39 @@
+//
+//  PTFirmwareEmulator.h
+//  phantomtap-cli
+//
+//  Created by ethanlin on 2026/01/06.
+//
+//  照韌體的處理方式吃 App → 鍵盤的封包 (固定長度 0x05 / 變長 0x85)，
+//  只保留韌體會存的狀態 (key mapping 表、寫完的巨集)，給 measure 比對兩種格式寫進去的結果
+//
+//  變長格式由這裡自己解 (不經過 BluetoothPacketParser)，才能抓到 App 兩端一起寫錯的情況
+//
+
+#import <Foundation/Foundation.h>
+#import "DeviceResponse.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface PTFirmwareEmulator : NSObject
+
+/// aCapabilities = DeviceCapabilityNone 時模擬舊韌體：不回功能查詢，也不收 0x85 封包
+- (instancetype)initWithCapabilities:(DeviceCapability)aCapabilities;
+
+@property (nonatomic, readonly) DeviceCapability capabilities;
+
+/// 收到幾個看不懂 / checksum 錯 / 內容不完整的封包
+@property (nonatomic, readonly) NSUInteger rejectedFrames;
+
+/// 收一個封包，需要回覆時回傳回覆封包 (目前只有功能查詢)
+- (nullable NSData *)receiveFrame:(NSData *)aFrame;
+
+/// 韌體端狀態：依 keyIndex 排序的 key mapping (Data0-34) + 寫完的巨集 (觸發鍵設定 + 所有步驟)
+/// 兩台模擬器寫入的結果相同時相等
+- (NSData *)stateDigest;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,283 @@
+//
+//  PTFirmwareEmulator.m
+//  phantomtap-cli
+//
+//  Created by ethanlin on 2026/01/06.
+//
+
+#import "PTFirmwareEmulator.h"
+
+// 與 BluetoothPacketBuilder 的協定一致
+#define PT_HEADER_READ          0x04
+#define PT_HEADER_WRITE         0x05
+#define PT_HEADER_WRITE_COMPACT 0x85
+#define PT_HEADER_RESPONSE      0x06
+
+#define PT_ID_MACRO             0x02
+#define PT_ID_KEY_SETTING       0x03
+#define PT_ID_DEVICE_INFO       0x06
+
+#define PT_KEYMAP_DATA_LEN      0x23    // Data0-34
+#define PT_MACRO_DATA_LEN       0x85    // PacketIndex + Count + 10 slot
+#define PT_TRIGGER_DATA_LEN     0x22    // KeyIndex + Mode + 名稱 32
+#define PT_SLOT_LEN             13
+#define PT_MAX_SLOTS            10
+
+
+/// 變長區段 (Head + content) → Type + Content 9 bytes；回傳讀掉的長度，不完整時 0
+static NSUInteger PTReadSection(const uint8_t *aIn, NSUInteger aLen, uint8_t *aOut9)
+{
+    if (aLen < 1) return 0;
+
+    NSUInteger len = (aIn[0] >> 3) & 0x0F;
+    if (len > 8 || 1 + len > aLen) return 0;
+
+    memset(aOut9, 0, 9);
+    aOut9[0] = aIn[0] & 0x07;
+    memcpy(aOut9 + 1, aIn + 1, len);
+    return 1 + len;
+}
+
+/// 變長 Data → 固定長度 Data；回傳固定長度，格式錯誤時 0
+static NSUInteger PTExpandCompact(uint8_t aId, uint8_t aCmd, const uint8_t *aIn, NSUInteger aLen, uint8_t *aOut)
+{
+    NSUInteger pos = 0;
+
+    if (aId == PT_ID_KEY_SETTING && aCmd == 0x01)
+    {
+        // KeyIndex, HID, Mod, Flags, X, Y, 區段
+        if (aLen < 8) return 0;
+        uint8_t flags = aIn[3];
+
+        memset(aOut, 0, PT_KEYMAP_DATA_LEN);
+        memcpy(aOut, aIn, 3);
+        aOut[30] = (flags & 0x80) ? 1 : 0;
+        memcpy(aOut + 31, aIn + 4, 4);
+        pos = 8;
+
+        for (int os = 0; os < 3; os++)
+        {
+            uint8_t *section = aOut + 3 + os * 9;
+            BOOL shared = (flags & 0x08) != 0;
+
+            if (shared && os > 0)
+            {
+                memcpy(section, aOut + 3, 9);
+            }
+            else if (shared || (flags & (1 << os)))
+            {
+                NSUInteger used = PTReadSection(aIn + pos, aLen - pos, section);
+                if (used == 0) return 0;
+                pos += used;
+            }
+            // 沒帶 = None，上面 memset 過已經是 0
+        }
+        return (pos == aLen) ? PT_KEYMAP_DATA_LEN : 0;
+    }
+
+    if (aId == PT_ID_MACRO && aCmd == 0x05)
+    {
+        // PacketIndex, Count, slot × Count
+        if (aLen < 3 || aIn[2] > PT_MAX_SLOTS) return 0;
+
+        memset(aOut, 0, PT_MACRO_DATA_LEN);
+        memcpy(aOut, aIn, 3);
+        pos = 3;
+
+        for (NSUInteger i = 0; i < aIn[2]; i++)
+        {
+            uint8_t *slot = aOut + 3 + i * PT_SLOT_LEN;
+            if (pos >= aLen) return 0;
+            NSUInteger delayLen = (aIn[pos] & 0x80) ? 4 : 2;
+
+            NSUInteger used = PTReadSection(aIn + pos, aLen - pos, slot);
+            if (used == 0 || pos + used + delayLen > aLen) return 0;
+            pos += used;
+
+            memcpy(slot + 9, aIn + pos, delayLen);
+            pos += delayLen;
+        }
+        return (pos == aLen) ? PT_MACRO_DATA_LEN : 0;
+    }
+
+    if (aId == PT_ID_MACRO && aCmd == 0x04)
+    {
+        // KeyIndex, Mode, 名稱
+        if (aLen < 2 || aLen > PT_TRIGGER_DATA_LEN) return 0;
+
+        memset(aOut, 0, PT_TRIGGER_DATA_LEN);
+        memcpy(aOut, aIn, aLen);
+        return PT_TRIGGER_DATA_LEN;
+    }
+
+    return 0;
+}
+
+
+@interface PTFirmwareEmulator()
+{
+    BOOL _keySet[256];
+    uint8_t _keys[256][PT_KEYMAP_DATA_LEN];
+
+    // 寫巨集中：內容封包依 PacketIndex 累積，收到觸發鍵 + 完成通知才存
+    NSMutableData *_pendingSteps;
+    uint16_t _expectedPacket;
+    uint8_t _pendingTrigger[PT_TRIGGER_DATA_LEN];
+    BOOL _hasTrigger;
+
+    // keyIndex → 觸發鍵設定 + 步驟
+    NSMutableDictionary<NSNumber *, NSData *> *_macros;
+}
+
+@end
+
+
+@implementation PTFirmwareEmulator
+
+- (instancetype)initWithCapabilities:(DeviceCapability)aCapabilities
+{
+    self = [super init];
+    if (self)
+    {
+        _capabilities = aCapabilities;
+        _pendingSteps = [NSMutableData data];
+        _expectedPacket = 1;
+        _macros = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (nullable NSData *)receiveFrame:(NSData *)aFrame
+{
+    const uint8_t *b = [aFrame bytes];
+    NSUInteger n = [aFrame length];
+    if (n < 6 || n != 4 + (NSUInteger)b[3] + 2 || b[n - 2] != 0x01 || b[n - 1] != 0x0F)
+    {
+        _rejectedFrames++;
+        return nil;
+    }
+
+    uint8_t hdr = b[0], ids = b[1], cmd = b[2];
+    const uint8_t *data = b + 4;
+    NSUInteger len = b[3];
+
+    // 功能查詢：舊韌體不認得 ID 0x06，不回覆
+    if (hdr == PT_HEADER_READ && ids == PT_ID_DEVICE_INFO && cmd == 0x01)
+    {
+        if (_capabilities == DeviceCapabilityNone) return nil;
+
+        uint8_t rsp[7] = { PT_HEADER_RESPONSE, PT_ID_DEVICE_INFO, 0x02, 0x01, (uint8_t)_capabilities, 0x01, 0x0F };
+        return [NSData dataWithBytes:rsp length:sizeof(rsp)];
+    }
+    if (hdr == PT_HEADER_READ) return nil;
+
+    uint8_t expanded[PT_MACRO_DATA_LEN];
+    if (hdr == PT_HEADER_WRITE_COMPACT)
+    {
+        if (!(_capabilities & DeviceCapabilityCompactFraming))
+        {
+            _rejectedFrames++;
+            return nil;
+        }
+
+        len = PTExpandCompact(ids, cmd, data, len, expanded);
+        if (len == 0)
+        {
+            _rejectedFrames++;
+            return nil;
+        }
+        data = expanded;
+    }
+    else if (hdr != PT_HEADER_WRITE)
+    {
+        _rejectedFrames++;
+        return nil;
+    }
+
+    [self p_applyWriteWithId:ids command:cmd data:data length:len];
+    return nil;
+}
+
+- (void)p_applyWriteWithId:(uint8_t)aId command:(uint8_t)aCmd data:(const uint8_t *)aData length:(NSUInteger)aLen
+{
+    if (aId == PT_ID_KEY_SETTING && aCmd == 0x01 && aLen >= 1)
+    {
+        uint8_t key = aData[0];
+        memset(_keys[key], 0, PT_KEYMAP_DATA_LEN);
+        memcpy(_keys[key], aData, MIN(aLen, (NSUInteger)PT_KEYMAP_DATA_LEN));
+        _keySet[key] = YES;
+        return;
+    }
+
+    if (aId == PT_ID_MACRO && aCmd == 0x05 && aLen >= 3)
+    {
+        uint16_t packet = (uint16_t)(aData[0] | (aData[1] << 8));
+        if (packet == 1)
+        {
+            [_pendingSteps setLength:0];
+            _expectedPacket = 1;
+            _hasTrigger = NO;
+        }
+        if (packet != _expectedPacket)
+        {
+            _rejectedFrames++;
+            return;
+        }
+
+        NSUInteger count = MIN((NSUInteger)aData[2], (NSUInteger)PT_MAX_SLOTS);
+        if (3 + count * PT_SLOT_LEN > aLen)
+        {
+            _rejectedFrames++;
+            return;
+        }
+        [_pendingSteps appendBytes:aData + 3 length:count * PT_SLOT_LEN];
+        _expectedPacket++;
+        return;
+    }
+
+    if (aId == PT_ID_MACRO && aCmd == 0x04 && aLen >= PT_TRIGGER_DATA_LEN)
+    {
+        memcpy(_pendingTrigger, aData, PT_TRIGGER_DATA_LEN);
+        _hasTrigger = YES;
+        return;
+    }
+
+    if (aId == PT_ID_MACRO && aCmd == 0x06 && aLen >= 5)
+    {
+        uint32_t total = (uint32_t)aData[1] | ((uint32_t)aData[2] << 8) | ((uint32_t)aData[3] << 16) | ((uint32_t)aData[4] << 24);
+        if (!_hasTrigger || _pendingTrigger[0] != aData[0] || total * PT_SLOT_LEN != [_pendingSteps length])
+        {
+            _rejectedFrames++;
+            return;
+        }
+
+        NSMutableData *macro = [NSMutableData dataWithBytes:_pendingTrigger length:PT_TRIGGER_DATA_LEN];
+        [macro appendData:_pendingSteps];
+        _macros[@(aData[0])] = macro;
+
+        [_pendingSteps setLength:0];
+        _expectedPacket = 1;
+        _hasTrigger = NO;
+        return;
+    }
+
+    // 螢幕校正等其他寫入：這裡不需要保存
+}
+
+- (NSData *)stateDigest
+{
+    NSMutableData *d = [NSMutableData data];
+    for (NSUInteger key = 0; key < 256; key++)
+    {
+        if (!_keySet[key]) continue;
+        [d appendBytes:_keys[key] length:PT_KEYMAP_DATA_LEN];
+    }
+
+    for (NSNumber *key in [[_macros allKeys] sortedArrayUsingSelector:@selector(compare:)])
+    {
+        [d appendData:_macros[key]];
+    }
+    return d;
+}
+
+@end
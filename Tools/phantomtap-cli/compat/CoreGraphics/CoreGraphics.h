@@ -0,0 +1,39 @@
+//
+//  CoreGraphics.h (GNUstep compat)
+//  phantomtap-cli
+//
+//  Created by ethanlin on 2025/12/24.
+//
+//  Linux 上沒有 CoreGraphics；共用的 Models 只用到 CGFloat / CGPoint / CGSize 與
+//  CGPointMake / CGSizeMake / CGSizeZero。
+//
+//  CGFloat 一定由 Foundation 提供 (GNUstep 的 NSPoint / NSSize 欄位就宣告成 CGFloat)，
+//  CGPoint / CGSize 是否存在要看版本與有沒有裝 Opal，不能假設。
+//  這裡一律把 CG 名稱轉到 NSPoint / NSSize：兩者欄位與 layout 相同，
+//  就算系統已 typedef 過 CGPoint，macro 也只是讓後面的程式改用 NSPoint，不會重複定義
+//
+
+#ifndef PT_COMPAT_COREGRAPHICS_H
+#define PT_COMPAT_COREGRAPHICS_H
+
+#import <Foundation/Foundation.h>
+
+#undef CGPoint
+#define CGPoint NSPoint
+
+#undef CGSize
+#define CGSize NSSize
+
+#undef CGPointMake
+#define CGPointMake(x, y) NSMakePoint((x), (y))
+
+#undef CGSizeMake
+#define CGSizeMake(w, h) NSMakeSize((w), (h))
+
+#undef CGPointZero
+#define CGPointZero NSZeroPoint
+
+#undef CGSizeZero
+#define CGSizeZero NSZeroSize
+
+#endif
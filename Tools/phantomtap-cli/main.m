@@ -0,0 +1,660 @@
+//
+//  main.m
+//  phantomtap-cli
+//
+//  Created by ethanlin on 2025/12/24.
+//
+//  phantomtap validate [-j N] <profile.json | dir> ...
+//      平行檢查設定檔：空鍵 / 重複標籤 → 查不到 keyIndex (規則與順序同 App 的寫入)
+//
+//  phantomtap compile [--screen WxH] [-j N] [-o out] <profile.json> ...
+//      設定檔 → App 會送出的封包流 (一行一個 frame，大寫 hex)
+//      單一檔案且沒有 -o 時輸出到 stdout；多個檔案時 -o 為輸出資料夾 (<name>.frames)
+//
+//  phantomtap decode [--screen WxH] [--raw] [-o out.json] <dump>
+//      錄下來的封包流 → 設定檔 JSON
+//      dump 預設為 hex 文字：一行一段封包 (可以是多個 frame 接在一起)，同一行可用空白分組，
+//      每組可帶 "0x" 前綴，整行可包在 "<...>" 裡 (NSData 的 description)；空行與 "#" 開頭的行略過
+//      --raw：dump 是原始 binary，不做任何解析
+//
+//  phantomtap measure [--screen WxH] [-j N] <profile.json | dir> ...
+//      每份設定檔分別寫進舊韌體 (固定長度) 與支援變長封包的韌體模擬器，
+//      確認兩邊存下的內容相同，並統計兩種格式實際送出的 bytes (每份設定檔 / 每個巨集)
+//
+
+#import <Foundation/Foundation.h>
+#import "KeymapModels.h"
+#import "KeymapProfileCompiler.h"
+#import "BluetoothPacketParser.h"
+#import "BluetoothPacketBuilder.h"
+#import "PTFirmwareEmulator.h"
+
+static const NSInteger kExitOK = 0;
+static const NSInteger kExitFailed = 1;
+static const NSInteger kExitUsage = 2;
+
+
+#pragma mark - Helpers
+
+static void PTPrint(FILE *aFile, NSString *aFormat, ...) NS_FORMAT_FUNCTION(2, 3);
+static void PTPrint(FILE *aFile, NSString *aFormat, ...)
+{
+    va_list args;
+    va_start(args, aFormat);
+    NSString *s = [[NSString alloc] initWithFormat:aFormat arguments:args];
+    va_end(args);
+    fputs([s UTF8String], aFile);
+    fputc('\n', aFile);
+}
+
+static int PTUsage(void)
+{
+    PTPrint(stderr, @"usage:");
+    PTPrint(stderr, @"  phantomtap validate [-j N] <profile.json | dir> ...");
+    PTPrint(stderr, @"  phantomtap compile [--screen WxH] [-j N] [-o out] <profile.json> ...");
+    PTPrint(stderr, @"  phantomtap decode [--screen WxH] [--raw] [-o out.json] <dump>");
+    PTPrint(stderr, @"  phantomtap measure [--screen WxH] [-j N] <profile.json | dir> ...");
+    return (int)kExitUsage;
+}
+
+static double PTNowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static NSError *PTMakeError(NSString *aFormat, ...) NS_FORMAT_FUNCTION(1, 2);
+static NSError *PTMakeError(NSString *aFormat, ...)
+{
+    va_list args;
+    va_start(args, aFormat);
+    NSString *s = [[NSString alloc] initWithFormat:aFormat arguments:args];
+    va_end(args);
+    return [NSError errorWithDomain:@"phantomtap" code:1 userInfo:@{ NSLocalizedDescriptionKey: s }];
+}
+
+static NSString *PTHexString(NSData *aData)
+{
+    const uint8_t *b = [aData bytes];
+    NSMutableString *s = [NSMutableString stringWithCapacity:[aData length] * 2];
+    for (NSUInteger i = 0; i < [aData length]; i++)
+    {
+        [s appendFormat:@"%02X", b[i]];
+    }
+    return s;
+}
+
+/// 檔案與資料夾 (遞迴找 *.json) 展開成檔案清單
+static NSArray<NSString *> *PTExpandPaths(NSArray<NSString *> *aPaths)
+{
+    NSFileManager *fm = [NSFileManager defaultManager];
+    NSMutableArray<NSString *> *files = [NSMutableArray array];
+    for (NSString *path in aPaths)
+    {
+        BOOL isDir = NO;
+        if (![fm fileExistsAtPath:path isDirectory:&isDir])
+        {
+            [files addObject:path];     // 讓後面回報讀檔失敗
+            continue;
+        }
+        if (!isDir)
+        {
+            [files addObject:path];
+            continue;
+        }
+
+        NSMutableArray<NSString *> *found = [NSMutableArray array];
+        for (NSString *rel in [fm enumeratorAtPath:path])
+        {
+            if ([[[rel pathExtension] lowercaseString] isEqualToString:@"json"])
+            {
+                [found addObject:[path stringByAppendingPathComponent:rel]];
+            }
+        }
+        [files addObjectsFromArray:[found sortedArrayUsingSelector:@selector(compare:)]];
+    }
+    return files;
+}
+
+static KeymapFile *PTLoadProfile(NSString *aPath, NSError **aError)
+{
+    NSData *json = [NSData dataWithContentsOfFile:aPath options:0 error:aError];
+    if (!json) return nil;
+    return [KeymapFile fromJSON:json error:aError];
+}
+
+/// "1179x2556" → W / H；格式錯誤回傳 NO
+static BOOL PTParseScreen(NSString *aValue, NSInteger *aOutW, NSInteger *aOutH)
+{
+    NSArray<NSString *> *parts = [[aValue lowercaseString] componentsSeparatedByString:@"x"];
+    if ([parts count] != 2) return NO;
+    *aOutW = [parts[0] integerValue];
+    *aOutH = [parts[1] integerValue];
+    return (*aOutW > 0 && *aOutH > 0);
+}
+
+/// 對 aCount 個工作平行執行，最多 aJobs 條同時跑 (0 = 依 CPU 數)
+static void PTParallelFor(NSUInteger aCount, NSUInteger aJobs, void (^aBlock)(NSUInteger aIndex))
+{
+    if (aCount == 0) return;
+
+    NSUInteger jobs = (aJobs > 0) ? aJobs : (NSUInteger)[[NSProcessInfo processInfo] activeProcessorCount];
+    jobs = MAX((NSUInteger)1, MIN(jobs, aCount));
+
+    // 每條 worker 依序領下一個 index，避免大小不一的檔案卡在同一條
+    __block volatile int64_t next = 0;
+    dispatch_apply(jobs, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t aWorker) {
+        for (;;)
+        {
+            NSUInteger i = (NSUInteger)__sync_fetch_and_add(&next, 1);
+            if (i >= aCount) break;
+            @autoreleasepool
+            {
+                aBlock(i);
+            }
+        }
+    });
+}
+
+
+#pragma mark - Options
+
+typedef struct
+{
+    NSUInteger jobs;
+    NSInteger screenW;
+    NSInteger screenH;
+    BOOL raw;               // decode：dump 為 raw binary
+} PTOptions;
+
+/// 解析共用選項，剩下的參數放進 aOutArgs；格式錯誤回傳 NO
+static BOOL PTParseOptions(NSArray<NSString *> *aArgs, PTOptions *aOpt, NSString **aOutOutput, NSMutableArray<NSString *> *aOutArgs)
+{
+    for (NSUInteger i = 0; i < [aArgs count]; i++)
+    {
+        NSString *a = aArgs[i];
+        BOOL hasValue = (i + 1 < [aArgs count]);
+
+        if ([a isEqualToString:@"-j"] && hasValue)
+        {
+            aOpt -> jobs = (NSUInteger)MAX(0, [aArgs[++i] integerValue]);
+        }
+        else if ([a isEqualToString:@"--screen"] && hasValue)
+        {
+            if (!PTParseScreen(aArgs[++i], &aOpt -> screenW, &aOpt -> screenH))
+            {
+                PTPrint(stderr, @"invalid --screen value: %@", aArgs[i]);
+                return NO;
+            }
+        }
+        else if ([a isEqualToString:@"--raw"])
+        {
+            aOpt -> raw = YES;
+        }
+        else if ([a isEqualToString:@"-o"] && hasValue)
+        {
+            *aOutOutput = aArgs[++i];
+        }
+        else if ([a hasPrefix:@"-"] && [a length] > 1)
+        {
+            PTPrint(stderr, @"unknown option: %@", a);
+            return NO;
+        }
+        else
+        {
+            [aOutArgs addObject:a];
+        }
+    }
+    return YES;
+}
+
+
+#pragma mark - validate
+
+static int PTCommandValidate(NSArray<NSString *> *aArgs)
+{
+    PTOptions opt = { 0, 0, 0, NO };
+    NSString *output = nil;
+    NSMutableArray<NSString *> *paths = [NSMutableArray array];
+    if (!PTParseOptions(aArgs, &opt, &output, paths) || [paths count] == 0) return PTUsage();
+
+    NSArray<NSString *> *files = PTExpandPaths(paths);
+    NSUInteger n = [files count];
+
+    // 每個 worker 只寫自己的 slot，最後依原順序輸出
+    NSMutableArray *lines = [NSMutableArray arrayWithCapacity:n];
+    for (NSUInteger i = 0; i < n; i++) [lines addObject:[NSNull null]];
+    __block volatile int64_t failed = 0;
+
+    double t0 = PTNowMs();
+    PTParallelFor(n, opt.jobs, ^(NSUInteger aIndex) {
+        NSString *path = files[aIndex];
+        NSError *err = nil;
+        KeymapFile *file = PTLoadProfile(path, &err);
+
+        NSString *line = nil;
+        if (file && [KeymapProfileCompiler validateFile:file error:&err])
+        {
+            line = [NSString stringWithFormat:@"OK   %@ (%lu actions)", path, (unsigned long)[[file actions] count]];
+        }
+        else
+        {
+            __sync_fetch_and_add(&failed, 1);
+            line = [NSString stringWithFormat:@"FAIL %@: %@", path, [err localizedDescription] ?: @"invalid profile"];
+        }
+
+        @synchronized (lines)
+        {
+            lines[aIndex] = line;
+        }
+    });
+    double ms = PTNowMs() - t0;
+
+    for (NSString *line in lines) PTPrint(stdout, @"%@", line);
+    PTPrint(stderr, @"checked %lu profiles: %lu ok, %lld failed (%.1f ms)", (unsigned long)n, (unsigned long)(n - (NSUInteger)failed), (long long)failed, ms);
+
+    return (failed > 0) ? (int)kExitFailed : (int)kExitOK;
+}
+
+
+#pragma mark - compile
+
+static int PTCommandCompile(NSArray<NSString *> *aArgs)
+{
+    PTOptions opt = { 0, 0, 0, NO };
+    NSString *output = nil;
+    NSMutableArray<NSString *> *paths = [NSMutableArray array];
+    if (!PTParseOptions(aArgs, &opt, &output, paths) || [paths count] == 0) return PTUsage();
+
+    NSArray<NSString *> *files = PTExpandPaths(paths);
+    BOOL toStdout = ([files count] == 1 && !output);
+    if (!toStdout && !output)
+    {
+        PTPrint(stderr, @"compile: -o <dir> is required for multiple profiles");
+        return PTUsage();
+    }
+    if (!toStdout && [files count] > 1)
+    {
+        [[NSFileManager defaultManager] createDirectoryAtPath:output withIntermediateDirectories:YES attributes:nil error:nil];
+    }
+
+    __block volatile int64_t failed = 0;
+    __block volatile int64_t totalFrames = 0;
+    __block volatile int64_t totalBytes = 0;
+
+    double t0 = PTNowMs();
+    PTParallelFor([files count], opt.jobs, ^(NSUInteger aIndex) {
+        NSString *path = files[aIndex];
+        NSError *err = nil;
+        KeymapFile *file = PTLoadProfile(path, &err);
+        NSArray<NSData *> *frames = file ? [KeymapProfileCompiler compileFile:file screenW:opt.screenW screenH:opt.screenH error:&err] : nil;
+        if (!frames)
+        {
+            __sync_fetch_and_add(&failed, 1);
+            PTPrint(stderr, @"FAIL %@: %@", path, [err localizedDescription] ?: @"invalid profile");
+            return;
+        }
+
+        NSMutableString *text = [NSMutableString string];
+        int64_t bytes = 0;
+        for (NSData *f in frames)
+        {
+            [text appendString:PTHexString(f)];
+            [text appendString:@"\n"];
+            bytes += (int64_t)[f length];
+        }
+
+        if (toStdout)
+        {
+            fputs([text UTF8String], stdout);
+            __sync_fetch_and_add(&totalFrames, (int64_t)[frames count]);
+            __sync_fetch_and_add(&totalBytes, bytes);
+            return;
+        }
+
+        NSString *dest = output;
+        if ([files count] > 1)
+        {
+            NSString *name = [[[path lastPathComponent] stringByDeletingPathExtension] stringByAppendingPathExtension:@"frames"];
+            dest = [output stringByAppendingPathComponent:name];
+        }
+        if (![text writeToFile:dest atomically:YES encoding:NSUTF8StringEncoding error:&err])
+        {
+            __sync_fetch_and_add(&failed, 1);
+            PTPrint(stderr, @"FAIL %@: %@", dest, [err localizedDescription]);
+            return;
+        }
+        __sync_fetch_and_add(&totalFrames, (int64_t)[frames count]);
+        __sync_fetch_and_add(&totalBytes, bytes);
+    });
+    double ms = PTNowMs() - t0;
+
+    PTPrint(stderr, @"compiled %lu profiles: %lld frames, %lld bytes, %lld failed (%.1f ms)", (unsigned long)[files count], (long long)totalFrames, (long long)totalBytes, (long long)failed, ms);
+
+    return (failed > 0) ? (int)kExitFailed : (int)kExitOK;
+}
+
+
+#pragma mark - decode
+
+/// dump 檔 → 位元組流 (格式見檔頭 decode 的說明)；aRaw 時原樣回傳
+/// 文字格式不猜：任何一行有 hex 以外的內容就整個失敗，並指出第幾行
+static NSData *PTReadDump(NSString *aPath, BOOL aRaw, NSError **aError)
+{
+    NSData *raw = [NSData dataWithContentsOfFile:aPath options:0 error:aError];
+    if (!raw || aRaw) return raw;
+
+    NSString *text = [[NSString alloc] initWithData:raw encoding:NSUTF8StringEncoding];
+    if (!text)
+    {
+        if (aError) *aError = PTMakeError(@"not a hex text dump (use --raw for binary captures)");
+        return nil;
+    }
+
+    NSCharacterSet *space = [NSCharacterSet whitespaceCharacterSet];
+    NSCharacterSet *nonHex = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdefABCDEF"] invertedSet];
+    NSMutableData *stream = [NSMutableData data];
+
+    NSArray<NSString *> *lines = [text componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]];
+    for (NSUInteger lineNo = 0; lineNo < [lines count]; lineNo++)
+    {
+        NSString *line = [lines[lineNo] stringByTrimmingCharactersInSet:space];
+        if ([line length] == 0 || [line hasPrefix:@"#"]) continue;
+
+        if ([line hasPrefix:@"<"] && [line hasSuffix:@">"] && [line length] >= 2)
+        {
+            line = [line substringWithRange:NSMakeRange(1, [line length] - 2)];
+        }
+
+        NSMutableString *hex = [NSMutableString stringWithCapacity:[line length]];
+        for (NSString *group in [line componentsSeparatedByCharactersInSet:space])
+        {
+            if ([group hasPrefix:@"0x"] || [group hasPrefix:@"0X"])
+            {
+                [hex appendString:[group substringFromIndex:2]];
+            }
+            else
+            {
+                [hex appendString:group];
+            }
+        }
+
+        if ([hex length] == 0 || ([hex length] % 2) != 0 || [hex rangeOfCharacterFromSet:nonHex].location != NSNotFound)
+        {
+            if (aError) *aError = PTMakeError(@"line %lu is not a hex frame: %@", (unsigned long)(lineNo + 1), lines[lineNo]);
+            return nil;
+        }
+
+        const char *c = [hex UTF8String];
+        for (NSUInteger i = 0; i < [hex length]; i += 2)
+        {
+            char pair[3] = { c[i], c[i + 1], 0 };
+            uint8_t byte = (uint8_t)strtoul(pair, NULL, 16);
+            [stream appendBytes:&byte length:1];
+        }
+    }
+
+    return stream;
+}
+
+static int PTCommandDecode(NSArray<NSString *> *aArgs)
+{
+    PTOptions opt = { 0, 0, 0, NO };
+    NSString *output = nil;
+    NSMutableArray<NSString *> *paths = [NSMutableArray array];
+    if (!PTParseOptions(aArgs, &opt, &output, paths) || [paths count] != 1) return PTUsage();
+
+    NSError *err = nil;
+    NSData *stream = PTReadDump(paths[0], opt.raw, &err);
+    if (!stream)
+    {
+        PTPrint(stderr, @"FAIL %@: %@", paths[0], [err localizedDescription]);
+        return (int)kExitFailed;
+    }
+
+    NSUInteger consumed = 0;
+    NSArray<NSData *> *frames = [BluetoothPacketParser splitFrames:stream consumed:&consumed];
+    if (consumed < [stream length])
+    {
+        PTPrint(stderr, @"warning: %lu trailing bytes at offset %lu could not be framed", (unsigned long)([stream length] - consumed), (unsigned long)consumed);
+    }
+
+    NSInteger W = (opt.screenW > 0) ? opt.screenW : 1080;
+    NSInteger H = (opt.screenH > 0) ? opt.screenH : 1920;
+    NSString *nickname = [[paths[0] lastPathComponent] stringByDeletingPathExtension];
+
+    KeymapFile *file = [KeymapProfileCompiler decodeFrames:frames screenW:W screenH:H nickname:nickname error:&err];
+    NSData *json = file ? [file toJSONPretty:YES error:&err] : nil;
+    if (!json)
+    {
+        PTPrint(stderr, @"FAIL %@: %@", paths[0], [err localizedDescription] ?: @"decode failed");
+        return (int)kExitFailed;
+    }
+
+    if (output)
+    {
+        if (![json writeToFile:output options:NSDataWritingAtomic error:&err])
+        {
+            PTPrint(stderr, @"FAIL %@: %@", output, [err localizedDescription]);
+            return (int)kExitFailed;
+        }
+    }
+    else
+    {
+        fwrite([json bytes], 1, [json length], stdout);
+        fputc('\n', stdout);
+    }
+
+    PTPrint(stderr, @"decoded %lu frames into %lu actions", (unsigned long)[frames count], (unsigned long)[[file actions] count]);
+    return (int)kExitOK;
+}
+
+
+#pragma mark - measure
+
+typedef NS_ENUM(NSUInteger, PTFrameKind)
+{
+    PTFrameKindKeyMapping = 0,      // ID 0x03 / CMD 0x01
+    PTFrameKindMacroContent,        // ID 0x02 / CMD 0x05
+    PTFrameKindMacroTrigger,        // ID 0x02 / CMD 0x04
+    PTFrameKindMacroNotify,         // ID 0x02 / CMD 0x06
+    PTFrameKindOther,
+    PTFrameKindCount,
+};
+
+static NSString * const kPTFrameKindNames[PTFrameKindCount] = { @"key mapping", @"macro content", @"macro trigger", @"macro notify", @"other" };
+
+static PTFrameKind PTKindOfFrame(NSData *aFrame)
+{
+    if ([aFrame length] < 3) return PTFrameKindOther;
+
+    const uint8_t *b = [aFrame bytes];
+    if (b[1] == 0x03 && b[2] == 0x01) return PTFrameKindKeyMapping;
+    if (b[1] == 0x02 && b[2] == 0x05) return PTFrameKindMacroContent;
+    if (b[1] == 0x02 && b[2] == 0x04) return PTFrameKindMacroTrigger;
+    if (b[1] == 0x02 && b[2] == 0x06) return PTFrameKindMacroNotify;
+    return PTFrameKindOther;
+}
+
+typedef struct
+{
+    volatile int64_t frames[PTFrameKindCount];
+    volatile int64_t fixedBytes[PTFrameKindCount];
+    volatile int64_t wireBytes[PTFrameKindCount];
+    volatile int64_t profiles;
+} PTMeasureTotals;
+
+/// 和 BTManager 連線時一樣送功能查詢；有回覆且支援變長封包才回傳 YES
+static BOOL PTNegotiateCompact(PTFirmwareEmulator *aFirmware)
+{
+    NSData *rsp = [aFirmware receiveFrame:[BluetoothPacketBuilder buildCapabilityQueryPacket]];
+    NSNumber *caps = rsp ? [BluetoothPacketParser parseCapabilities:rsp] : nil;
+
+    DeviceCapability agreed = (DeviceCapability)[caps unsignedCharValue] & [BluetoothPacketBuilder supportedCapabilities];
+    return (agreed & DeviceCapabilityCompactFraming) != 0;
+}
+
+static double PTSavedPercent(int64_t aFixed, int64_t aWire)
+{
+    return (aFixed > 0) ? 100.0 * (1.0 - (double)aWire / (double)aFixed) : 0.0;
+}
+
+/// 寫進兩台模擬器並比對；失敗時回傳原因
+/// 統計先記在自己這份，整份設定檔都通過才加進 aTotals (失敗的設定檔不算進總數)
+static NSString *PTMeasureProfile(NSArray<NSData *> *aFrames, PTMeasureTotals *aTotals, int64_t *aOutFixed, int64_t *aOutWire)
+{
+    PTFirmwareEmulator *legacy = [[PTFirmwareEmulator alloc] initWithCapabilities:DeviceCapabilityNone];
+    PTFirmwareEmulator *current = [[PTFirmwareEmulator alloc] initWithCapabilities:DeviceCapabilityCompactFraming];
+
+    if (PTNegotiateCompact(legacy)) return @"legacy firmware negotiated compact framing";
+    if (!PTNegotiateCompact(current)) return @"compact framing was not negotiated";
+
+    int64_t frames[PTFrameKindCount] = { 0 };
+    int64_t fixedBytes[PTFrameKindCount] = { 0 };
+    int64_t wireBytes[PTFrameKindCount] = { 0 };
+    int64_t fixedTotal = 0, wireTotal = 0;
+    for (NSData *fixed in aFrames)
+    {
+        NSData *wire = [BluetoothPacketBuilder compactFrameFromFrame:fixed];
+        if (![[BluetoothPacketParser expandCompactFrame:wire] isEqualToData:fixed])
+        {
+            return [NSString stringWithFormat:@"frame %@ does not round-trip", PTHexString(fixed)];
+        }
+
+        [legacy receiveFrame:fixed];
+        [current receiveFrame:wire];
+
+        PTFrameKind kind = PTKindOfFrame(fixed);
+        frames[kind]++;
+        fixedBytes[kind] += (int64_t)[fixed length];
+        wireBytes[kind] += (int64_t)[wire length];
+        fixedTotal += (int64_t)[fixed length];
+        wireTotal += (int64_t)[wire length];
+    }
+
+    if ([legacy rejectedFrames] > 0 || [current rejectedFrames] > 0)
+    {
+        return [NSString stringWithFormat:@"firmware rejected frames (fixed %lu, compact %lu)", (unsigned long)[legacy rejectedFrames], (unsigned long)[current rejectedFrames]];
+    }
+    if (![[legacy stateDigest] isEqualToData:[current stateDigest]])
+    {
+        return @"firmware state differs between fixed and compact framing";
+    }
+
+    for (NSUInteger k = 0; k < PTFrameKindCount; k++)
+    {
+        __sync_fetch_and_add(&aTotals -> frames[k], frames[k]);
+        __sync_fetch_and_add(&aTotals -> fixedBytes[k], fixedBytes[k]);
+        __sync_fetch_and_add(&aTotals -> wireBytes[k], wireBytes[k]);
+    }
+    __sync_fetch_and_add(&aTotals -> profiles, 1);
+    *aOutFixed = fixedTotal;
+    *aOutWire = wireTotal;
+    return nil;
+}
+
+static int PTCommandMeasure(NSArray<NSString *> *aArgs)
+{
+    PTOptions opt = { 0, 0, 0, NO };
+    NSString *output = nil;
+    NSMutableArray<NSString *> *paths = [NSMutableArray array];
+    if (!PTParseOptions(aArgs, &opt, &output, paths) || [paths count] == 0) return PTUsage();
+
+    NSArray<NSString *> *files = PTExpandPaths(paths);
+    NSUInteger n = [files count];
+
+    NSMutableArray *lines = [NSMutableArray arrayWithCapacity:n];
+    for (NSUInteger i = 0; i < n; i++) [lines addObject:[NSNull null]];
+    __block volatile int64_t failed = 0;
+
+    PTMeasureTotals totals;
+    memset(&totals, 0, sizeof(totals));
+    PTMeasureTotals *t = &totals;
+
+    double t0 = PTNowMs();
+    PTParallelFor(n, opt.jobs, ^(NSUInteger aIndex) {
+        NSString *path = files[aIndex];
+        NSError *err = nil;
+        KeymapFile *file = PTLoadProfile(path, &err);
+        NSArray<NSData *> *frames = file ? [KeymapProfileCompiler compileFile:file screenW:opt.screenW screenH:opt.screenH error:&err] : nil;
+
+        int64_t fixed = 0, wire = 0;
+        NSString *reason = frames ? PTMeasureProfile(frames, t, &fixed, &wire) : ([err localizedDescription] ?: @"invalid profile");
+
+        NSString *line = nil;
+        if (reason)
+        {
+            __sync_fetch_and_add(&failed, 1);
+            line = [NSString stringWithFormat:@"FAIL %@: %@", path, reason];
+        }
+        else
+        {
+            line = [NSString stringWithFormat:@"OK   %@: %lu frames, %lld -> %lld bytes (-%.1f%%)", path, (unsigned long)[frames count], (long long)fixed, (long long)wire, PTSavedPercent(fixed, wire)];
+        }
+
+        @synchronized (lines)
+        {
+            lines[aIndex] = line;
+        }
+    });
+    double ms = PTNowMs() - t0;
+
+    for (NSString *line in lines) PTPrint(stdout, @"%@", line);
+
+    PTPrint(stdout, @"");
+    PTPrint(stdout, @"%-14s %8s %12s %12s %8s", "frame", "count", "fixed B", "compact B", "saved");
+    int64_t allFixed = 0, allWire = 0;
+    for (NSUInteger k = 0; k < PTFrameKindCount; k++)
+    {
+        if (totals.frames[k] == 0) continue;
+
+        PTPrint(stdout, @"%-14s %8lld %12lld %12lld %7.1f%%", [kPTFrameKindNames[k] UTF8String], (long long)totals.frames[k], (long long)totals.fixedBytes[k], (long long)totals.wireBytes[k], PTSavedPercent(totals.fixedBytes[k], totals.wireBytes[k]));
+        allFixed += totals.fixedBytes[k];
+        allWire += totals.wireBytes[k];
+    }
+
+    // 一個巨集 = 內容封包 + 觸發鍵 + 完成通知
+    int64_t macros = totals.frames[PTFrameKindMacroNotify];
+    int64_t macroFixed = totals.fixedBytes[PTFrameKindMacroContent] + totals.fixedBytes[PTFrameKindMacroTrigger] + totals.fixedBytes[PTFrameKindMacroNotify];
+    int64_t macroWire = totals.wireBytes[PTFrameKindMacroContent] + totals.wireBytes[PTFrameKindMacroTrigger] + totals.wireBytes[PTFrameKindMacroNotify];
+
+    PTPrint(stdout, @"");
+    if (totals.profiles > 0)
+    {
+        PTPrint(stdout, @"per profile: %.1f -> %.1f bytes (-%.1f%%)", (double)allFixed / (double)totals.profiles, (double)allWire / (double)totals.profiles, PTSavedPercent(allFixed, allWire));
+    }
+    if (macros > 0)
+    {
+        PTPrint(stdout, @"per macro:   %.1f -> %.1f bytes (-%.1f%%)", (double)macroFixed / (double)macros, (double)macroWire / (double)macros, PTSavedPercent(macroFixed, macroWire));
+    }
+
+    PTPrint(stderr, @"measured %lu profiles: %lld ok, %lld failed (%.1f ms)", (unsigned long)n, (long long)totals.profiles, (long long)failed, ms);
+
+    return (failed > 0) ? (int)kExitFailed : (int)kExitOK;
+}
+
+
+#pragma mark - main
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        if (argc < 2) return PTUsage();
+
+        NSMutableArray<NSString *> *args = [NSMutableArray arrayWithCapacity:(NSUInteger)argc];
+        for (int i = 2; i < argc; i++)
+        {
+            [args addObject:[NSString stringWithUTF8String:argv[i]]];
+        }
+
+        NSString *command = [NSString stringWithUTF8String:argv[1]];
+        if ([command isEqualToString:@"validate"]) return PTCommandValidate(args);
+        if ([command isEqualToString:@"compile"]) return PTCommandCompile(args);
+        if ([command isEqualToString:@"decode"]) return PTCommandDecode(args);
+        if ([command isEqualToString:@"measure"]) return PTCommandMeasure(args);
+
+        return PTUsage();
+    }
+}